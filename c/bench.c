@@ -0,0 +1,425 @@
+/*****
+*	File :	bench.c
+*	Note :	Micro-benchmarks of the hot paths of the synthesizer:
+*
+*		  vtt_sim	per output sample, for each combination of
+*				nasal_tract, wall and rad_boundary
+*		  vtt_bank	the same per output sample of each of the
+*				VB_LANES voices of a bank (vtt_bank.c)
+*		  lam + sagittal_to_area + appro_area_function
+*				per frame (FRAME_DUR)
+*		  codebook_lookup	per frame, simplex and multilinear, on
+*				a grid of CB_POINTS per parameter
+*		  decim		per output sample (deci inputs)
+*		  glottal_area	per output sample
+*
+*		Each figure is the best of NREP runs, in ns per output
+*		sample (or per frame) and as a realtime factor, i.e.,
+*		seconds of sound computed per second.  The tract follows
+*		an [i]-[u] transition, the shapes of which are computed
+*		before the timing.
+*
+*		Build and run, from this directory:
+*
+*		  cc -O2 -DSYNTHESIZE_NO_MAIN -o bench bench.c vtt_bank.c \
+*		     synthesize.c vtt_lib.c lam_lib.c vsyn_lib.c codebook.c \
+*		     -lm -lpthread
+*		  ./bench [seconds of sound per case (= 2)]
+*
+*		The bank is vectorized for the instruction set it is
+*		compiled for (e.g., add -march=native), see vtt_bank.h.
+*		The tubes of vtt_sim are laid out as arrays of structures,
+*		or as a structure of arrays if all the files are compiled
+*		with -DVTT_SOA (see vtt_lib.h); the layout is printed
+*		first, and the vtt_sim figures of two builds compare them:
+*
+*		  cc -O2 -DSYNTHESIZE_NO_MAIN -DVTT_SOA -o bench_soa ...
+*		  ./bench; ./bench_soa
+*****/
+
+#include	<time.h>
+#include	"always.h"
+#include	"synthesize.h"
+#include	"vtt_bank.h"
+
+#ifdef VTT_SOA
+#define	VTT_LAYOUT	"structure of arrays (VTT_SOA)"
+#else
+#define	VTT_LAYOUT	"arrays of structures"
+#endif
+
+#define	NREP	3		/* runs per case, the best is reported */
+#define	CB_POINTS	5	/* grid points per parameter of the codebook */
+
+extern	float	iy[7], uw[7];
+
+static	double	now ( void )
+{
+	struct timespec	t;
+
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return( t.tv_sec + 1e-9*t.tv_nsec );
+}
+
+static	void	report ( const char *name, double sec, long n, double dur )
+{
+	if( sec <= 0 )
+	{  printf( "%-46s failed\n", name );
+	   return;
+	}
+	printf( "%-46s %9.1f ns %9.1f x realtime\n", name, 1e9*sec/n, dur/sec );
+}
+
+/*****
+*	Function : frame_shapes
+*	Note :	Area functions (nss sections each) of nfrm frames going
+*		from [i] to [u] and back ([i] only if nfrm = 1).
+*****/
+
+static	area_function	*frame_shapes ( const vt_config *cf, int nfrm )
+{
+	area_function	*af, af0[NP];
+	vt_profile	prof;
+	float	p[AMnum], f;
+	short	ns0;
+	int	i, j;
+
+	af = (area_function *) calloc( (size_t)nfrm*cf->nss, sizeof(area_function) );
+	for( i=0; i<nfrm; i++)
+	{  f = nfrm > 1 ? (float)fabs( 1.0 - 2.0*i/(nfrm-1) ) : 1.f;
+	   for( j=0; j<AMnum; j++) p[j] = f*iy[j] + (1-f)*uw[j];
+	   ns0 = NP;
+	   lam_r( lam_default(), p, &prof );
+	   sagittal_to_area_r( lam_default(), &prof, &ns0, af0 );
+	   appro_area_function( ns0, af0, cf->nss, af + (size_t)i*cf->nss );
+	}
+	return( af );
+}
+
+/*****
+*	Function : glottal_track
+*	Note :	Glottal area of n samples at 120 Hz, computed before the
+*		timing of vtt_sim.
+*****/
+
+static	float	*glottal_track ( const vt_config *cf, long n )
+{
+	glottal_state	gs;
+	float	*ag;
+	short	t0 = 0, period = (short)(cf->smpfrq/120. + 0.5);
+	long	i;
+
+	memset( &gs, 0, sizeof(gs) );
+	ag = (float *) malloc( n*sizeof(float) );
+	for( i=0; i<n; i++)
+	{  if( i%period == 0 ) t0 = period;
+	   ag[i] = glottal_area_r( &gs, 'F', 'o', 0.2f, &t0 );
+	}
+	return( ag );
+}
+
+/*****
+*	Function : bench_vtt_sim
+*	Note :	vtt_sim_r over the whole track, the area function moving
+*		every frame.  Returns 0 if the simulator could not be
+*		initialized.
+*****/
+
+static	double	bench_vtt_sim ( const vt_config *cf0, const area_function *af,
+			const float *ag, long n, long frm )
+{
+	vtt_context	vt;
+	area_function	*afvt;
+	double	t, best = 1e30;
+	volatile float	sink = 0;
+	long	i;
+	int	r;
+
+	afvt = (area_function *) malloc( cf0->nss*sizeof(area_function) );
+	for( r=0; r<NREP; r++)
+	{  memset( &vt, 0, sizeof(vt) );
+	   vt.cf = *cf0;
+	   vt.cf.afvt = afvt;
+	   vt.cf.Ag = 0;
+	   memcpy( afvt, af, cf0->nss*sizeof(area_function) );
+	   if( vtt_ini_r( &vt ) < 0 )
+	   {  free( afvt );
+	      return( 0 );
+	   }
+
+	   t = now();
+	   for( i=0; i<n; i++)
+	   {  if( i%frm == 0 )
+		 memcpy( afvt, af + (i/frm)*cf0->nss, cf0->nss*sizeof(area_function) );
+	      vt.cf.Ag = ag[i];
+	      sink += vtt_sim_r( &vt );
+	   }
+	   t = now() - t;
+	   if( t < best ) best = t;
+	   vtt_term_r( &vt );
+	}
+	free( afvt );
+	return( best );
+}
+
+/*****
+*	Function : bench_bank
+*	Note :	vtt_bank_sim over the whole track, each of the VB_LANES
+*		voices a frame behind the previous one.  The time is that
+*		of all the voices.  Returns 0 if the bank could not be
+*		initialized.
+*****/
+
+static	double	bench_bank ( const vt_config *cf0, const area_function *af,
+			const float *ag, long n, long frm )
+{
+	vtt_bank	vb;
+	area_function	*afvt;
+	float	out[VB_LANES];
+	double	t, best = 1e30;
+	volatile float	sink = 0;
+	long	i, k, nfrm = n/frm + 1;
+	int	l, r;
+
+	afvt = (area_function *) malloc( (size_t)VB_LANES*cf0->nss*sizeof(area_function) );
+	for( r=0; r<NREP; r++)
+	{  memset( &vb, 0, sizeof(vb) );
+	   vb.cf = *cf0;
+	   for( l=0; l<VB_LANES; l++)
+	   {  vb.afvt[l] = afvt + (size_t)l*cf0->nss;
+	      memcpy( vb.afvt[l], af + (l%nfrm)*cf0->nss, cf0->nss*sizeof(area_function) );
+	      vb.Psub[l] = cf0->Psub;
+	      vb.anc[l] = cf0->anc;
+	   }
+	   if( vtt_bank_ini( &vb ) < 0 )
+	   {  free( afvt );
+	      return( 0 );
+	   }
+
+	   t = now();
+	   for( i=0; i<n; i++)
+	   {  if( i%frm == 0 )
+		 for( l=0; l<VB_LANES; l++)
+		 {  k = (i/frm + l)%nfrm;
+		    memcpy( vb.afvt[l], af + k*cf0->nss, cf0->nss*sizeof(area_function) );
+		 }
+	      for( l=0; l<VB_LANES; l++) vb.Ag[l] = ag[(i + l*frm)%n];
+	      vtt_bank_sim( &vb, out );
+	      sink += out[0];
+	   }
+	   t = now() - t;
+	   if( t < best ) best = t;
+	   vtt_bank_term( &vb );
+	}
+	free( afvt );
+	return( best );
+}
+
+/*****
+*	Function : bench_geometry
+*	Note :	lam_r, sagittal_to_area_r and appro_area_function for
+*		nfrm frames.
+*****/
+
+static	double	bench_geometry ( const vt_config *cf, int nfrm )
+{
+	const	lam_model	*md = lam_default();
+	area_function	af0[NP], *afvt;
+	vt_profile	prof;
+	float	p[AMnum], f;
+	double	t, best = 1e30;
+	short	ns0;
+	int	i, j, r;
+
+	afvt = (area_function *) malloc( cf->nss*sizeof(area_function) );
+	for( r=0; r<NREP; r++)
+	{  t = now();
+	   for( i=0; i<nfrm; i++)
+	   {  f = (float)(i%100)/99.f;
+	      for( j=0; j<AMnum; j++) p[j] = f*iy[j] + (1-f)*uw[j];
+	      ns0 = NP;
+	      lam_r( md, p, &prof );
+	      sagittal_to_area_r( md, &prof, &ns0, af0 );
+	      appro_area_function( ns0, af0, cf->nss, afvt );
+	   }
+	   t = now() - t;
+	   if( t < best ) best = t;
+	}
+	free( afvt );
+	return( best );
+}
+
+/*****
+*	Function : bench_codebook
+*	Note :	codebook_lookup (interp) for nfrm frames, the parameters
+*		of which are those of bench_geometry.
+*****/
+
+static	double	bench_codebook ( const vt_config *cf, int nfrm, short interp )
+{
+	af_codebook	cb;
+	area_function	*afvt;
+	short	n[CB_NPAR];
+	float	lo[CB_NPAR], hi[CB_NPAR], p[AMnum], f;
+	double	t, best = 1e30;
+	int	i, j, r;
+
+	for( j=0; j<CB_NPAR; j++)
+	{  n[j] = CB_POINTS;
+	   lo[j] = -3;
+	   hi[j] = 3;
+	}
+	if( codebook_build( &cb, lam_default(), cf->nph, cf->nbu, n, lo,
+			    hi ) ) return( 0 );
+	cb.interp = interp;
+	afvt = (area_function *) malloc( cf->nss*sizeof(area_function) );
+	for( r=0; r<NREP; r++)
+	{  t = now();
+	   for( i=0; i<nfrm; i++)
+	   {  f = (float)(i%100)/99.f;
+	      for( j=0; j<AMnum; j++) p[j] = f*iy[j] + (1-f)*uw[j];
+	      codebook_lookup( &cb, p, afvt );
+	   }
+	   t = now() - t;
+	   if( t < best ) best = t;
+	}
+	free( afvt );
+	codebook_term( &cb );
+	return( best );
+}
+
+/*****
+*	Function : bench_decim
+*	Note :	decim on n*deci input samples, n outputs.
+*****/
+
+static	double	bench_decim ( const vt_config *cf, long n )
+{
+	vtt_context	vt;
+	double	t, best = 1e30;
+	volatile float	sink = 0;
+	long	i;
+	short	j;
+	int	r;
+
+	for( r=0; r<NREP; r++)
+	{  memset( &vt, 0, sizeof(vt) );
+	   vt.cf = *cf;
+	   vt.deci = vt_deci( cf );
+	   decim_init( &vt );
+
+	   t = now();
+	   for( i=0; i<n; i++)
+	   {  for( j=0; j<vt.deci-1; j++) decim( &vt, 0, (float)(j - i%7) );
+	      sink += decim( &vt, 1, (float)(i%5) );
+	   }
+	   t = now() - t;
+	   if( t < best ) best = t;
+	   free( vt.h_decim );
+	   free( vt.v_decim );
+	}
+	return( best );
+}
+
+/*****
+*	Function : bench_glottal_area
+*	Note :	glottal_area_r on n samples, at 120 Hz.
+*****/
+
+static	double	bench_glottal_area ( const vt_config *cf, long n )
+{
+	glottal_state	gs;
+	double	t, best = 1e30;
+	volatile float	sink = 0;
+	short	t0, period = (short)(cf->smpfrq/120. + 0.5);
+	long	i;
+	int	r;
+
+	for( r=0; r<NREP; r++)
+	{  memset( &gs, 0, sizeof(gs) );
+	   t = now();
+	   for( i=0; i<n; i++)
+	   {  t0 = (short)( i%period == 0 ? period : 0 );
+	      sink += glottal_area_r( &gs, 'F', 'o', 0.2f, &t0 );
+	   }
+	   t = now() - t;
+	   if( t < best ) best = t;
+	}
+	return( best );
+}
+
+int	main ( int argc, char **argv )
+{
+	static const char	*nasal_name[] = { "OFF", "ON" };
+	static const char	*wall_name[] = { "RIGID", "YIELDING" };
+	static const char	*rad_name[] = { "SHORT_CIRCUIT", "RL_CIRCUIT",
+					       "BESSEL_FUNCTION" };
+	vt_config	cf, cc;
+	area_function	*af;
+	float	*ag;
+	double	dur = 2.0, sec;
+	long	n, frm;
+	int	nfrm, nasal, wal, rad;
+	char	name[80];
+
+	if( argc > 1 ) dur = atof( argv[1] );
+
+	copy_vt_config( &cf );
+	cf.nss = cf.nbu + cf.nph;
+	lam_setup();
+
+	n = (long)(dur*cf.smpfrq);
+	frm = (long)(FRAME_DUR*cf.smpfrq);
+	nfrm = (int)(n/frm) + 1;
+	af = frame_shapes( &cf, nfrm );
+	ag = glottal_track( &cf, n );
+
+	printf( "smpfrq %.0f Hz, simfrq %.0f Hz, %.1f s of sound per case, "
+		"%d voices per bank\n", cf.smpfrq, cf.simfrq, dur, VB_LANES );
+	printf( "tubes of vtt_sim as %s\n\n", VTT_LAYOUT );
+
+	for( nasal=OFF; nasal<=ON; nasal++)
+	for( wal=RIGID; wal<=YIELDING; wal++)
+	for( rad=SHORT_CIRCUIT; rad<=BESSEL_FUNCTION; rad++)
+	{  cc = cf;
+	   cc.nasal_tract = (short)nasal;
+	   cc.anc = nasal == ON ? 0.2f : 0.f;
+	   cc.wall = (short)wal;
+	   cc.rad_boundary = (short)rad;
+	   sec = bench_vtt_sim( &cc, af, ag, n, frm );
+	   sprintf( name, "vtt_sim  nasal %-3s %-8s %-15s", nasal_name[nasal],
+		    wall_name[wal], rad_name[rad] );
+	   report( name, sec, n, dur );
+	}
+
+	printf( "\n" );
+	for( nasal=OFF; nasal<=ON; nasal++)
+	for( wal=RIGID; wal<=YIELDING; wal++)
+	for( rad=SHORT_CIRCUIT; rad<=BESSEL_FUNCTION; rad++)
+	{  cc = cf;
+	   cc.nasal_tract = (short)nasal;
+	   cc.anc = nasal == ON ? 0.2f : 0.f;
+	   cc.wall = (short)wal;
+	   cc.rad_boundary = (short)rad;
+	   sec = bench_bank( &cc, af, ag, n, frm );
+	   sprintf( name, "vtt_bank nasal %-3s %-8s %-15s", nasal_name[nasal],
+		    wall_name[wal], rad_name[rad] );
+	   report( name, sec, n*VB_LANES, dur*VB_LANES );
+	}
+
+	printf( "\n" );
+	sec = bench_geometry( &cf, nfrm );
+	printf( "%-46s %9.1f ns/frame\n", "lam + sagittal_to_area + appro_af",
+		1e9*sec/nfrm );
+	report( "  ... per output sample", sec, nfrm*frm, nfrm*FRAME_DUR );
+	sec = bench_codebook( &cf, nfrm, CB_SIMPLEX );
+	printf( "%-46s %9.1f ns/frame\n", "codebook_lookup  simplex", 1e9*sec/nfrm );
+	sec = bench_codebook( &cf, nfrm, CB_MULTILINEAR );
+	printf( "%-46s %9.1f ns/frame\n", "codebook_lookup  multilinear", 1e9*sec/nfrm );
+	report( "decim", bench_decim( &cf, n ), n, dur );
+	report( "glottal_area", bench_glottal_area( &cf, n ), n, dur );
+
+	free( af );
+	free( ag );
+	return( 0 );
+}
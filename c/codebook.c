@@ -0,0 +1,274 @@
+/***************************************************************************
+*                                                                          *
+*	File :	codebook.c                                                 *
+*	Note :	Codebook of area functions on a grid over the articulatory *
+*		parameters, built with lam_batch, saved to and read from   *
+*		a binary file, and looked up by piecewise linear           *
+*		interpolation.                                             *
+*                                                                          *
+***************************************************************************/
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	"vtconfig.h"
+#include	"lam_lib.h"
+#include	"codebook.h"
+
+#define	CB_CHUNK	256	/* grid points per call of lam_batch */
+
+static	const	char	cb_magic[4] = { 'M', 'A', 'C', 'B' };
+
+/*****
+*	Function : codebook_shape
+*	Note :	Checks the tract and the grid of cb and computes its
+*		sections, strides and size.  Returns 0, or -1 if they are
+*		not valid.
+*****/
+static	short	codebook_shape ( af_codebook *cb )
+{
+	long	size = 1;
+	short	d;
+
+	if( cb->nph < 0 || cb->nbu < 0 ) return( -1 );
+	cb->nss = cb->nph + cb->nbu;
+	if( cb->nss <= 0 || cb->nss > CB_NSS_MAX ) return( -1 );
+	for(d=CB_NPAR-1; d>=0; d--)
+	{  if( cb->n[d] < 1 || !(cb->hi[d] >= cb->lo[d]) ) return( -1 );
+	   if( size > 0x7fffffffL/cb->nss/cb->n[d] ) return( -1 );
+	   cb->stride[d] = size;
+	   size *= cb->n[d];
+	}
+	cb->size = size;
+	return( 0 );
+}
+
+/*****
+*	Function : grid_value
+*	Note :	Parameter d of the grid point g.
+*****/
+static	float	grid_value ( const af_codebook *cb, long g, short d )
+{
+	long	i = (g/cb->stride[d]) % cb->n[d];
+
+	if( cb->n[d] == 1 ) return( cb->lo[d] );
+	return( cb->lo[d] + (cb->hi[d] - cb->lo[d])*i/(cb->n[d] - 1) );
+}
+
+/*****
+*	Function : codebook_build
+*	Note :	Area functions of the model md, of nph + nbu sections
+*		(pharynx and mouth of the tract), on a grid of n[d]
+*		points from lo[d] to hi[d] for each parameter d (lo[d]
+*		only if n[d] = 1).  Returns 0, or -1 if the grid is not
+*		valid or the memory could not be allocated.
+*****/
+short	codebook_build (
+	af_codebook	*cb,
+	const	lam_model	*md,
+	short	nph,
+	short	nbu,
+	const	short	n[CB_NPAR],
+	const	float	lo[CB_NPAR],
+	const	float	hi[CB_NPAR] )
+{
+	float	pa[CB_CHUNK*CB_NPAR];
+	vt_profile	*vp;
+	long	g, m, k;
+	short	d;
+
+	memset( cb, 0, sizeof(af_codebook) );
+	cb->interp = CB_SIMPLEX;
+	cb->nph = nph;
+	cb->nbu = nbu;
+	cb->model = md->sum;
+	for(d=0; d<CB_NPAR; d++)
+	{  cb->n[d]  = n[d];
+	   cb->lo[d] = lo[d];
+	   cb->hi[d] = hi[d];
+	}
+	if( codebook_shape( cb ) ) return( -1 );
+
+	cb->af = (area_function *) malloc( cb->size*cb->nss*sizeof(area_function) );
+	vp = (vt_profile *) malloc( CB_CHUNK*sizeof(vt_profile) );
+	if( cb->af == NULL || vp == NULL )
+	{  free( vp );
+	   codebook_term( cb );
+	   return( -1 );
+	}
+
+	for(g=0; g<cb->size; g+=m)
+	{  m = cb->size - g < CB_CHUNK ? cb->size - g : CB_CHUNK;
+	   for(k=0; k<m; k++)
+	      for(d=0; d<CB_NPAR; d++) pa[k*CB_NPAR+d] = grid_value( cb, g+k, d );
+	   lam_batch( md, pa, m, CB_NPAR, vp, cb->nss, cb->af + g*cb->nss );
+	}
+	free( vp );
+	return( 0 );
+}
+
+/*****
+*	Function : codebook_write
+*	Note :	Returns 0, or -1 if the file could not be written.
+*****/
+short	codebook_write ( const af_codebook *cb, const char *path )
+{
+	FILE	*fp;
+	short	version = CB_VERSION, ok;
+	unsigned int	model = (unsigned int) cb->model;
+
+	if( (fp = fopen( path, "wb" )) == NULL ) return( -1 );
+	ok = fwrite( cb_magic, sizeof(cb_magic), 1, fp ) == 1
+	  && fwrite( &version, sizeof(short), 1, fp ) == 1
+	  && fwrite( &cb->nph, sizeof(short), 1, fp ) == 1
+	  && fwrite( &cb->nbu, sizeof(short), 1, fp ) == 1
+	  && fwrite( &model, sizeof(unsigned int), 1, fp ) == 1
+	  && fwrite( cb->n,  sizeof(short), CB_NPAR, fp ) == CB_NPAR
+	  && fwrite( cb->lo, sizeof(float), CB_NPAR, fp ) == CB_NPAR
+	  && fwrite( cb->hi, sizeof(float), CB_NPAR, fp ) == CB_NPAR
+	  && fwrite( cb->af, sizeof(area_function), cb->size*cb->nss, fp )
+						== (size_t)(cb->size*cb->nss);
+	if( fclose( fp ) ) ok = 0;
+	return( ok ? 0 : -1 );
+}
+
+/*****
+*	Function : codebook_read
+*	Note :	Returns 0, or -1 if the file could not be read, is not a
+*		codebook of this version, or is truncated.
+*****/
+short	codebook_read ( af_codebook *cb, const char *path )
+{
+	FILE	*fp;
+	char	magic[4];
+	short	version, ok;
+	unsigned int	model = 0;
+
+	memset( cb, 0, sizeof(af_codebook) );
+	cb->interp = CB_SIMPLEX;
+	if( (fp = fopen( path, "rb" )) == NULL ) return( -1 );
+	ok = fread( magic, sizeof(magic), 1, fp ) == 1
+	  && memcmp( magic, cb_magic, sizeof(magic) ) == 0
+	  && fread( &version, sizeof(short), 1, fp ) == 1
+	  && version == CB_VERSION
+	  && fread( &cb->nph, sizeof(short), 1, fp ) == 1
+	  && fread( &cb->nbu, sizeof(short), 1, fp ) == 1
+	  && fread( &model, sizeof(unsigned int), 1, fp ) == 1
+	  && fread( cb->n,  sizeof(short), CB_NPAR, fp ) == CB_NPAR
+	  && fread( cb->lo, sizeof(float), CB_NPAR, fp ) == CB_NPAR
+	  && fread( cb->hi, sizeof(float), CB_NPAR, fp ) == CB_NPAR
+	  && codebook_shape( cb ) == 0
+	  && (cb->af = (area_function *)
+		malloc( cb->size*cb->nss*sizeof(area_function) )) != NULL
+	  && fread( cb->af, sizeof(area_function), cb->size*cb->nss, fp )
+						== (size_t)(cb->size*cb->nss);
+	fclose( fp );
+	cb->model = model;
+	if( !ok ) codebook_term( cb );
+	return( ok ? 0 : -1 );
+}
+
+/*****
+*	Function : cell
+*	Note :	Grid cell of the parameters para: returns the offset of
+*		its first corner, and the fractions f and parameters act
+*		of the nact parameters which do not fall on a grid point.
+*		Parameters out of the grid are clamped to it.
+*****/
+static	long	cell (
+	const	af_codebook	*cb,
+	const	float	*para,
+	float	*f,
+	short	*act,
+	short	*nact )
+{
+	float	t;
+	long	base = 0;
+	short	d, i;
+
+	*nact = 0;
+	for(d=0; d<CB_NPAR; d++)
+	{  if( cb->n[d] == 1 || cb->hi[d] == cb->lo[d] ) continue;
+	   t = (para[d] - cb->lo[d])/(cb->hi[d] - cb->lo[d])*(cb->n[d] - 1);
+	   if( !(t > 0) ) t = 0;			/* also a NaN */
+	   if( t > cb->n[d] - 1 ) t = (float)(cb->n[d] - 1);
+	   i = (short)t;
+	   if( i == cb->n[d] - 1 ) i--;
+	   base += i*cb->stride[d];
+	   if( t > i )
+	   {  f[*nact] = t - i;
+	      act[(*nact)++] = d;
+	   }
+	}
+	return( base );
+}
+
+/*****
+*	Function : codebook_lookup
+*	Note :	Area function (cb->nss sections) for the 7 parameters in
+*		para, interpolated from the grid points around them as
+*		set by cb->interp:
+*
+*		  CB_MULTILINEAR  the 2^k corners of the cell, k being
+*				  the number of parameters which do not
+*				  fall on a grid point;
+*		  CB_SIMPLEX	  the k+1 corners of the simplex of the
+*				  cell (Kuhn's subdivision) which holds
+*				  para, found by sorting the fractions.
+*
+*		Both are exact on the grid points and linear along the
+*		edges of the cells; the second one is much cheaper.
+*****/
+void	codebook_lookup (
+	const	af_codebook	*cb,
+	const	float	*para,
+	area_function	*af )
+{
+	const	float	*src;
+	float	acc[2*CB_NSS_MAX], f[CB_NPAR], t, w;
+	long	off;
+	short	act[CB_NPAR], nact, n2 = 2*cb->nss, d, e, k;
+	int	c;
+
+	off = cell( cb, para, f, act, &nact );
+	for(k=0; k<n2; k++) acc[k] = 0;
+
+	if( cb->interp == CB_SIMPLEX )
+	{  for(d=1; d<nact; d++)		/* fractions in decreasing order */
+	      for(e=d; e>0 && f[e] > f[e-1]; e--)
+	      {  t = f[e];   f[e] = f[e-1];   f[e-1] = t;
+		 c = act[e]; act[e] = act[e-1]; act[e-1] = (short)c;
+	      }
+	   for(d=0; d<=nact; d++)
+	   {  w = (d == 0 ? 1 : f[d-1]) - (d == nact ? 0 : f[d]);
+	      if( d > 0 ) off += cb->stride[act[d-1]];
+	      src = (const float *)(cb->af + off*cb->nss);
+	      for(k=0; k<n2; k++) acc[k] += w*src[k];
+	   }
+	}
+	else
+	{  for(c=0; c<(1<<nact); c++)
+	   {  w = 1;
+	      src = (const float *)(cb->af + off*cb->nss);
+	      for(d=0; d<nact; d++)
+		 if( c & (1<<d) )
+		 {  w *= f[d];
+		    src += 2*cb->nss*cb->stride[act[d]];
+		 }
+		 else w *= 1 - f[d];
+	      for(k=0; k<n2; k++) acc[k] += w*src[k];
+	   }
+	}
+
+	for(k=0; k<cb->nss; k++)
+	{  af[k].A = acc[2*k];
+	   af[k].x = acc[2*k+1];
+	}
+}
+
+void	codebook_term ( af_codebook *cb )
+{
+	free( cb->af );
+	cb->af = NULL;
+	cb->size = 0;
+}
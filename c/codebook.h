@@ -0,0 +1,57 @@
+#ifndef CODEBOOK_H
+#define CODEBOOK_H
+
+/*****
+*	File :	codebook.h
+*	Note :	A codebook of area functions: lam, sagittal_to_area and
+*		appro_area_function evaluated once on a grid over the 7
+*		articulatory parameters, and interpolated (piecewise linear)
+*		from the grid afterwards.  A lookup costs 8 (simplex) or
+*		at most 2^7 (multilinear) weighted sums of nss sections,
+*		against the square roots and powers of sagittal_to_area
+*		for each frame.
+*
+*		The file (codebook_write) is a header followed by the
+*		area functions of the grid points as floats (A, x), in
+*		the byte order of the machine which wrote it.  The header
+*		holds the tract (nph + nbu sections) and the model
+*		(lam_spec_checksum) of the codebook, which a voice checks
+*		(synth_voice_codebook).
+*****/
+
+#include "vtconfig.h"
+#include "lam_lib.h"
+
+#define	CB_NPAR		7	/* articulatory parameters (= AMnum)	*/
+#define	CB_VERSION	2	/* version of the file format		*/
+#define	CB_NSS_MAX	64	/* sections of an area function, at most */
+
+/* interpolation between the grid points (see codebook_lookup) */
+#define	CB_SIMPLEX	0	/* the default */
+#define	CB_MULTILINEAR	1
+
+typedef struct {
+	short	interp;			/* CB_SIMPLEX or CB_MULTILINEAR	  */
+	short	nss;			/* sections of each area function */
+	short	nph, nbu;		/* ... of the pharynx and mouth	  */
+	unsigned long	model;		/* lam_spec_checksum of the model */
+	short	n[CB_NPAR];		/* grid points per parameter, >= 1 */
+	float	lo[CB_NPAR];		/* parameter value of the first	  */
+	float	hi[CB_NPAR];		/* ... and of the last grid point */
+	long	stride[CB_NPAR];	/* area functions between two	  */
+					/* points along each parameter	  */
+	long	size;			/* number of grid points	  */
+	area_function	*af;		/* size*nss, the last parameter	  */
+					/* varying fastest		  */
+} af_codebook;
+
+short	codebook_build( af_codebook *cb, const lam_model *md, short nph,
+			short nbu, const short n[CB_NPAR], const float lo[CB_NPAR],
+			const float hi[CB_NPAR] );
+short	codebook_write( const af_codebook *cb, const char *path );
+short	codebook_read( af_codebook *cb, const char *path );
+void	codebook_lookup( const af_codebook *cb, const float *para,
+			 area_function *af );
+void	codebook_term( af_codebook *cb );
+
+#endif
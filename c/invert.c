@@ -0,0 +1,898 @@
+/***************************************************************************
+*                                                                          *
+*	File :	invert.c                                                   *
+*	Note :	Acoustic-to-articulatory inversion of formant tracks, with *
+*		a codebook of the forward model indexed by a k-d tree.     *
+*                                                                          *
+***************************************************************************/
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<math.h>
+#include	<unistd.h>
+#include	<pthread.h>
+#include	"vtconfig.h"
+#include	"lam_lib.h"
+#include	"vtf_lib.h"
+#include	"invert.h"
+
+#define	IV_CHUNK	16	/* points or frames per take of a thread */
+#define	IV_KMAX		64	/* entries per frame, at most		*/
+#define	IV_DELTA	0.05	/* step of the finite differences	*/
+#define	IV_TRIES	5	/* damping increases per step, at most	*/
+#define	IV_BW		60.0f	/* first guess of the bandwidths (Hz)	*/
+
+static	const	char	iv_magic[4] = { 'M', 'A', 'I', 'V' };
+
+/*****
+*	Function : uniform
+*	Note :	A number in [0,1) for the parameter d of the point i of a
+*		codebook of the given seed (splitmix64), so that the points
+*		do not depend on the threads which compute them.
+*****/
+static	double	uniform ( unsigned long seed, long i, int d )
+{
+	unsigned long long	z;
+
+	z = (unsigned long long) seed
+	    + ((unsigned long long) i*IV_NPAR + d + 1)*0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	return( (double)(z >> 11)*(1.0/9007199254740992.0) );
+}
+
+static	unsigned long	fnv_float ( unsigned long h, float f )
+{
+	union { float f; unsigned int u; }	b;
+	int	j;
+
+	b.f = f;
+	for(j=0; j<32; j+=8)
+	   h = ((h ^ ((b.u >> j) & 0xff))*16777619UL) & 0xffffffffUL;
+	return( h );
+}
+
+/*****
+*	Function : tract_sum
+*	Note :	A checksum (FNV-1a, 32 bits) of the options of cf on which
+*		the formants depend, besides the sections and the rates:
+*		boundaries, source, walls, nasal tract and constants.
+*****/
+static	unsigned long	tract_sum ( const vt_config *cf )
+{
+	float	v[21];
+	unsigned long	h = 2166136261UL;
+	int	n = 0, i;
+
+	v[n++] = cf->nasal_tract;	v[n++] = cf->wall;
+	v[n++] = cf->rad_boundary;	v[n++] = cf->glt_boundary;
+	v[n++] = cf->source_loc;	v[n++] = cf->source_typ;
+	v[n++] = cf->anc;		v[n++] = cf->nna;
+	v[n++] = cf->Ag;		v[n++] = cf->xg;
+	v[n++] = cf->lg;		v[n++] = cf->extra_loss_factor;
+	v[n++] = cf->ro;		v[n++] = cf->c;
+	v[n++] = cf->eta;		v[n++] = cf->cp;
+	v[n++] = cf->lamda;		v[n++] = cf->mu;
+	v[n++] = cf->wall_resi;		v[n++] = cf->wall_mass;
+	v[n++] = cf->wall_comp;
+	for(i=0; i<n; i++) h = fnv_float( h, v[i] );
+	for(i=0; i<cf->nna && cf->afnt != NULL; i++)
+	{  h = fnv_float( h, cf->afnt[i].A );
+	   h = fnv_float( h, cf->afnt[i].x );
+	}
+	return( h );
+}
+
+/*****
+*	Function : same_tract
+*	Note :	Whether the tract and the model in use are those of ib.
+*****/
+static	short	same_tract ( const inv_codebook *ib, const vt_config *cf )
+{
+	lam_spec	sp;
+
+	lam_spec_get( &sp );
+	return( ib->nph == cf->nph && ib->nbu == cf->nbu
+	     && ib->smpfrq == cf->smpfrq && ib->simfrq == cf->simfrq
+	     && ib->tract == tract_sum( cf )
+	     && ib->model == lam_spec_checksum( &sp ) );
+}
+
+/*************************( the forward model )*************************/
+
+typedef struct {
+	const	lam_model	*md;
+	vtf_context	vf;
+	vt_profile	vp;
+	area_function	*af;		/* nss sections		*/
+	short	nss;
+	int	nfmt;
+	float	flo, fhi;
+} fwd_model;
+
+static	short	fwd_ini ( fwd_model *fm, const vt_config *cf, int nfmt,
+			  float flo, float fhi )
+{
+	fm->md = lam_default();
+	fm->nss = cf->nph + cf->nbu;
+	fm->nfmt = nfmt;
+	fm->flo = flo;
+	fm->fhi = fhi;
+	fm->vf.cf = *cf;
+	fm->af = (area_function *) malloc( fm->nss*sizeof(area_function) );
+	fm->vf.cf.afvt = fm->af;
+	fm->vf.mem = NULL;
+	if( fm->af == NULL || vtf_ini_r( &fm->vf, VTF_GRID ) ) return( -1 );
+	return( 0 );
+}
+
+static	void	fwd_term ( fwd_model *fm )
+{
+	vtf_term_r( &fm->vf );
+	free( fm->af );
+	fm->af = NULL;
+}
+
+/*****
+*	Function : forward
+*	Note :	The nfmt formants F and bandwidths B of the parameters p:
+*		from the poles F0, B0 of a nearby articulation if F0 is
+*		not NULL (vtf_poles_r), else from the whole search of
+*		vtf_formants_r.  Returns 0, or -1 if not all the formants
+*		were found.
+*****/
+static	short	forward ( fwd_model *fm, const float *p, float *F, float *B,
+			  const float *F0, const float *B0 )
+{
+	int	j, n = fm->nfmt;
+
+	lam_batch( fm->md, p, 1, IV_NPAR, &fm->vp, fm->nss, fm->af );
+	if( F0 != NULL )
+	{  for(j=0; j<n; j++)
+	   {  F[j] = F0[j];
+	      B[j] = B0[j];
+	   }
+	   if( vtf_poles_r( &fm->vf, n, F, B ) ) return( -1 );
+	}
+	else if( vtf_formants_r( &fm->vf, fm->flo, fm->fhi, n, F, B ) != n )
+	   return( -1 );
+	for(j=0; j<n; j++)		/* distinct, in order, and damped */
+	   if( !(F[j] > (j > 0 ? F[j-1] + 1.0f : 0.0f)) || !(B[j] > 0)
+	    || !(F[j] < 2.0f*fm->fhi) ) return( -1 );
+	return( 0 );
+}
+
+/*************************( the k-d tree )*************************/
+
+static	void	swap_entries ( inv_codebook *ib, long i, long j )
+{
+	float	t;
+	int	d;
+
+	for(d=0; d<IV_NPAR; d++)
+	{  t = ib->para[i*IV_NPAR+d];
+	   ib->para[i*IV_NPAR+d] = ib->para[j*IV_NPAR+d];
+	   ib->para[j*IV_NPAR+d] = t;
+	}
+	for(d=0; d<ib->nfmt; d++)
+	{  t = ib->key[i*ib->nfmt+d];
+	   ib->key[i*ib->nfmt+d] = ib->key[j*ib->nfmt+d];
+	   ib->key[j*ib->nfmt+d] = t;
+	}
+}
+
+/*****
+*	Function : kd_build
+*	Note :	Makes the entries lo to hi - 1 a k-d tree: the median
+*		along the dimension of the largest spread is its root, in
+*		the middle, with the entries below it before and those
+*		above after, each a tree in turn.
+*****/
+static	void	kd_build ( inv_codebook *ib, long lo, long hi )
+{
+	long	mid, i, j, a, b;
+	float	mn, mx, best = -1, v, pv;
+	int	nf = ib->nfmt, d, sd = 0;
+
+	while( hi - lo > 1 )
+	{  for(d=0; d<nf; d++)
+	   {  mn = mx = ib->key[lo*nf+d];
+	      for(i=lo+1; i<hi; i++)
+	      {  v = ib->key[i*nf+d];
+		 if( v < mn ) mn = v;
+		 if( v > mx ) mx = v;
+	      }
+	      if( d == 0 || mx - mn > best )
+	      {  best = mx - mn;
+		 sd = d;
+	      }
+	   }
+	   mid = (lo + hi)/2;			/* quickselect of the median */
+	   for(a=lo, b=hi-1; a<b; )
+	   {  pv = ib->key[((a + b)/2)*nf+sd];
+	      for(i=a, j=b; i<=j; )
+	      {  while( ib->key[i*nf+sd] < pv ) i++;
+		 while( ib->key[j*nf+sd] > pv ) j--;
+		 if( i <= j ) swap_entries( ib, i++, j-- );
+	      }
+	      if( mid <= j ) b = j;
+	      else if( mid >= i ) a = i;
+	      else break;
+	   }
+	   ib->dim[mid] = (char) sd;
+	   kd_build( ib, lo, mid );
+	   lo = mid + 1;
+	}
+	if( hi - lo == 1 ) ib->dim[lo] = 0;
+}
+
+typedef struct {
+	const	float	*q;		/* the log formants sought	*/
+	int	k, n;			/* wanted, found		*/
+	long	*idx;			/* found, nearest first		*/
+	float	*dist;			/* their squared distances	*/
+} knn_list;
+
+static	void	kd_search ( const inv_codebook *ib, long lo, long hi, knn_list *kl )
+{
+	const	float	*e;
+	long	mid;
+	float	d2 = 0, t, diff;
+	int	nf = ib->nfmt, d, i;
+
+	if( lo >= hi ) return;
+	mid = (lo + hi)/2;
+	e = ib->key + mid*nf;
+	for(d=0; d<nf; d++)
+	{  t = kl->q[d] - e[d];
+	   d2 += t*t;
+	}
+	if( kl->n < kl->k || d2 < kl->dist[kl->n-1] )
+	{  i = kl->n < kl->k ? kl->n++ : kl->n - 1;
+	   for( ; i>0 && kl->dist[i-1] > d2; i--)
+	   {  kl->dist[i] = kl->dist[i-1];
+	      kl->idx[i] = kl->idx[i-1];
+	   }
+	   kl->dist[i] = d2;
+	   kl->idx[i] = mid;
+	}
+	diff = kl->q[(int)ib->dim[mid]] - e[(int)ib->dim[mid]];
+	if( diff < 0 )
+	{  kd_search( ib, lo, mid, kl );
+	   if( kl->n < kl->k || diff*diff < kl->dist[kl->n-1] )
+	      kd_search( ib, mid + 1, hi, kl );
+	}
+	else
+	{  kd_search( ib, mid + 1, hi, kl );
+	   if( kl->n < kl->k || diff*diff < kl->dist[kl->n-1] )
+	      kd_search( ib, lo, mid, kl );
+	}
+}
+
+/*****
+*	Function : inv_nearest
+*	Note :	The k entries of ib nearest to the formants F (ib->nfmt
+*		of them, Hz), by the distance between the log formants:
+*		their indices into idx and the distances into dist, if
+*		not NULL, nearest first.  Returns the number found, or -1
+*		if k is not in [1, IV_KMAX] or a formant is not above 0.
+*****/
+long	inv_nearest (
+	const	inv_codebook	*ib,
+	const	float	*F,
+	int	k,
+	long	*idx,
+	float	*dist )
+{
+	knn_list	kl;
+	float	q[IV_NFMT], d2[IV_KMAX];
+	int	j;
+
+	if( k < 1 || k > IV_KMAX ) return( -1 );
+	for(j=0; j<ib->nfmt; j++)
+	{  if( !(F[j] > 0) ) return( -1 );
+	   q[j] = logf( F[j] );
+	}
+	kl.q = q;
+	kl.k = k;
+	kl.n = 0;
+	kl.idx = idx;
+	kl.dist = d2;
+	kd_search( ib, 0, ib->size, &kl );
+	for(j=0; j<kl.n && dist != NULL; j++) dist[j] = sqrtf( d2[j] );
+	return( kl.n );
+}
+
+/*************************( building a codebook )*************************/
+
+typedef struct {
+	const	vt_config	*cf;
+	long	n, next;		/* points, next to take		*/
+	unsigned long	seed;
+	const	float	*lo, *hi;
+	int	nfmt;
+	float	flo, fhi;
+	float	*para, *fmt;		/* n rows			*/
+	char	*ok;			/* all the formants found	*/
+	short	failed;
+	pthread_mutex_t	lock;
+} build_pool;
+
+/*****
+*	Function : take_rows
+*	Note :	The next IV_CHUNK rows of n for a thread, from *next, into
+*		[*i0, *i1); returns 0 once none is left or failed is set.
+*****/
+static	short	take_rows ( pthread_mutex_t *lock, long n, long *next,
+			    short *failed, short ok, long *i0, long *i1 )
+{
+	pthread_mutex_lock( lock );
+	if( !ok ) *failed = 1;
+	*i0 = *failed ? n : *next;
+	*i1 = n - *i0 < IV_CHUNK ? n : *i0 + IV_CHUNK;
+	*next = *i1;
+	pthread_mutex_unlock( lock );
+	return( *i0 < *i1 );
+}
+
+static	void	*build_worker ( void *arg )
+{
+	build_pool	*bp = (build_pool *) arg;
+	fwd_model	fm;
+	float	B[IV_NFMT], *p;
+	long	i, i0, i1;
+	short	ok;
+	int	d;
+
+	ok = fwd_ini( &fm, bp->cf, bp->nfmt, bp->flo, bp->fhi ) == 0;
+	while( take_rows( &bp->lock, bp->n, &bp->next, &bp->failed, ok, &i0, &i1 ) )
+	   for(i=i0; i<i1; i++)
+	   {  p = bp->para + i*IV_NPAR;
+	      for(d=0; d<IV_NPAR; d++)
+		 p[d] = (float)(bp->lo[d] + (bp->hi[d] - bp->lo[d])
+				*uniform( bp->seed, i, d ));
+	      bp->ok[i] = forward( &fm, p, bp->fmt + i*bp->nfmt, B,
+				   NULL, NULL ) == 0;
+	   }
+	fwd_term( &fm );
+	return( NULL );
+}
+
+/*****
+*	Function : run_pool
+*	Note :	Runs nthreads threads (<= 0 for one per online processor,
+*		at most one per IV_CHUNK of the n rows) of worker on arg.
+*		Returns IV_OK, or IV_EMEMORY if no thread could be had.
+*****/
+static	short	run_pool ( void *(*worker)( void * ), void *arg, long n,
+			   int nthreads )
+{
+	pthread_t	*th;
+	int	i, started = 0;
+
+	if( nthreads <= 0 ) nthreads = (int) sysconf( _SC_NPROCESSORS_ONLN );
+	if( nthreads <= 0 ) nthreads = 1;
+	if( nthreads > (n + IV_CHUNK - 1)/IV_CHUNK )
+	   nthreads = (int)((n + IV_CHUNK - 1)/IV_CHUNK);
+	if( (th = (pthread_t *) malloc( nthreads*sizeof(pthread_t) )) == NULL )
+	   return( IV_EMEMORY );
+	for(i=0; i<nthreads; i++)
+	   if( pthread_create( &th[i], NULL, worker, arg ) == 0 ) started++;
+	for(i=0; i<started; i++) pthread_join( th[i], NULL );
+	free( th );
+	return( started > 0 ? IV_OK : IV_EMEMORY );
+}
+
+/*****
+*	Function : inv_build
+*	Note :	A codebook of npoints articulations drawn at random
+*		(seed) between lo and hi, with the tract and options of
+*		cf (cf->nph + cf->nbu sections, as synth_frame), and of
+*		the model lam_default(): those of which the first nfmt
+*		formants above flo are found below fhi (Hz) are kept,
+*		then indexed.  ib records the tract and the model.
+*		nthreads threads share the work (<= 0 for one per online
+*		processor).  The same seed gives the same codebook,
+*		whatever the threads.
+*
+*		Returns IV_OK, IV_EARG or IV_EMEMORY.
+*****/
+short	inv_build (
+	inv_codebook	*ib,
+	const	vt_config	*cf,
+	long	npoints,
+	unsigned long	seed,
+	const	float	lo[IV_NPAR],
+	const	float	hi[IV_NPAR],
+	int	nfmt,
+	float	flo,
+	float	fhi,
+	int	nthreads )
+{
+	build_pool	bp;
+	lam_spec	sp;
+	long	i, m;
+	int	d;
+	short	r;
+
+	memset( ib, 0, sizeof(inv_codebook) );
+	if( npoints < 1 || npoints > 0x7fffffffL || nfmt < 1 || nfmt > IV_NFMT
+	 || !(fhi > 0) || cf->nph + cf->nbu < 1 ) return( IV_EARG );
+	for(d=0; d<IV_NPAR; d++)
+	   if( !(hi[d] >= lo[d]) ) return( IV_EARG );
+	ib->nfmt = (short) nfmt;
+	ib->flo = flo;
+	ib->fhi = fhi;
+	for(d=0; d<IV_NPAR; d++)
+	{  ib->lo[d] = lo[d];
+	   ib->hi[d] = hi[d];
+	}
+	ib->nph = cf->nph;
+	ib->nbu = cf->nbu;
+	ib->smpfrq = cf->smpfrq;
+	ib->simfrq = cf->simfrq;
+	ib->tract = tract_sum( cf );
+
+	memset( &bp, 0, sizeof(bp) );
+	bp.cf = cf;
+	bp.n = npoints;
+	bp.seed = seed;
+	bp.lo = lo;
+	bp.hi = hi;
+	bp.nfmt = nfmt;
+	bp.flo = flo;
+	bp.fhi = fhi;
+	bp.para = (float *) malloc( npoints*IV_NPAR*sizeof(float) );
+	bp.fmt = (float *) malloc( npoints*nfmt*sizeof(float) );
+	bp.ok = (char *) malloc( npoints );
+	r = bp.para == NULL || bp.fmt == NULL || bp.ok == NULL ? IV_EMEMORY : IV_OK;
+
+	lam_default();			/* set up before the threads */
+	lam_spec_get( &sp );
+	ib->model = lam_spec_checksum( &sp );
+	if( r == IV_OK )
+	{  pthread_mutex_init( &bp.lock, NULL );
+	   r = run_pool( build_worker, &bp, npoints, nthreads );
+	   pthread_mutex_destroy( &bp.lock );
+	   if( r == IV_OK && bp.failed ) r = IV_EMEMORY;
+	}
+
+	if( r == IV_OK )		/* the entries kept, as log formants */
+	{  for(i=m=0; i<npoints; i++)
+	      if( bp.ok[i] )
+	      {  memmove( bp.para + m*IV_NPAR, bp.para + i*IV_NPAR,
+			  IV_NPAR*sizeof(float) );
+		 for(d=0; d<nfmt; d++)
+		    bp.fmt[m*nfmt+d] = logf( bp.fmt[i*nfmt+d] );
+		 m++;
+	      }
+	   ib->size = m;
+	   ib->para = bp.para;
+	   ib->key = bp.fmt;
+	   ib->dim = (char *) malloc( m > 0 ? m : 1 );
+	   bp.para = bp.fmt = NULL;
+	   if( ib->dim == NULL ) r = IV_EMEMORY;
+	   else kd_build( ib, 0, m );
+	}
+	free( bp.ok );
+	free( bp.fmt );
+	free( bp.para );
+	if( r != IV_OK ) inv_term( ib );
+	return( r );
+}
+
+/*****
+*	Function : inv_write
+*	Note :	Returns IV_OK, or IV_EFILE if the file could not be
+*		written.
+*****/
+short	inv_write ( const inv_codebook *ib, const char *path )
+{
+	FILE	*fp;
+	short	version = IV_VERSION, ok;
+	int	size = (int) ib->size;
+	unsigned int	sum[2];
+
+	sum[0] = (unsigned int) ib->tract;
+	sum[1] = (unsigned int) ib->model;
+	if( (fp = fopen( path, "wb" )) == NULL ) return( IV_EFILE );
+	ok = fwrite( iv_magic, sizeof(iv_magic), 1, fp ) == 1
+	  && fwrite( &version, sizeof(short), 1, fp ) == 1
+	  && fwrite( &ib->nfmt, sizeof(short), 1, fp ) == 1
+	  && fwrite( &ib->flo, sizeof(float), 1, fp ) == 1
+	  && fwrite( &ib->fhi, sizeof(float), 1, fp ) == 1
+	  && fwrite( ib->lo, sizeof(float), IV_NPAR, fp ) == IV_NPAR
+	  && fwrite( ib->hi, sizeof(float), IV_NPAR, fp ) == IV_NPAR
+	  && fwrite( &ib->nph, sizeof(short), 1, fp ) == 1
+	  && fwrite( &ib->nbu, sizeof(short), 1, fp ) == 1
+	  && fwrite( &ib->smpfrq, sizeof(float), 1, fp ) == 1
+	  && fwrite( &ib->simfrq, sizeof(float), 1, fp ) == 1
+	  && fwrite( sum, sizeof(unsigned int), 2, fp ) == 2
+	  && fwrite( &size, sizeof(int), 1, fp ) == 1
+	  && fwrite( ib->para, sizeof(float), size*IV_NPAR, fp )
+						== (size_t)size*IV_NPAR
+	  && fwrite( ib->key, sizeof(float), size*ib->nfmt, fp )
+						== (size_t)size*ib->nfmt
+	  && fwrite( ib->dim, 1, size, fp ) == (size_t)size;
+	if( fclose( fp ) ) ok = 0;
+	return( ok ? IV_OK : IV_EFILE );
+}
+
+/*****
+*	Function : inv_read
+*	Note :	Returns IV_OK, IV_EFILE if the file could not be opened,
+*		IV_EFORMAT if it is not a codebook of this version or is
+*		truncated, or IV_EMEMORY.
+*****/
+short	inv_read ( inv_codebook *ib, const char *path )
+{
+	FILE	*fp;
+	char	magic[4];
+	short	version, r = IV_EFORMAT;
+	int	size;
+	unsigned int	sum[2];
+	long	i;
+
+	memset( ib, 0, sizeof(inv_codebook) );
+	if( (fp = fopen( path, "rb" )) == NULL ) return( IV_EFILE );
+	if( fread( magic, sizeof(magic), 1, fp ) == 1
+	 && memcmp( magic, iv_magic, sizeof(magic) ) == 0
+	 && fread( &version, sizeof(short), 1, fp ) == 1
+	 && version == IV_VERSION
+	 && fread( &ib->nfmt, sizeof(short), 1, fp ) == 1
+	 && ib->nfmt >= 1 && ib->nfmt <= IV_NFMT
+	 && fread( &ib->flo, sizeof(float), 1, fp ) == 1
+	 && fread( &ib->fhi, sizeof(float), 1, fp ) == 1
+	 && fread( ib->lo, sizeof(float), IV_NPAR, fp ) == IV_NPAR
+	 && fread( ib->hi, sizeof(float), IV_NPAR, fp ) == IV_NPAR
+	 && fread( &ib->nph, sizeof(short), 1, fp ) == 1
+	 && fread( &ib->nbu, sizeof(short), 1, fp ) == 1
+	 && fread( &ib->smpfrq, sizeof(float), 1, fp ) == 1
+	 && fread( &ib->simfrq, sizeof(float), 1, fp ) == 1
+	 && fread( sum, sizeof(unsigned int), 2, fp ) == 2
+	 && fread( &size, sizeof(int), 1, fp ) == 1 && size >= 0 )
+	{  ib->tract = sum[0];
+	   ib->model = sum[1];
+	   ib->size = size;
+	   ib->para = (float *) malloc( (size_t)size*IV_NPAR*sizeof(float) + 1 );
+	   ib->key = (float *) malloc( (size_t)size*ib->nfmt*sizeof(float) + 1 );
+	   ib->dim = (char *) malloc( (size_t)size + 1 );
+	   if( ib->para == NULL || ib->key == NULL || ib->dim == NULL )
+	      r = IV_EMEMORY;
+	   else if( fread( ib->para, sizeof(float), size*IV_NPAR, fp )
+						== (size_t)size*IV_NPAR
+		 && fread( ib->key, sizeof(float), size*ib->nfmt, fp )
+						== (size_t)size*ib->nfmt
+		 && fread( ib->dim, 1, size, fp ) == (size_t)size )
+	   {  r = IV_OK;
+	      for(i=0; i<size; i++)
+		 if( ib->dim[i] < 0 || ib->dim[i] >= ib->nfmt ) r = IV_EFORMAT;
+	   }
+	}
+	fclose( fp );
+	if( r != IV_OK ) inv_term( ib );
+	return( r );
+}
+
+/*************************( inversion of a track )*************************/
+
+void	inv_options_default ( inv_options *op )
+{
+	op->k = 16;
+	op->smooth = 1.0f;
+	op->reg = 0.05f;
+	op->iter = 4;
+	op->sigma = 0.05f;
+}
+
+typedef struct {
+	const	inv_codebook	*ib;
+	const	vt_config	*cf;
+	const	inv_options	*op;
+	const	float	*F;		/* T rows of target formants	*/
+	const	long	*entry;		/* T entries, -1 for none	*/
+	long	T, next;
+	float	*para, *err;
+	short	failed;
+	pthread_mutex_t	lock;
+} track_pool;
+
+/*****
+*	Function : cost
+*	Note :	The residuals of the parameters p of formants F for the
+*		target t, from the start p0, into r (nfmt + IV_NPAR), and
+*		their sum of squares.
+*****/
+static	double	cost ( const track_pool *tp, const float *F, const float *t,
+		       const float *p, const float *p0, double *r )
+{
+	int	nf = tp->ib->nfmt, j;
+	double	s = 0, w = sqrt( tp->op->reg );
+
+	for(j=0; j<nf; j++) r[j] = log( F[j]/t[j] )/tp->op->sigma;
+	for(j=0; j<IV_NPAR; j++) r[nf+j] = w*(p[j] - p0[j]);
+	for(j=0; j<nf+IV_NPAR; j++) s += r[j]*r[j];
+	return( s );
+}
+
+/*****
+*	Function : solve
+*	Note :	Solves A x = b (IV_NPAR equations) in place of b, by
+*		Gaussian elimination with partial pivoting.  Returns 0,
+*		or -1 if A is singular.
+*****/
+static	short	solve ( double A[IV_NPAR][IV_NPAR], double *b )
+{
+	double	t, f;
+	int	i, j, k, pv;
+
+	for(k=0; k<IV_NPAR; k++)
+	{  for(pv=k, i=k+1; i<IV_NPAR; i++)
+	      if( fabs(A[i][k]) > fabs(A[pv][k]) ) pv = i;
+	   if( !(fabs(A[pv][k]) > 1e-300) ) return( -1 );
+	   for(j=0; j<IV_NPAR; j++)
+	   {  t = A[k][j];  A[k][j] = A[pv][j];  A[pv][j] = t;
+	   }
+	   t = b[k];  b[k] = b[pv];  b[pv] = t;
+	   for(i=k+1; i<IV_NPAR; i++)
+	   {  f = A[i][k]/A[k][k];
+	      for(j=k; j<IV_NPAR; j++) A[i][j] -= f*A[k][j];
+	      b[i] -= f*b[k];
+	   }
+	}
+	for(k=IV_NPAR-1; k>=0; k--)
+	{  for(j=k+1; j<IV_NPAR; j++) b[k] -= A[k][j]*b[j];
+	   b[k] /= A[k][k];
+	}
+	return( 0 );
+}
+
+/*****
+*	Function : refine_frame
+*	Note :	Levenberg-Marquardt from the parameters of the entry e
+*		towards the target formants t, into p, kept within the
+*		range of the codebook, the Jacobian by finite differences
+*		from the poles of p; the poles of the entry itself are
+*		refined from its formants.  p is left as the entry if its
+*		formants cannot be had.  Returns the rms relative formant
+*		error, or -1 if no formants.
+*****/
+static	float	refine_frame ( const track_pool *tp, fwd_model *fm, long e,
+			       const float *t, float *p )
+{
+	const	inv_codebook	*ib = tp->ib;
+	int	nf = ib->nfmt, nr = nf + IV_NPAR, i, j, d, it, tr;
+	float	p0[IV_NPAR], pn[IV_NPAR], F[IV_NFMT], B[IV_NFMT];
+	float	Fn[IV_NFMT], Bn[IV_NFMT];
+	double	r[IV_NFMT+IV_NPAR], rn[IV_NFMT+IV_NPAR];
+	double	J[IV_NFMT][IV_NPAR], A[IV_NPAR][IV_NPAR], M[IV_NPAR][IV_NPAR];
+	double	g[IV_NPAR], x[IV_NPAR], c, cn, h, lambda = 1e-2, mx, s;
+
+	memcpy( p, ib->para + e*IV_NPAR, IV_NPAR*sizeof(float) );
+	memcpy( p0, p, sizeof(p0) );
+	for(j=0; j<nf; j++)
+	{  Fn[j] = expf( ib->key[e*nf+j] );
+	   Bn[j] = IV_BW;
+	}
+	if( forward( fm, p, F, B, Fn, Bn )
+	 && forward( fm, p, F, B, NULL, NULL ) ) return( -1 );
+	c = cost( tp, F, t, p, p0, r );
+
+	for(it=0; it<tp->op->iter; it++)
+	{  for(d=0; d<IV_NPAR; d++)		/* J of the formant residuals */
+	   {  memcpy( pn, p, sizeof(pn) );
+	      h = p[d] + IV_DELTA <= ib->hi[d] ? IV_DELTA : -IV_DELTA;
+	      pn[d] = (float)(p[d] + h);
+	      if( forward( fm, pn, Fn, Bn, F, B ) ) return( (float) c );
+	      for(j=0; j<nf; j++)
+		 J[j][d] = log( Fn[j]/F[j] )/tp->op->sigma/(pn[d] - p[d]);
+	   }
+	   for(i=0; i<IV_NPAR; i++)		/* A = J'J, g = J'r */
+	   {  for(d=0; d<IV_NPAR; d++)
+	      {  for(A[i][d]=0, j=0; j<nf; j++) A[i][d] += J[j][i]*J[j][d];
+		 if( d == i ) A[i][d] += tp->op->reg;
+	      }
+	      for(g[i]=0, j=0; j<nf; j++) g[i] += J[j][i]*r[j];
+	      g[i] += sqrt( tp->op->reg )*r[nf+i];
+	   }
+
+	   for(tr=0; tr<IV_TRIES; tr++, lambda *= 10)
+	   {  memcpy( M, A, sizeof(M) );
+	      for(i=0; i<IV_NPAR; i++)
+	      {  M[i][i] *= 1 + lambda;
+		 x[i] = -g[i];
+	      }
+	      if( solve( M, x ) ) continue;
+	      for(mx=0, d=0; d<IV_NPAR; d++)
+	      {  pn[d] = (float) fmin( fmax( p[d] + x[d], ib->lo[d] ), ib->hi[d] );
+		 mx = fmax( mx, fabs( pn[d] - p[d] ) );
+	      }
+	      if( forward( fm, pn, Fn, Bn, F, B ) == 0
+	       && (cn = cost( tp, Fn, t, pn, p0, rn )) < c ) break;
+	   }
+	   if( tr == IV_TRIES ) break;
+	   memcpy( p, pn, sizeof(pn) );
+	   memcpy( F, Fn, sizeof(F) );
+	   memcpy( B, Bn, sizeof(B) );
+	   memcpy( r, rn, nr*sizeof(double) );
+	   c = cn;
+	   lambda = fmax( lambda*0.1, 1e-6 );
+	   if( mx < 1e-3 ) break;
+	}
+
+	for(s=0, j=0; j<nf; j++) s += (F[j]/t[j] - 1)*(F[j]/t[j] - 1);
+	return( (float) sqrt( s/nf ) );
+}
+
+static	void	*track_worker ( void *arg )
+{
+	track_pool	*tp = (track_pool *) arg;
+	const	inv_codebook	*ib = tp->ib;
+	fwd_model	fm;
+	float	*p, e;
+	long	t, i0, i1;
+	short	ok;
+
+	ok = fwd_ini( &fm, tp->cf, ib->nfmt, ib->flo, ib->fhi ) == 0;
+	while( take_rows( &tp->lock, tp->T, &tp->next, &tp->failed, ok, &i0, &i1 ) )
+	   for(t=i0; t<i1; t++)
+	   {  p = tp->para + t*IV_NPAR;
+	      if( tp->entry[t] < 0 )
+	      {  memset( p, 0, IV_NPAR*sizeof(float) );
+		 if( tp->err != NULL ) tp->err[t] = -1;
+		 continue;
+	      }
+	      e = refine_frame( tp, &fm, tp->entry[t], tp->F + t*ib->nfmt, p );
+	      if( tp->err != NULL ) tp->err[t] = e;
+	   }
+	fwd_term( &fm );
+	return( NULL );
+}
+
+/*****
+*	Function : choose_entries
+*	Note :	The entry of each frame, among the op->k nearest to its
+*		formants, which minimizes the sum over the frames of the
+*		formant cost (see cost) and of op->smooth times the
+*		squared distance between the articulations of two
+*		successive frames (Viterbi).  A frame with a formant not
+*		above 0 gets -1, and breaks the track.  Returns IV_OK or
+*		IV_EMEMORY.
+*****/
+static	short	choose_entries ( const inv_codebook *ib, const inv_options *op,
+				 const float *F, long T, long *entry )
+{
+	int	k = op->k, nf = ib->nfmt, *n, *back, c, b, d;
+	long	*cand, t, t0;
+	float	*dist;
+	double	*acc, best, v, s, dd;
+	const	float	*pa, *pb;
+
+	cand = (long *) malloc( T*k*sizeof(long) );
+	dist = (float *) malloc( T*k*sizeof(float) );
+	acc = (double *) malloc( T*k*sizeof(double) );
+	back = (int *) malloc( T*k*sizeof(int) );
+	n = (int *) malloc( T*sizeof(int) );
+	if( cand == NULL || dist == NULL || acc == NULL || back == NULL || n == NULL )
+	{  free( n ); free( back ); free( acc ); free( dist ); free( cand );
+	   return( IV_EMEMORY );
+	}
+
+	for(t=0; t<T; t++)
+	{  n[t] = (int) inv_nearest( ib, F + t*nf, k, cand + t*k, dist + t*k );
+	   if( n[t] < 0 ) n[t] = 0;
+	}
+	for(t0=0; t0<T; )
+	{  if( n[t0] == 0 )
+	   {  entry[t0++] = -1;
+	      continue;
+	   }
+	   for(t=t0; t<T && n[t]>0; t++)	/* the frames t0 to t - 1 */
+	      for(c=0; c<n[t]; c++)
+	      {  s = dist[t*k+c]/op->sigma;
+		 acc[t*k+c] = s*s;
+		 back[t*k+c] = -1;
+		 if( t == t0 ) continue;
+		 pa = ib->para + cand[t*k+c]*IV_NPAR;
+		 for(best=HUGE_VAL, b=0; b<n[t-1]; b++)
+		 {  pb = ib->para + cand[(t-1)*k+b]*IV_NPAR;
+		    for(dd=0, d=0; d<IV_NPAR; d++) dd += (pa[d] - pb[d])*(pa[d] - pb[d]);
+		    v = acc[(t-1)*k+b] + op->smooth*dd;
+		    if( v < best )
+		    {  best = v;
+		       back[t*k+c] = b;
+		    }
+		 }
+		 acc[t*k+c] += best;
+	      }
+	   for(b=0, c=1; c<n[t-1]; c++)
+	      if( acc[(t-1)*k+c] < acc[(t-1)*k+b] ) b = c;
+	   while( --t >= t0 )
+	   {  entry[t] = cand[t*k+b];
+	      b = back[t*k+b];
+	   }
+	   for(t0++; t0<T && n[t0]>0; t0++) ;
+	}
+	free( n ); free( back ); free( acc ); free( dist ); free( cand );
+	return( IV_OK );
+}
+
+/*****
+*	Function : inv_track
+*	Note :	The parameters of the T frames of formants F (T rows of
+*		ib->nfmt, Hz) into para (T rows of IV_NPAR), with the
+*		tract and options of cf (those of inv_build): an entry of
+*		ib per frame (choose_entries), refined by at most
+*		op->iter steps (refine_frame) on nthreads threads (<= 0
+*		for one per online processor).  err, if not NULL, gets
+*		the rms relative formant error of each frame.  A frame
+*		with a formant not above 0 is not inverted: its
+*		parameters are 0 and its error -1.
+*
+*		Returns IV_OK, IV_EARG (also if the sections, rates or
+*		other options of cf, or the model in use, are not those
+*		of ib) or IV_EMEMORY.
+*****/
+short	inv_track (
+	const	inv_codebook	*ib,
+	const	vt_config	*cf,
+	const	inv_options	*op,
+	const	float	*F,
+	long	T,
+	float	*para,
+	float	*err,
+	int	nthreads )
+{
+	track_pool	tp;
+	long	*entry;
+	short	r;
+
+	if( T <= 0 ) return( IV_OK );
+	if( ib->size < 1 || op->k < 1 || op->k > IV_KMAX || !(op->sigma > 0)
+	 || !(op->reg >= 0) || !(op->smooth >= 0)
+	 || cf->nph + cf->nbu < 1 || !same_tract( ib, cf ) ) return( IV_EARG );
+	if( (entry = (long *) malloc( T*sizeof(long) )) == NULL )
+	   return( IV_EMEMORY );
+	if( (r = choose_entries( ib, op, F, T, entry )) == IV_OK )
+	{  memset( &tp, 0, sizeof(tp) );
+	   tp.ib = ib;
+	   tp.cf = cf;
+	   tp.op = op;
+	   tp.F = F;
+	   tp.entry = entry;
+	   tp.T = T;
+	   tp.para = para;
+	   tp.err = err;
+	   lam_default();
+	   pthread_mutex_init( &tp.lock, NULL );
+	   r = run_pool( track_worker, &tp, T, nthreads );
+	   pthread_mutex_destroy( &tp.lock );
+	   if( r == IV_OK && tp.failed ) r = IV_EMEMORY;
+	}
+	free( entry );
+	return( r );
+}
+
+void	inv_term ( inv_codebook *ib )
+{
+	free( ib->dim );
+	free( ib->key );
+	free( ib->para );
+	ib->dim = NULL;
+	ib->key = ib->para = NULL;
+	ib->size = 0;
+}
+
+const	char	*inv_error ( short r )
+{
+	switch( r )
+	{  case IV_OK:		return( "no error" );
+	   case IV_EFILE:	return( "file could not be opened, read or written" );
+	   case IV_EFORMAT:	return( "not an inversion codebook" );
+	   case IV_EARG:	return( "arguments not valid" );
+	   case IV_EMEMORY:	return( "not enough memory" );
+	}
+	return( "unknown error" );
+}
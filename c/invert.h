@@ -0,0 +1,83 @@
+#ifndef INVERT_H
+#define INVERT_H
+
+/*****
+*	File :	invert.h
+*	Note :	Acoustic-to-articulatory inversion: the 7 articulatory
+*		parameters of the model for each frame of a track of
+*		formants.
+*
+*		An inversion codebook (inv_build) holds the formants of
+*		many random articulations, computed once by the forward
+*		model (lam_batch, then vtf_formants_r), indexed by a k-d
+*		tree over the log formants.  inv_track takes the nearest
+*		entries of each frame, chooses one per frame so that the
+*		articulation moves little between frames (dynamic
+*		programming), and refines it by Levenberg-Marquardt on
+*		the forward model, the frames being shared by a pool of
+*		threads.
+*
+*		The file (inv_write) is a header followed by the entries,
+*		in the order of the tree, as floats in the byte order of
+*		the machine which wrote it.  The header holds the tract
+*		and the model of inv_build, and inv_track refuses a
+*		codebook of another.
+*****/
+
+#include "vtconfig.h"
+#include "lam_lib.h"
+
+#define	IV_NPAR		7	/* articulatory parameters (= AMnum)	*/
+#define	IV_NFMT		5	/* formants per entry, at most		*/
+#define	IV_VERSION	2	/* version of the file format		*/
+
+/* values returned by the functions below */
+#define	IV_OK		0
+#define	IV_EFILE	-1	/* file could not be opened, read or written */
+#define	IV_EFORMAT	-2	/* not an inversion codebook, or truncated */
+#define	IV_EARG		-3	/* arguments not valid			*/
+#define	IV_EMEMORY	-4	/* not enough memory, or no thread	*/
+
+typedef struct {
+	short	nfmt;			/* formants per entry		   */
+	float	flo, fhi;		/* range of the formant search (Hz) */
+	float	lo[IV_NPAR];		/* range of the parameters	   */
+	float	hi[IV_NPAR];
+	short	nph, nbu;		/* sections and rates of the tract */
+	float	smpfrq, simfrq;		/* of inv_build,		   */
+	unsigned long	tract;		/* its other options (tract_sum),  */
+	unsigned long	model;		/* lam_spec_checksum of its model  */
+	long	size;			/* entries			   */
+	float	*para;			/* size*IV_NPAR parameters	   */
+	float	*key;			/* size*nfmt log formants	   */
+	char	*dim;			/* the split dimension of each	   */
+					/* entry, as the node of the tree  */
+} inv_codebook;
+
+typedef struct {
+	int	k;			/* entries per frame		   */
+	float	smooth;			/* weight of the distance between  */
+					/* the articulations of two frames */
+	float	reg;			/* weight of the distance from the */
+					/* entry, in the refinement	   */
+	int	iter;			/* refinement steps, at most	   */
+	float	sigma;			/* formant error of unit cost	   */
+					/* (relative)			   */
+} inv_options;
+
+short	inv_build( inv_codebook *ib, const vt_config *cf, long npoints,
+		   unsigned long seed, const float lo[IV_NPAR],
+		   const float hi[IV_NPAR], int nfmt, float flo, float fhi,
+		   int nthreads );
+short	inv_write( const inv_codebook *ib, const char *path );
+short	inv_read( inv_codebook *ib, const char *path );
+long	inv_nearest( const inv_codebook *ib, const float *F, int k,
+		     long *idx, float *dist );
+void	inv_options_default( inv_options *op );
+short	inv_track( const inv_codebook *ib, const vt_config *cf,
+		   const inv_options *op, const float *F, long T,
+		   float *para, float *err, int nthreads );
+void	inv_term( inv_codebook *ib );
+const	char	*inv_error( short r );
+
+#endif
@@ -9,22 +9,12 @@
 #include	"vtconfig.h"
 #include	"lam_lib.h"
 
-/************************( global )****************************/
-
-/* Number of articulatory parameters */
-
-#define	JAW	1	/* number of jaw parameter */
-#define	LIP	2	/* number of intrinsic lip parameters (HT and PR) */
-#define	TNG	3	/* number of intrinsic tongue parameters */
-#define	LRX	1	/* number of intrinsic larynx parameter (height) */
-
-/* Number of variables (for arrays) */
+#if !defined(_WIN32)
+#include	<sys/mman.h>
+#define	LAM_MMAP		/* binary model files are mapped */
+#endif
 
-#define	M4	 31	/* =m1 + m2 + m3, total number of semi-polar grids */
-#define	NVRS_LIP  4	/* = nvrs_lip  */
-#define	NVRS_TNG 26	/* = nvrs_tng  */
-#define	NVRS_LRX  5	/* = nvrs_lrx  */
-#define NVRS_WAL 25	/* = nvrs_wal  */
+/************************( global )****************************/
 
 const	float	pi = 3.14159265f;
 
@@ -50,8 +40,6 @@ static float beta[M4] = {1.2,1.2,1.2,1.2,1.2,1.2,1.2,1.2,1.2,1.2,1.2,1.2,1.2,1.2
 /* Lip-tube specification */
 short	nvrs_lip = 4;		/* number of variables            */
 short	jaw_lip = 1;		/* number of jaw variables(0 or 1)*/
-/* labals for factors (parameters)*/
-static	char	flab_lip[JAW+LIP][3] = { "JW", "HT", "P1"};
 /* mean values in TEK unit        */
 static	float	u_lip[NVRS_LIP] = { 104.271675, 122.812141, 135.938339, 460.440857};
 /* standard deviations in TEK unit*/
@@ -71,8 +59,6 @@ short	nvrs_tng =26;		/* number of variables            */
 short	jaw_tng = 1;		/* number of jaw variables(0 or 1)*/
 short	iniva_tng = 7;	/* coordinate number of initial point     */
 short	lstva_tng = 31;	/* coorninate number of last point        */
-/* labals for factors (parameters)*/
-static	char	flab_tng[JAW+TNG][3]= {"JW", "P1", "P2", "P3"};
 /* mean values in TEK unit        */
 static	float	u_tng[NVRS_TNG] = { 104.271675,     443.988434,     450.481689,   399.942200,     348.603088,    351.181122,     365.404633,     370.290955,     356.202301,     341.890167,    332.117523,     326.826599,     326.512512,     331.631989,     343.175323,    361.265900,     385.231201,     411.826599,     435.691711,     455.040466,    462.736023,     453.025055,     432.250488,     407.358368,     384.551056,    363.836212};
 /* standard deviations in TEK unit*/
@@ -110,8 +96,6 @@ static	float	A_tng[NVRS_TNG][JAW+TNG] = {
 	short	jaw_lrx = 1;		/* number of jaw variables(0 or 1)*/
 	short	iniva_lrx = 7;	/* coordinate number of initial point     */
 	short	lstva_lrx = 6;	/* coordinate number of last point        */
-/* labals for factors (parameters)*/
-static	char	flab_lrx[JAW+LRX][3] = {"JW","Y1"};
 /* mean values in TEK unit        */
 static	float	u_lrx[NVRS_LRX] ={104.271675, 143.138733, -948.229309, 404.678223, -962.936401};
 /* standard deviations in TEK unit*/
@@ -135,30 +119,31 @@ static	float	u_wal[NVRS_WAL] = {550.196533,     604.878601,    674.127197,     6
 /*************************( global variables )***************************/
 
 /* Semi-polar coordinate and VT contours */
-float	vp_map = 1.0f;			/* viewport map coef. (cm/point)  */
 const	float	size_correction = 1.10f; /* 10% size increase              */
 const	float	vp_width_cm = 10.0f;	/* viewport height in cm          */
-static	float2D	igd[M4], egd[M4];	/* Semi-polar coordinate grids    */
-static	float2D	vtos[M4];		/* vector to semi-polar map       */
+static	lam_model	model0;		/* default model (convert_scale)  */
+static	unsigned long	spec_serial = 1;	/* changes of the spec in use	  */
+static	unsigned long	model0_serial = 0;	/* ... model0 was made from	  */
 short	np;			/* number of points               */
 float2D	ivt[NP];		/* VT inside contours             */
 float2D	evt[NP];		/* VT exterior contours           */
 const	float	inci_lip = 0.8f;	/* (cm) dist. btwn. incisor and upper lip */
-float	inci_lip_vp;		/* inci_lip in viewport unit      */
 float	lip_w, lip_h;		/* lip-tube width and height      */
 
 /***************************( functions )**********************************/
 
 
 /*****
-*	Function : semi_polar
+*	Function : semi_polar_r
 *		The semi-ploar is specified by x-y values of the two ends
-*		of each grid line.
+*		of each grid line.  Computed for the model md, the spec of
+*		which is converted (convert_model).
 *
 *****/
 
-void	semi_polar ( void )
+static	void	semi_polar_r ( lam_model *md )
 {
+	const	lam_spec	*sp = &md->sp;
 	float	r  = 5.0;		/* grid length (cm) */
 
 	float	r_vp, dl_vp, ome, the, gam;
@@ -166,10 +151,10 @@ void	semi_polar ( void )
 	float	p, q, s;
 	short	i;
 
-	r_vp  = r/vp_map;
-	dl_vp = dl/vp_map;
-	ome    = pi*omega/180.0f;
-	the    = pi*theta/180.0f;
+	r_vp  = r/md->vp_map;
+	dl_vp = sp->dl/md->vp_map;
+	ome    = pi*sp->omega/180.0f;
+	the    = pi*sp->theta/180.0f;
 
 /* linear coordinate in the pharynx region */
 	dx_i  = dl_vp*(float)cos(ome - pi/2.);
@@ -177,19 +162,19 @@ void	semi_polar ( void )
 	dx_e  = r_vp*(float)cos(ome);
 	dy_e  = r_vp*(float)sin(ome);
 
-	for(i=0; i<m1; i++)
-	{  igd[i].x = dx_i*(m1 - (i + 1)) + ix0;
-	   igd[i].y = dy_i*(m1 - (i + 1)) + iy0;
-	   egd[i].x = dx_e + igd[i].x;
-	   egd[i].y = dy_e + igd[i].y;
+	for(i=0; i<sp->m1; i++)
+	{  md->igd[i].x = dx_i*(sp->m1 - (i + 1)) + sp->ix0;
+	   md->igd[i].y = dy_i*(sp->m1 - (i + 1)) + sp->iy0;
+	   md->egd[i].x = dx_e + md->igd[i].x;
+	   md->egd[i].y = dy_e + md->igd[i].y;
 	}
 /* polar coordinate in the velar region */
-	for(i=m1; i<m1+m2; i++)
-	{  gam = the*(i + 1 - m1) + ome;
-	   igd[i].x = (float)ix0;
-	   igd[i].y = (float)iy0;
-	   egd[i].x = r_vp*(float)cos(gam) + ix0;
-	   egd[i].y = r_vp*(float)sin(gam) + iy0;
+	for(i=sp->m1; i<sp->m1+sp->m2; i++)
+	{  gam = the*(i + 1 - sp->m1) + ome;
+	   md->igd[i].x = (float)sp->ix0;
+	   md->igd[i].y = (float)sp->iy0;
+	   md->egd[i].x = r_vp*(float)cos(gam) + sp->ix0;
+	   md->egd[i].y = r_vp*(float)sin(gam) + sp->iy0;
 	}
 /* linear coordinate in the palato-dental region */
 	dx_i  = dl_vp*(float)cos(gam + pi/2.0f);
@@ -197,24 +182,24 @@ void	semi_polar ( void )
 	dx_e  = r_vp*(float)cos(gam);
 	dy_e  = r_vp*(float)sin(gam);
 
-	for(i=m1+m2; i<m1+m2+m3; i++)
-	{  igd[i].x = dx_i*(i + 1 - m1 - m2) + ix0;
-	   igd[i].y = dy_i*(i + 1 - m1 - m2) + iy0;
-	   egd[i].x = dx_e + igd[i].x;
-	   egd[i].y = dy_e + igd[i].y;
+	for(i=sp->m1+sp->m2; i<sp->m1+sp->m2+sp->m3; i++)
+	{  md->igd[i].x = dx_i*(i + 1 - sp->m1 - sp->m2) + sp->ix0;
+	   md->igd[i].y = dy_i*(i + 1 - sp->m1 - sp->m2) + sp->iy0;
+	   md->egd[i].x = dx_e + md->igd[i].x;
+	   md->egd[i].y = dy_e + md->igd[i].y;
 	}
 /* Mapping coefficients from vector to semi-polar */
-	for(i=0; i<m1+m2+m3; i++)
-	{  p = egd[i].x - igd[i].x;
-	   q = egd[i].y - igd[i].y;
+	for(i=0; i<sp->m1+sp->m2+sp->m3; i++)
+	{  p = md->egd[i].x - md->igd[i].x;
+	   q = md->egd[i].y - md->igd[i].y;
 	   s = (float)sqrt( p*p + q*q );
-	   vtos[i].x = p/s;
-	   vtos[i].y = q/s;
+	   md->vtos[i].x = p/s;
+	   md->vtos[i].y = q/s;
 	}
 }
 
 /*****
-*	Function : lam
+*	Function : lam_r
 *	Note :	Compute vector representetion of the articulator positions
 *		for given parameter values and project them on the semi-
 *		polar coordinate to generate a VT profile.
@@ -234,8 +219,15 @@ void	semi_polar ( void )
 *			exterior walls (10/08/92).
 *
 ****/
-void	lam ( float *pa )		/* a set of JAW+TNG+LIP+LRX */
-{                                       /* articulatory parameter   */
+void	lam_r (
+	const	lam_model	*md,	/* the model		    */
+	float		*pa,		/* a set of JAW+TNG+LIP+LRX */
+					/* articulatory parameter   */
+	vt_profile	*vp )		/* the computed VT profile  */
+{
+	const	lam_spec	*sp = &md->sp;
+	float2D	*ivt = vp->ivt, *evt = vp->evt;
+	short	np;
 	float	p[JAW+TNG];
 	float	v_lip[NVRS_LIP], v_tng[NVRS_TNG], v_lrx[NVRS_LRX];
 	float	v, x1, y1, x2, y2;
@@ -247,47 +239,47 @@ void	lam ( float *pa )		/* a set of JAW+TNG+LIP+LRX */
 
 /* tongue */
 	for(i=1; i<=TNG; i++) p[i] = pa[i];
-	for(i=0; i<nvrs_tng; i++)
+	for(i=0; i<sp->nvrs_tng; i++)
 	{  v = 0;
-	   for(j=0; j<JAW+TNG; j++) v = v + A_tng[i][j]*p[j];
-	   v_tng[i] = s_tng[i]*v + u_tng[i];
+	   for(j=0; j<JAW+TNG; j++) v = v + sp->A_tng[i][j]*p[j];
+	   v_tng[i] = sp->s_tng[i]*v + sp->u_tng[i];
 	}
 /* lip */
 	for(i=1; i<=LIP; i++) p[i] = pa[i+TNG];/* copy intrinsic lip pars.*/
-	for(i=0; i<nvrs_lip; i++)
+	for(i=0; i<sp->nvrs_lip; i++)
 	{  v = 0;
-	   for(j=0; j<JAW+LIP; j++) v = v + A_lip[i][j]*p[j];
-	   v_lip[i] = s_lip[i]*v + u_lip[i];
+	   for(j=0; j<JAW+LIP; j++) v = v + sp->A_lip[i][j]*p[j];
+	   v_lip[i] = sp->s_lip[i]*v + sp->u_lip[i];
 	   if( v_lip[i] < 0. ) v_lip[i] = 0.;		/** block at zero **/
 	}
 /* larnx */
 	for(i=1; i<=LRX; i++) p[i] = pa[i+TNG+LIP];
-	for(i=0; i<nvrs_lrx; i++)
+	for(i=0; i<sp->nvrs_lrx; i++)
 	{  v = 0;
-	   for(j=0; j<JAW+LRX; j++) v = v + A_lrx[i][j]*p[j];
-	   v_lrx[i] = s_lrx[i]*v + u_lrx[i];
+	   for(j=0; j<JAW+LRX; j++) v = v + sp->A_lrx[i][j]*p[j];
+	   v_lrx[i] = sp->s_lrx[i]*v + sp->u_lrx[i];
 	}
 
 /*** Projection of vectors on the semi-polar coordinate ***/
 
 /* larynx back edge */
 	np=0;
-	ivt[np].x = v_lrx[JAW]   + ix0;		/* front edge */
-	ivt[np].y = v_lrx[JAW+1] + iy0;
-	evt[np].x = v_lrx[JAW+2] + ix0;		/* rear edge */
-	evt[np].y = v_lrx[JAW+3] + iy0;
+	ivt[np].x = v_lrx[JAW]   + sp->ix0;		/* front edge */
+	ivt[np].y = v_lrx[JAW+1] + sp->iy0;
+	evt[np].x = v_lrx[JAW+2] + sp->ix0;		/* rear edge */
+	evt[np].y = v_lrx[JAW+3] + sp->iy0;
 
 /* larynx, pharynx and buccal */
-	for(i=iniva_tng; i<lstva_tng; i++)  // this was i<=lstva_tng which left slice 26 at (0,0)
-	{  j = i - iniva_tng;
+	for(i=sp->iniva_tng; i<sp->lstva_tng; i++)  // this was i<=lstva_tng which left slice 26 at (0,0)
+	{  j = i - sp->iniva_tng;
 	   /** block tongue contour at walls **/
-	   v = (float)min( v_tng[j+JAW], u_wal[j] );
-	   x1 = vtos[i].x * v + igd[i].x;		/* inside */
-	   y1 = vtos[i].y * v + igd[i].y;
-	   x2 = vtos[i].x * u_wal[j] + igd[i].x;	/* outside */
-	   y2 = vtos[i].y * u_wal[j] + igd[i].y;
+	   v = (float)min( v_tng[j+JAW], sp->u_wal[j] );
+	   x1 = md->vtos[i].x * v + md->igd[i].x;		/* inside */
+	   y1 = md->vtos[i].y * v + md->igd[i].y;
+	   x2 = md->vtos[i].x * sp->u_wal[j] + md->igd[i].x;	/* outside */
+	   y2 = md->vtos[i].y * sp->u_wal[j] + md->igd[i].y;
 
-	   if(i == iniva_tng)			/* add an extra point */
+	   if(i == sp->iniva_tng)			/* add an extra point */
 	   {  ivt[++np].x = (ivt[0].x + x1)/2;
 	      ivt[  np].y = (ivt[0].y + y1)/2;
 	      evt[  np].x = (evt[0].x + x2)/2;
@@ -299,8 +291,8 @@ void	lam ( float *pa )		/* a set of JAW+TNG+LIP+LRX */
 	   evt[  np].y = y2;
 	}
 /* lips */
-	evt[++np].x = inci_x + ix0;     /* pos. of inner edge of upper lip */
-	evt[  np].y = inci_y + inci_lip_vp + iy0;
+	evt[++np].x = sp->inci_x + sp->ix0;     /* pos. of inner edge of upper lip */
+	evt[  np].y = sp->inci_y + md->inci_lip_vp + sp->iy0;
 	ivt[  np].x = evt[np].x;
 	ivt[  np].y = evt[np].y - v_lip[2];	/* lower lip */
 
@@ -315,8 +307,201 @@ void	lam ( float *pa )		/* a set of JAW+TNG+LIP+LRX */
 	++np;
 
 /*** Lip frontal shape (ellips) ***/
-	lip_h = (float)(v_lip[2]/2.);
-	lip_w = (float)(v_lip[3]/2.);
+	vp->np    = np;
+	vp->lip_h = (float)(v_lip[2]/2.);
+	vp->lip_w = (float)(v_lip[3]/2.);
+}
+
+/*****
+*	Function : factor_block
+*	Note :	Vectors v = s*(A p) + u of one articulator for a block
+*		of parameter sets at once: p[j*LAM_BLOCK + b] is the factor
+*		j of the set b, and v[i*LAM_BLOCK + b] receives the
+*		variable i.  There are at most FAC_MAX factors; the rows
+*		of p beyond nfac must hold finite values, which are
+*		multiplied by zero.  The loop over the LAM_BLOCK sets
+*		(unused ones are zero) vectorizes, and each v is summed
+*		in the order of the factors, as in lam_r.
+*****/
+
+#define	LAM_BLOCK	16	/* parameter sets per block of lam_batch */
+#define	FAC_MAX		(JAW+TNG)	/* factors of the largest model	*/
+
+static	void	factor_block (
+	short	nvrs,		/* number of variables		*/
+	short	nfac,		/* number of factors		*/
+	const	float	*A,	/* nvrs x nfac loadings		*/
+	const	float	*s,	/* standard deviations		*/
+	const	float	*u,	/* mean values			*/
+	const	float	*p,	/* FAC_MAX x LAM_BLOCK factors	*/
+	float	*v )		/* nvrs x LAM_BLOCK vectors	*/
+{
+	float	a[FAC_MAX], w[LAM_BLOCK], si, ui;
+	short	i, j, b;
+
+	for(i=0; i<nvrs; i++)
+	{  for(j=0; j<FAC_MAX; j++) a[j] = j < nfac ? A[i*nfac+j] : 0.f;
+	   si = s[i];
+	   ui = u[i];
+	   for(b=0; b<LAM_BLOCK; b++)		/* w can not alias p */
+	      w[b] = si*( a[0]*p[b] + a[1]*p[LAM_BLOCK+b]
+			+ a[2]*p[2*LAM_BLOCK+b] + a[3]*p[3*LAM_BLOCK+b] ) + ui;
+	   memcpy( v + i*LAM_BLOCK, w, sizeof(w) );
+	}
+}
+
+/*****
+*	Function : project_block
+*	Note :	The projection of lam_r, for a block of nb parameter sets
+*		whose vectors are laid out as by factor_block.  The inside
+*		points are computed for the LAM_BLOCK sets at once, the
+*		outside ones, which depend on the walls only, once for
+*		all the sets; then each profile is written in turn.
+*****/
+static	void	project_block (
+	const	lam_model	*md,
+	const	float	*v_tng,
+	const	float	*v_lip,
+	const	float	*v_lrx,
+	short	nb,
+	vt_profile	*vp )
+{
+	const	lam_spec	*sp = &md->sp;
+	float	xi[NVRS_WAL][LAM_BLOCK], yi[NVRS_WAL][LAM_BLOCK];
+	float	xe[NVRS_WAL], ye[NVRS_WAL], v;
+	float2D	*ivt, *evt;
+	short	nw, np, i, j, b;
+
+/* larynx, pharynx and buccal, inside and outside */
+	nw = sp->lstva_tng - sp->iniva_tng;
+	for(j=0; j<nw; j++)
+	{  i = j + sp->iniva_tng;
+	   /** block tongue contour at walls **/
+	   for(b=0; b<LAM_BLOCK; b++)
+	   {  v = (float)min( v_tng[(j+JAW)*LAM_BLOCK+b], sp->u_wal[j] );
+	      xi[j][b] = md->vtos[i].x * v + md->igd[i].x;
+	      yi[j][b] = md->vtos[i].y * v + md->igd[i].y;
+	   }
+	   xe[j] = md->vtos[i].x * sp->u_wal[j] + md->igd[i].x;
+	   ye[j] = md->vtos[i].y * sp->u_wal[j] + md->igd[i].y;
+	}
+
+	for(b=0; b<nb; b++)
+	{  ivt = vp[b].ivt;
+	   evt = vp[b].evt;
+
+/* larynx back edge */
+	   ivt[0].x = v_lrx[JAW*LAM_BLOCK+b]     + sp->ix0;	/* front edge */
+	   ivt[0].y = v_lrx[(JAW+1)*LAM_BLOCK+b] + sp->iy0;
+	   evt[0].x = v_lrx[(JAW+2)*LAM_BLOCK+b] + sp->ix0;	/* rear edge */
+	   evt[0].y = v_lrx[(JAW+3)*LAM_BLOCK+b] + sp->iy0;
+
+	   ivt[1].x = (ivt[0].x + xi[0][b])/2;		/* add an extra point */
+	   ivt[1].y = (ivt[0].y + yi[0][b])/2;
+	   evt[1].x = (evt[0].x + xe[0])/2;
+	   evt[1].y = (evt[0].y + ye[0])/2;
+	   np = 1;
+	   for(j=0; j<nw; j++)
+	   {  ++np;
+	      ivt[np].x = xi[j][b];
+	      ivt[np].y = yi[j][b];
+	      evt[np].x = xe[j];
+	      evt[np].y = ye[j];
+	   }
+
+/* lips */
+	   ++np;
+	   evt[np].x = sp->inci_x + sp->ix0;     /* pos. of inner edge of upper lip */
+	   evt[np].y = sp->inci_y + md->inci_lip_vp + sp->iy0;
+	   ivt[np].x = evt[np].x;
+	   ivt[np].y = evt[np].y - v_lip[2*LAM_BLOCK+b];	/* lower lip */
+
+	   evt[np+1].x = evt[np].x - v_lip[LAM_BLOCK+b];
+	   evt[np+1].y = evt[np].y;
+	   ivt[np+1].x = evt[np+1].x;
+	   ivt[np+1].y = ivt[np].y;
+
+/*** Lip frontal shape (ellips) ***/
+	   vp[b].np    = np+2;
+	   vp[b].lip_h = (float)(v_lip[2*LAM_BLOCK+b]/2.);
+	   vp[b].lip_w = (float)(v_lip[3*LAM_BLOCK+b]/2.);
+	}
+}
+
+/*****
+*	Function : lam_batch
+*	Note :	lam_r for m parameter sets, and optionally the area
+*		functions of the profiles.  The sets are taken in blocks
+*		of LAM_BLOCK, and the vectors of a block are computed as
+*		small matrix products (factor_block), loadings times the
+*		factors of all the sets of the block.  The results are
+*		those of lam_r, up to the rounding of multiply-adds the
+*		compiler may contract (-ffp-contract) differently.  All
+*		the arrays belong to the caller.
+*****/
+void	lam_batch (
+	const	lam_model	*md,	/* the model			*/
+	const	float	*pa,	/* m parameter sets of JAW+TNG+LIP+LRX	*/
+	long	m,
+	long	ldp,		/* distance between two sets in pa	*/
+				/* (= 7 for an m x 7 matrix)		*/
+	vt_profile	*vp,	/* m VT profiles			*/
+	short	nss,		/* sections of the area functions	*/
+	area_function	*af )	/* m*nss area functions, or NULL	*/
+{
+	const	lam_spec	*sp = &md->sp;
+	float	p[FAC_MAX*LAM_BLOCK];
+	float	v_tng[NVRS_TNG*LAM_BLOCK], v_lip[NVRS_LIP*LAM_BLOCK];
+	float	v_lrx[NVRS_LRX*LAM_BLOCK];
+	area_function	af0[NP];
+	const	float	*q;
+	short	i, b, nb, ns0;
+	long	k;
+
+	for(k=0; k<m; k+=nb)
+	{  nb = (short)( m-k < LAM_BLOCK ? m-k : LAM_BLOCK );
+	   q  = pa + k*ldp;
+
+/* tongue */
+	   for(b=0; b<LAM_BLOCK; b++)
+	      for(i=0; i<=TNG; i++) p[i*LAM_BLOCK+b] = b < nb ? q[b*ldp+i] : 0.f;
+	   factor_block( sp->nvrs_tng, JAW+TNG, sp->A_tng[0], sp->s_tng, sp->u_tng, p, v_tng );
+/* lip */
+	   for(b=0; b<nb; b++)
+	      for(i=1; i<=LIP; i++) p[i*LAM_BLOCK+b] = q[b*ldp+i+TNG];
+	   factor_block( sp->nvrs_lip, JAW+LIP, sp->A_lip[0], sp->s_lip, sp->u_lip, p, v_lip );
+	   for(i=0; i<sp->nvrs_lip*LAM_BLOCK; i++)
+	      if( v_lip[i] < 0. ) v_lip[i] = 0.;		/** block at zero **/
+/* larnx */
+	   for(b=0; b<nb; b++)
+	      for(i=1; i<=LRX; i++) p[i*LAM_BLOCK+b] = q[b*ldp+i+TNG+LIP];
+	   factor_block( sp->nvrs_lrx, JAW+LRX, sp->A_lrx[0], sp->s_lrx, sp->u_lrx, p, v_lrx );
+
+/* profiles and area functions */
+	   project_block( md, v_tng, v_lip, v_lrx, nb, vp+k );
+	   if( af != NULL )
+	      for(b=0; b<nb; b++)
+	      {  sagittal_to_area_r( md, vp+k+b, &ns0, af0 );
+		 appro_area_function( ns0, af0, nss, af + (k+b)*nss );
+	      }
+	}
+}
+
+/*****
+*	Function : lam
+*	Note :	Same as lam_r with the default model, but the VT profile
+*		is left in the global ivt[], evt[], np, lip_h and lip_w.
+*****/
+void	lam ( float *pa )
+{
+	static	vt_profile	vp;
+
+	lam_r( &model0, pa, &vp );
+	np = vp.np;
+	memcpy( ivt, vp.ivt, np*sizeof(float2D) );
+	memcpy( evt, vp.evt, np*sizeof(float2D) );
+	lip_h = vp.lip_h;
+	lip_w = vp.lip_w;
 }
 
 /*****
@@ -329,7 +514,7 @@ float	amo (float2D p, float2D q)
 }
 
 /******
-*	Function : sagittal_to_area
+*	Function : sagittal_to_area_r
 *	Note :	To calculate an area function of the vocal tract (VT)
 *		from a quadrilateral representation of the profile.
 *		The conversion employes an "alpha-beta" sagittal-to-
@@ -338,17 +523,23 @@ float	amo (float2D p, float2D q)
 *		grids.
 *****/
 
-void	sagittal_to_area (
+void	sagittal_to_area_r (
+	const lam_model	*md,	/* model of the profile */
+	const vt_profile *vp,	/* VT profile computed by lam_r */
 	short	*ns,		/* number of sections */
 	area_function	*af)	/* af.A = cross-sectional area (cm**2) */
 				/* af.x = section length (cm) */
 {
+	const	lam_spec	*sp = &md->sp;
+	const	float2D	*ivt = vp->ivt, *evt = vp->evt;
+	short	np = vp->np;
+	float	lip_h = vp->lip_h, lip_w = vp->lip_w;
 	float	p, q, r, s, t, a1, a2, s1, s2, x1, y1, d, w;
 	float	c, cc;
 	short	i, j;
 
 /* vt_unit to cm conversion coef. with size_correction */
-	c = size_correction*vp_map;
+	c = size_correction*md->vp_map;
 	cc = c*c;
 
 /* from larynx to buccal */
@@ -367,8 +558,8 @@ void	sagittal_to_area (
 	   d  = 0.5f*(float)sqrt(x1*x1 + y1*y1);
 	   w  = c*(s1 + s2)/d;
 	   af[i-1].x = c*d;
-	   j  = i + iniva_tng - 3;
-	   af[i-1].A = (float)(1.4*alph[j]*pow(w, beta[j])); /* 40% ad hoc increase */
+	   j  = i + sp->iniva_tng - 3;
+	   af[i-1].A = (float)(1.4*sp->alph[j]*pow(w, sp->beta[j])); /* 40% ad hoc increase */
 	}
 /* lips (2 sections with the equel length) */
 	af[np-2].A = af[np-1].A = pi * lip_h * lip_w * cc;
@@ -384,6 +575,23 @@ void	sagittal_to_area (
 	}
 }
 
+/*****
+*	Function : sagittal_to_area
+*	Note :	Same as sagittal_to_area_r for the VT profile left in the
+*		globals by lam, with the default model.
+*****/
+void	sagittal_to_area ( short *ns, area_function *af )
+{
+	static	vt_profile	vp;
+
+	vp.np = np;
+	memcpy( vp.ivt, ivt, np*sizeof(float2D) );
+	memcpy( vp.evt, evt, np*sizeof(float2D) );
+	vp.lip_h = lip_h;
+	vp.lip_w = lip_w;
+	sagittal_to_area_r( &model0, &vp, ns, af );
+}
+
 /*****
 *	Function : appro_area_function
 *	Note :	Approximate the area function from LAM, in which the section
@@ -412,7 +620,7 @@ void	appro_area_function (
 	i = j = 0;
 	while( i < ns2 )
 	{  x += dx;
-	   while( z2 <= x )
+	   while( j < ns1 && z2 <= x )
 	   {  z1 = z2; z2 += af1[j].x;
 	      s1 = s2; s2 += af1[j].x*af1[j].A;
 	      if( ++j == ns1 ) break;
@@ -451,212 +659,613 @@ void print_af (short ns, area_function *af) {
 void	skiplines( FILE *in, short nlines )
 {
 	short	i;
-	for(i=0; i<nlines; i++) while( fgetc(in) != '\n' );
+	int	c;
+	for(i=0; i<nlines; i++)
+	   do c = fgetc(in); while( c != '\n' && c != EOF );
 }
 
+/*****
+*	Function : read_floats
+*	Note :	Reads n values, one per line.  Returns the number of
+*		values which could not be read.
+*****/
+static	short	read_floats( FILE *in, short n, float *v )
+{
+	short	i, bad = 0;
+	for(i=0; i<n; i++) bad += fscanf(in, "%f\n", &v[i]) != 1;
+	return( bad );
+}
 
 /*****
-*	Function : read_model_spec
-*	Note :	Reads specifications for a linear articulatory model from
-*		a text file (PB1_spec.dat).  Only items needed for the
-*		model are read.
+*	Function : read_factors
+*	Note :	Reads the block of an articulator, from its header line
+*		to its loadings: nvrs variables, nfac factors of which
+*		the first is the jaw.  Returns the number of values which
+*		could not be read, or -1 if the block has not enough
+*		factors or too many variables.
 *****/
-void	read_model_spec( void )
+static	short	read_factors(
+	FILE	*in,
+	short	nfac,		/* factors used by the model	*/
+	short	maxvrs,		/* size of the arrays		*/
+	short	*nvrs,
+	short	*iniva,
+	short	*lstva,
+	float	*u,
+	float	*s,
+	float	*A,		/* nvrs x nfac			*/
+	float	*inci )		/* incisor (lips only) or NULL	*/
 {
-	FILE	*in;
-	short	nfs, nafs;
-	short	i, j, dummy;
-	char	vlab_dummy[3];
+	short	i, jaw, nfs, nafs, bad = 0;
+	char	lab[8];
 
-/* open file */
-	if((in = fopen( "pb1_spec.dat", "rt")) == NULL)
-	{  printf("Impossible to open the input file.\n");
-	//	   getch();
-	   exit(1);
-	}
+	skiplines( in, 2 );
+	if( fscanf(in, "%hd %hd %hd %hd %hd %hd\n",
+		   nvrs, &jaw, iniva, lstva, &nfs, &nafs) != 6 ) return( 1 );
+	if( jaw != JAW || nfs < nfac || *nvrs < 1 || *nvrs > maxvrs
+	 || nafs < 0 ) return( -1 );
 
-/* semi-polar coordinate specs. */
-	skiplines( in, 9 );
-	fscanf(in, "%hd %hd %hd %f %f %f %hd %hd\n",
-		    &m1, &m2, &m3, &dl, &omega, &theta, &ix0, &iy0 );
+	skiplines( in, nafs + 2 );
+	for(i=0; i<*nvrs; i++) bad += fscanf(in, "%7s\n", lab) != 1;
 
 	skiplines( in, 1 );
-	fscanf(in, "%f %f\n", &TEKvt, &TEKlip);
+	for(i=0; i<nfac; i++)  bad += fscanf(in, "%7s\n", lab) != 1;
+
+	skiplines( in, 2 );
+	bad += read_floats( in, *nvrs, u );
 
 	skiplines( in, 1 );
-	for(i=0; i<m1+m2+m3; i++)
-	   fscanf(in, "%hd %f %f\n", &dummy, &alph[i], &beta[i]);
+	bad += read_floats( in, *nvrs, s );
 
-/* Lip specifications */
-	skiplines( in, 2 );
-	fscanf(in, "%hd %hd %hd %hd %hd %hd\n",
-	&nvrs_lip, &jaw_lip, &dummy, &dummy, &nfs, &nafs);
-	if( jaw_lip != JAW || nfs < JAW+LIP )
-	{  printf("Not enough factors in the lip spec..");
-	   exit(1);
+	if( inci != NULL )
+	{  skiplines( in, 1 );
+	   bad += fscanf(in, "%f %f\n", &inci[0], &inci[1]) != 2;
+	   skiplines( in, 2 );
+	}
+	skiplines( in, 1 );
+	for(i=0; i<*nvrs; i++)
+	{  bad += read_floats( in, nfac, A + i*nfac );
+	   skiplines( in, 1 );
 	}
 
-	skiplines( in, nafs + 2 );
-	for(i=0; i<nvrs_lip; i++) fscanf(in, "%s\n", vlab_dummy);
+	skiplines( in, 1 + *nvrs );
+	return( bad );
+}
 
-	skiplines( in, 1 );
-	for(i=0; i<JAW+LIP; i++)  fscanf(in, "%s\n", flab_lip[i]);
+/*****
+*	Function : read_model_spec_r
+*	Note :	Reads specifications for a linear articulatory model from
+*		a text file (PB1_spec.dat) into sp.  Only items needed for
+*		the model are read.  Returns SPEC_OK, or SPEC_EFILE,
+*		SPEC_EFORMAT or SPEC_ERANGE; sp is then undefined.
+*****/
+short	read_model_spec_r( const char *path, lam_spec *sp )
+{
+	FILE	*in;
+	short	i, dummy, bad = 0, r;
+	short	iniva, lstva;
+	float	inci[2] = { 0, 0 };
+	char	lab[8];
 
-	skiplines( in, 2 );
-	for(i=0; i<nvrs_lip; i++) fscanf(in, "%f\n", &u_lip[i]);
+	memset( sp, 0, sizeof(lam_spec) );
+	if((in = fopen( path, "rt")) == NULL) return( SPEC_EFILE );
+
+/* semi-polar coordinate specs. */
+	skiplines( in, 9 );
+	bad += fscanf(in, "%hd %hd %hd %f %f %f %hd %hd\n", &sp->m1, &sp->m2,
+		      &sp->m3, &sp->dl, &sp->omega, &sp->theta, &sp->ix0,
+		      &sp->iy0 ) != 8;
 
 	skiplines( in, 1 );
-	for(i=0; i<nvrs_lip; i++) fscanf(in, "%f\n", &s_lip[i]);
+	bad += fscanf(in, "%f %f\n", &sp->TEKvt, &sp->TEKlip) != 2;
 
 	skiplines( in, 1 );
-	fscanf(in, "%f %f\n", &inci_x, &inci_y);
+	if( bad == 0 && (sp->m1 < 0 || sp->m2 < 1 || sp->m3 < 0
+			 || sp->m1+sp->m2+sp->m3 > M4) )
+	{  fclose(in);
+	   return( SPEC_ERANGE );
+	}
+	for(i=0; bad == 0 && i<sp->m1+sp->m2+sp->m3; i++)
+	   bad += fscanf(in, "%hd %f %f\n", &dummy, &sp->alph[i], &sp->beta[i]) != 3;
+
+/* Lip, tongue and larynx */
+	r = bad ? 1 :
+	    read_factors( in, JAW+LIP, NVRS_LIP, &sp->nvrs_lip, &iniva, &lstva,
+			  sp->u_lip, sp->s_lip, sp->A_lip[0], inci );
+	sp->inci_x = inci[0];
+	sp->inci_y = inci[1];
+	if( r == 0 )
+	   r = read_factors( in, JAW+TNG, NVRS_TNG, &sp->nvrs_tng,
+			     &sp->iniva_tng, &sp->lstva_tng,
+			     sp->u_tng, sp->s_tng, sp->A_tng[0], NULL );
+	sp->iniva_tng--;	/* coordinate address for C, now same as lable */
+	sp->lstva_tng--;
+	if( r == 0 )
+	   r = read_factors( in, JAW+LRX, NVRS_LRX, &sp->nvrs_lrx, &iniva, &lstva,
+			     sp->u_lrx, sp->s_lrx, sp->A_lrx[0], NULL );
 
-	skiplines( in, 3 );
-	for(i=0; i<nvrs_lip; i++)
-	{  for(j=0; j<JAW+LIP; j++) fscanf(in, "%f\n", &A_lip[i][j]);
-	   skiplines( in, 1 );
+/* Wall */
+	if( r == 0 )
+	{  skiplines( in, 2 );
+	   if( fscanf(in, "%hd %hd %hd %hd %hd %hd\n", &sp->nvrs_wal, &dummy,
+		      &iniva, &lstva, &dummy, &i) != 6 ) r = 1;
+	   else if( sp->nvrs_wal < 1 || sp->nvrs_wal > NVRS_WAL || i < 0 ) r = -1;
+	   else
+	   {  skiplines( in, i + 2 );
+	      for(i=0; i<sp->nvrs_wal; i++)
+		 r += fscanf(in, "%7s\n", lab) != 1;
+	      skiplines( in, 3 );
+	      r += read_floats( in, sp->nvrs_wal, sp->u_wal );
+	   }
 	}
+	fclose(in);
 
-	skiplines( in, 1 + nvrs_lip );
+	if( r < 0 ) return( SPEC_ERANGE );
+	if( r > 0 ) return( SPEC_EFORMAT );
+	return( lam_spec_check( sp ) );
+}
 
-/* Tongue */
-	skiplines( in, 2 );
-	fscanf(in, "%hd %hd %hd %hd %hd %hd\n",
-	&nvrs_tng, &jaw_tng, &iniva_tng, &lstva_tng, &nfs, &nafs);
-	if( jaw_tng != JAW || nfs < JAW+TNG )
-	{  printf("Not enough factors in the tongue spec..");
-	   exit(1);
-	}
-	iniva_tng--;	/* coordinate address for C, now same as lable */
-	lstva_tng--;
+/*****
+*	Function : lam_spec_check
+*	Note :	Checks that the dimensions of sp fit the arrays of
+*		lam_lib.  Returns SPEC_OK or SPEC_ERANGE.
+*****/
+short	lam_spec_check( const lam_spec *sp )
+{
+	short	nw = sp->lstva_tng - sp->iniva_tng;
+
+	if( sp->m1 < 0 || sp->m2 < 1 || sp->m3 < 0 || sp->m1+sp->m2+sp->m3 > M4
+	 || sp->nvrs_lip < JAW+3  || sp->nvrs_lip > NVRS_LIP
+	 || sp->nvrs_tng < 1      || sp->nvrs_tng > NVRS_TNG
+	 || sp->nvrs_lrx < JAW+4  || sp->nvrs_lrx > NVRS_LRX
+	 || sp->nvrs_wal < 1      || sp->nvrs_wal > NVRS_WAL
+	 || sp->iniva_tng < 2     || sp->lstva_tng > sp->m1+sp->m2+sp->m3
+	 || nw < 1 || nw > sp->nvrs_wal || nw+JAW > sp->nvrs_tng || nw+4 > NP )
+	   return( SPEC_ERANGE );
+	return( SPEC_OK );
+}
 
-	skiplines( in, nafs + 2 );
-	for(i=0; i<nvrs_tng; i++) fscanf(in, "%s\n", vlab_dummy);
+/*****
+*	Function : lam_spec_get
+*	Note :	Copies the model in use (the built-in one, or the one
+*		installed by lam_spec_set) into sp, in TEK units.
+*****/
+void	lam_spec_get( lam_spec *sp )
+{
+	memset( sp, 0, sizeof(lam_spec) );
+	sp->m1 = m1;   sp->m2 = m2;   sp->m3 = m3;
+	sp->ix0 = ix0; sp->iy0 = iy0;
+	sp->dl = dl;   sp->omega = omega;   sp->theta = theta;
+	sp->TEKvt = TEKvt;   sp->TEKlip = TEKlip;
+	memcpy( sp->alph, alph, sizeof(alph) );
+	memcpy( sp->beta, beta, sizeof(beta) );
+
+	sp->nvrs_lip = nvrs_lip;
+	memcpy( sp->u_lip, u_lip, sizeof(u_lip) );
+	memcpy( sp->s_lip, s_lip, sizeof(s_lip) );
+	memcpy( sp->A_lip, A_lip, sizeof(A_lip) );
+	sp->inci_x = inci_x;   sp->inci_y = inci_y;
+
+	sp->nvrs_tng = nvrs_tng;
+	sp->iniva_tng = iniva_tng;   sp->lstva_tng = lstva_tng;
+	memcpy( sp->u_tng, u_tng, sizeof(u_tng) );
+	memcpy( sp->s_tng, s_tng, sizeof(s_tng) );
+	memcpy( sp->A_tng, A_tng, sizeof(A_tng) );
+
+	sp->nvrs_lrx = nvrs_lrx;
+	memcpy( sp->u_lrx, u_lrx, sizeof(u_lrx) );
+	memcpy( sp->s_lrx, s_lrx, sizeof(s_lrx) );
+	memcpy( sp->A_lrx, A_lrx, sizeof(A_lrx) );
+
+	sp->nvrs_wal = nvrs_wal;
+	memcpy( sp->u_wal, u_wal, sizeof(u_wal) );
+}
 
-	skiplines( in, 1 );
-	for(i=0; i<JAW+TNG; i++)  fscanf(in, "%s\n", flab_tng[i]);
+/*****
+*	Function : lam_spec_set
+*	Note :	Installs the model sp in place of the one in use; the
+*		default model is made again from it at the next
+*		convert_scale.  Returns SPEC_OK, or SPEC_ERANGE and the
+*		model in use is left as it is.
+*****/
+short	lam_spec_set( const lam_spec *sp )
+{
+	if( lam_spec_check( sp ) != SPEC_OK ) return( SPEC_ERANGE );
+
+	m1 = sp->m1;   m2 = sp->m2;   m3 = sp->m3;
+	ix0 = sp->ix0; iy0 = sp->iy0;
+	dl = sp->dl;   omega = sp->omega;   theta = sp->theta;
+	TEKvt = sp->TEKvt;   TEKlip = sp->TEKlip;
+	memcpy( alph, sp->alph, sizeof(alph) );
+	memcpy( beta, sp->beta, sizeof(beta) );
+
+	nvrs_lip = sp->nvrs_lip;
+	memcpy( u_lip, sp->u_lip, sizeof(u_lip) );
+	memcpy( s_lip, sp->s_lip, sizeof(s_lip) );
+	memcpy( A_lip, sp->A_lip, sizeof(A_lip) );
+	inci_x = sp->inci_x;   inci_y = sp->inci_y;
+
+	nvrs_tng = sp->nvrs_tng;
+	iniva_tng = sp->iniva_tng;   lstva_tng = sp->lstva_tng;
+	memcpy( u_tng, sp->u_tng, sizeof(u_tng) );
+	memcpy( s_tng, sp->s_tng, sizeof(s_tng) );
+	memcpy( A_tng, sp->A_tng, sizeof(A_tng) );
+
+	nvrs_lrx = sp->nvrs_lrx;
+	memcpy( u_lrx, sp->u_lrx, sizeof(u_lrx) );
+	memcpy( s_lrx, sp->s_lrx, sizeof(s_lrx) );
+	memcpy( A_lrx, sp->A_lrx, sizeof(A_lrx) );
+
+	nvrs_wal = sp->nvrs_wal;
+	memcpy( u_wal, sp->u_wal, sizeof(u_wal) );
+	lam_spec_changed();
+	return( SPEC_OK );
+}
 
-	skiplines( in, 2 );
-	for(i=0; i<nvrs_tng; i++) fscanf(in, "%f\n", &u_tng[i]);
+/*****
+*	Function : lam_spec_changed
+*	Note :	Tells that the spec in use was changed other than by
+*		lam_spec_set, e.g., alph, beta or u_wal written from the
+*		Python module, so that convert_scale makes the default
+*		model again.
+*****/
+void	lam_spec_changed( void )
+{
+	spec_serial++;
+}
 
-	skiplines( in, 1 );
-	for(i=0; i<nvrs_tng; i++) fscanf(in, "%f\n", &s_tng[i]);
+/*****
+*	Function : read_model_spec
+*	Note :	Reads pb1_spec.dat, in the current directory, in place of
+*		the model in use (see read_model_spec_r and lam_spec_set).
+*****/
+short	read_model_spec( void )
+{
+	lam_spec	sp;
+	short	r;
 
-	skiplines( in, 1 );
-	for(i=0; i<nvrs_tng; i++)
-	{  for(j=0; j<JAW+TNG; j++) fscanf(in, "%f\n", &A_tng[i][j]);
-	   skiplines( in, 1 );
-	}
+	if( (r = read_model_spec_r( "pb1_spec.dat", &sp )) != SPEC_OK ) return( r );
+	return( lam_spec_set( &sp ) );
+}
 
-	skiplines( in, 1 + nvrs_tng );
+/*********************( binary model specification )**********************/
 
-/* Larynx */
-	skiplines( in, 2 );
-	fscanf(in, "%hd %hd %hd %hd %hd %hd\n",
-	&nvrs_lrx, &jaw_lrx, &iniva_lrx, &lstva_lrx, &nfs, &nafs);
-	if( jaw_lrx != JAW || nfs < JAW+LRX )
-	{  printf("No enough factors in the larynx spec..");
-	   exit(1);
-	}
+/*****
+*	Function : lam_spec_error
+*	Note :	A message for a value returned by the functions above.
+*****/
+const	char	*lam_spec_error( short r )
+{
+	static	const	char	*msg[] = { "no error",
+		"file could not be opened, read or written",
+		"not a model specification, or truncated",
+		"model file of another version",
+		"model file corrupted (checksum)",
+		"model dimensions beyond those of lam_lib",
+		"not enough memory" };
+
+	return( r <= 0 && r >= SPEC_EMEMORY ? msg[-r] : "unknown error" );
+}
 
-	skiplines( in, nafs + 2 );
-	for(i=0; i<nvrs_lrx; i++) fscanf(in, "%s\n", vlab_dummy);
+#define	SPEC_HEADER	16	/* bytes before the lam_spec in the file */
 
-	skiplines( in, 1 );
-	for(i=0; i<JAW+LRX; i++)  fscanf(in, "%s\n", flab_lrx[i]);
+static	const	char	spec_magic[4] = { 'L', 'A', 'M', 'S' };
 
-	skiplines( in, 2 );
-	for(i=0; i<nvrs_lrx; i++) fscanf(in, "%f\n", &u_lrx[i]);
+static	short	little_endian( void )
+{
+	short	one = 1;
+	return( *(char *)&one );
+}
 
-	skiplines( in, 1 );
-	for(i=0; i<nvrs_lrx; i++) fscanf(in, "%f\n", &s_lrx[i]);
+/*****
+*	Function : spec_swap
+*	Note :	Reverses the bytes of each field of sp: the shorts up to
+*		dl, then the floats.
+*****/
+static	void	spec_swap( lam_spec *sp )
+{
+	unsigned char	*b = (unsigned char *)sp, t;
+	size_t	i, nf = offsetof(lam_spec, dl);
 
-	skiplines( in, 1 );
-	for(i=0; i<nvrs_lrx; i++)
-	{  for(j=0; j<JAW+LRX; j++) fscanf(in, "%f\n", &A_lrx[i][j]);
-	   skiplines( in, 1 );
+	for(i=0; i<nf; i+=2)
+	{  t = b[i]; b[i] = b[i+1]; b[i+1] = t;
+	}
+	for(i=nf; i<sizeof(lam_spec); i+=4)
+	{  t = b[i];   b[i]   = b[i+3]; b[i+3] = t;
+	   t = b[i+1]; b[i+1] = b[i+2]; b[i+2] = t;
 	}
+}
 
-	skiplines( in, 1 + nvrs_lrx );
+static	unsigned long	spec_checksum( const unsigned char *b, size_t n )
+{
+	unsigned long	h = 2166136261UL;	/* FNV-1a, 32 bits */
+	size_t	i;
 
-/* Wall */
-	skiplines( in, 2 );
-	fscanf(in, "%hd %hd %hd %hd %hd %hd\n",
-	&nvrs_wal, &jaw_wal, &iniva_wal, &lstva_wal, &nfs, &nafs);
-	iniva_wal--;	/* coordinate address for C, now same as lable */
-	lstva_wal--;
+	for(i=0; i<n; i++) h = ((h ^ b[i])*16777619UL) & 0xffffffffUL;
+	return( h );
+}
 
-	skiplines( in, nafs + 2 );
-	for(i=0; i<nvrs_wal; i++) fscanf(in, "%s\n", vlab_dummy);
+static	void	put_u32( unsigned char *b, unsigned long v )
+{
+	b[0] = (unsigned char)v;	 b[1] = (unsigned char)(v >> 8);
+	b[2] = (unsigned char)(v >> 16); b[3] = (unsigned char)(v >> 24);
+}
 
-	skiplines( in, 3 );
-	for(i=0; i<nvrs_wal; i++) fscanf(in, "%f\n", &u_wal[i]);
+static	unsigned long	get_u32( const unsigned char *b )
+{
+	return( b[0] | (unsigned long)b[1] << 8 | (unsigned long)b[2] << 16
+		| (unsigned long)b[3] << 24 );
+}
 
-	fclose(in);
+/*****
+*	Function : lam_spec_checksum
+*	Note :	The checksum of sp in the binary model file (see
+*		lam_spec), which tells a model from another, e.g. in the
+*		headers of the files computed with it.
+*****/
+unsigned long	lam_spec_checksum( const lam_spec *sp )
+{
+	lam_spec	le;
+
+	le = *sp;
+	le.pad = 0;
+	if( !little_endian() ) spec_swap( &le );
+	return( spec_checksum( (unsigned char *)&le, sizeof(lam_spec) ) );
+}
+
+/*****
+*	Function : lam_spec_write
+*	Note :	Writes sp as a binary model file (see lam_spec).  Returns
+*		SPEC_OK, SPEC_ERANGE or SPEC_EFILE.
+*****/
+short	lam_spec_write( const lam_spec *sp, const char *path )
+{
+	lam_spec	le;
+	unsigned char	h[SPEC_HEADER];
+	FILE	*out;
+	short	ok;
+
+	if( lam_spec_check( sp ) != SPEC_OK ) return( SPEC_ERANGE );
+	le = *sp;
+	le.pad = 0;
+	if( !little_endian() ) spec_swap( &le );
+
+	memcpy( h, spec_magic, 4 );
+	put_u32( h+4,  LAM_SPEC_VERSION );
+	put_u32( h+8,  sizeof(lam_spec) );
+	put_u32( h+12, lam_spec_checksum( sp ) );
+
+	if((out = fopen( path, "wb")) == NULL) return( SPEC_EFILE );
+	ok = fwrite( h, SPEC_HEADER, 1, out ) == 1
+	  && fwrite( &le, sizeof(lam_spec), 1, out ) == 1;
+	if( fclose(out) ) ok = 0;
+	return( ok ? SPEC_OK : SPEC_EFILE );
+}
+
+/*****
+*	Function : lam_spec_open
+*	Note :	Opens a binary model file.  On a little-endian machine
+*		the file is mapped read-only and f->spec points into the
+*		mapping, so that the processes which open the same file
+*		share its pages; otherwise (or without mmap) f->spec is
+*		a converted copy.  Returns SPEC_OK, or one of the errors
+*		SPEC_EFILE ... SPEC_EMEMORY and f is then cleared.
+*****/
+short	lam_spec_open( lam_spec_file *f, const char *path )
+{
+	const	unsigned char	*h;
+	lam_spec	*sp;
+	FILE	*in;
+	long	n;
+	short	r = SPEC_OK;
+
+	memset( f, 0, sizeof(lam_spec_file) );
+	if((in = fopen( path, "rb")) == NULL) return( SPEC_EFILE );
+	if( fseek( in, 0L, SEEK_END ) || (n = ftell( in )) < 0 )
+	{  fclose( in );
+	   return( SPEC_EFILE );
+	}
+	f->length = (size_t)n;
+	if( f->length != SPEC_HEADER + sizeof(lam_spec) )
+	{  fclose( in );
+	   return( SPEC_EFORMAT );
+	}
+
+#ifdef	LAM_MMAP
+	if( little_endian() )
+	{  f->base = mmap( NULL, f->length, PROT_READ, MAP_SHARED, fileno(in), 0 );
+	   if( f->base == MAP_FAILED ) f->base = NULL;
+	   else f->mapped = 1;
+	}
+#endif
+	if( f->base == NULL )
+	{  if( (f->base = malloc( f->length )) == NULL ) r = SPEC_EMEMORY;
+	   else if( fseek( in, 0L, SEEK_SET )
+		 || fread( f->base, f->length, 1, in ) != 1 ) r = SPEC_EFILE;
+	}
+	fclose( in );
+
+	if( r == SPEC_OK )
+	{  h  = (const unsigned char *)f->base;
+	   sp = (lam_spec *)(h + SPEC_HEADER);
+	   if( memcmp( h, spec_magic, 4 ) || get_u32( h+8 ) != sizeof(lam_spec) )
+	      r = SPEC_EFORMAT;
+	   else if( get_u32( h+4 ) != LAM_SPEC_VERSION ) r = SPEC_EVERSION;
+	   else if( get_u32( h+12 ) !=
+		    spec_checksum( (const unsigned char *)sp, sizeof(lam_spec) ) )
+	      r = SPEC_ECHECKSUM;
+	   else
+	   {  if( !little_endian() ) spec_swap( sp );	/* a copy */
+	      f->spec = sp;
+	      r = lam_spec_check( sp );
+	   }
+	}
+	if( r != SPEC_OK ) lam_spec_close( f );
+	return( r );
+}
+
+void	lam_spec_close( lam_spec_file *f )
+{
+#ifdef	LAM_MMAP
+	if( f->mapped ) munmap( f->base, f->length );
+	else
+#endif
+	free( f->base );
+	memset( f, 0, sizeof(lam_spec_file) );
 }
 
 /*************************( plotting functions )**************************/
 /*****
-*	Function : convert_scale
+*	Function : convert_model
 *	Note :	Convert the cm-TEK unit mapping coefs., TEKvt and TEKlip,
 *		and change the center coordinate (ix0, iy0), in order to
 *		plot the genetated VT contours inside the specified
 *		viewport.  Mean and standard deviation in TEK unit are
 *		converted into the viewport unit. A viewport mapping coef.,
 *		vp_map, is defined as its width corresponds to vp_width_cm
-*		cm.
+*		cm.  The spec of md, a copy made by lam_model_ini, is
+*		converted in place, once.
 *****/
 #define DWIDTH	10*20		/* display width in pixels */
 #define DHEIGHT	10*20		/* display height in pixels */
 
-void	convert_scale ( void )
+static	void	convert_model ( lam_model *md )
 {
+	lam_spec	*sp = &md->sp;
 	short	i;
-	short done_flag=0;
 
 /* viewport-to-cm scale factors (mapping coefficient) */
-	vp_map = vp_width_cm/(DWIDTH/10);
+	md->vp_map = vp_width_cm/(DWIDTH/10);
 
 /* Modify TEK-to-cm to TEK-to-viewport scale factor */
-	TEKvt  = TEKvt*vp_map;
-	if( TEKlip == 0. ) TEKlip = TEKvt;
-	else               TEKlip = TEKlip*vp_map;
+	sp->TEKvt  = sp->TEKvt*md->vp_map;
+	if( sp->TEKlip == 0. ) sp->TEKlip = sp->TEKvt;
+	else               sp->TEKlip = sp->TEKlip*md->vp_map;
 
 /* convert absolute mean maxillary incisor position to that relative
    to the semi-polar coordinate center, and to in viewport unit */
-	inci_x = (inci_x - ix0)/TEKvt;
-	inci_y = (inci_y - iy0)/TEKvt;
+	sp->inci_x = (sp->inci_x - sp->ix0)/sp->TEKvt;
+	sp->inci_y = (sp->inci_y - sp->iy0)/sp->TEKvt;
 
 /* convert din in cm to in vp-unit */
-	inci_lip_vp = inci_lip/vp_map;
+	md->inci_lip_vp = inci_lip/md->vp_map;
 
 /* convert TEK-unit to the viewport unit */
 	for(i=0; i<2; i++)              /* jaw and lip protrusion */
-	{  u_lip[i] = u_lip[i]/TEKvt;
-	   s_lip[i] = s_lip[i]/TEKvt;
+	{  sp->u_lip[i] = sp->u_lip[i]/sp->TEKvt;
+	   sp->s_lip[i] = sp->s_lip[i]/sp->TEKvt;
 	}
-	for(i=2; i<nvrs_lip; i++)	/* front lip height and width */
-	{  u_lip[i] = u_lip[i]/TEKlip;
-	   s_lip[i] = s_lip[i]/TEKlip;
+	for(i=2; i<sp->nvrs_lip; i++)	/* front lip height and width */
+	{  sp->u_lip[i] = sp->u_lip[i]/sp->TEKlip;
+	   sp->s_lip[i] = sp->s_lip[i]/sp->TEKlip;
 	}
-	for(i=0; i<nvrs_tng; i++)	/* tongue profile */
-	{  u_tng[i] = u_tng[i]/TEKvt;
-	   s_tng[i] = s_tng[i]/TEKvt;
+	for(i=0; i<sp->nvrs_tng; i++)	/* tongue profile */
+	{  sp->u_tng[i] = sp->u_tng[i]/sp->TEKvt;
+	   sp->s_tng[i] = sp->s_tng[i]/sp->TEKvt;
 	}
-	for(i=0; i<nvrs_lrx; i++)	/* larynx profile */
-	{  u_lrx[i] = u_lrx[i]/TEKvt;
-	   s_lrx[i] = s_lrx[i]/TEKvt;
+	for(i=0; i<sp->nvrs_lrx; i++)	/* larynx profile */
+	{  sp->u_lrx[i] = sp->u_lrx[i]/sp->TEKvt;
+	   sp->s_lrx[i] = sp->s_lrx[i]/sp->TEKvt;
 	}
 
-	if (done_flag == 0) {
-	for(i=0; i<nvrs_wal; i++)	/* vt rear wall profile */
-	   u_wal[i] = u_wal[i]/TEKvt;
-	done_flag=1;
-	}
+	for(i=0; i<sp->nvrs_wal; i++)	/* vt rear wall profile */
+	   sp->u_wal[i] = sp->u_wal[i]/sp->TEKvt;
 
 /* new coordinate center in the viewport */
-	ix0 = 0.6*(DWIDTH/10);
-	iy0 = 0.6*(DHEIGHT/10);
+	sp->ix0 = 0.6*(DWIDTH/10);
+	sp->iy0 = 0.6*(DHEIGHT/10);
+}
+
+/*****
+*	Function : lam_model_ini
+*	Note :	Makes md a model ready for lam_r from the spec sp, which
+*		is copied.  The model is only read afterwards, so that
+*		any number of voices and threads may share it.  Returns
+*		SPEC_OK or SPEC_ERANGE.
+*****/
+short	lam_model_ini( lam_model *md, const lam_spec *sp )
+{
+	if( lam_spec_check( sp ) != SPEC_OK ) return( SPEC_ERANGE );
+	memset( md, 0, sizeof(lam_model) );
+	md->sp = *sp;
+	md->sum = lam_spec_checksum( sp );
+	convert_model( md );
+	semi_polar_r( md );
+	return( SPEC_OK );
+}
+
+/*****
+*	Function : lam_model_load
+*	Note :	lam_model_ini for the spec in the file path, binary (see
+*		lam_spec_open) or text (see read_model_spec_r).  Returns
+*		SPEC_OK or the error of the format the file seems to be.
+*****/
+short	lam_model_load( lam_model *md, const char *path )
+{
+	lam_spec_file	f;
+	lam_spec	sp;
+	short	r;
+
+	r = lam_spec_open( &f, path );
+	if( r == SPEC_OK )
+	{  r = lam_model_ini( md, f.spec );
+	   lam_spec_close( &f );
+	   return( r );
+	}
+	if( r != SPEC_EFORMAT ) return( r );
+	if( (r = read_model_spec_r( path, &sp )) != SPEC_OK ) return( r );
+	return( lam_model_ini( md, &sp ) );
+}
+
+/*****
+*	Function : convert_scale
+*	Note :	Makes the default model, used by lam, sagittal_to_area and
+*		lam_default, from the spec in use (the built-in one, or
+*		that of read_model_spec or lam_spec_set).  The spec in use
+*		is not changed, and the model is only made again after
+*		the spec has changed (see lam_spec_changed), so that a
+*		call costs nothing otherwise.  An invalid spec leaves the
+*		previous model in place.
+*****/
+void	convert_scale ( void )
+{
+	lam_spec	sp;
+
+	if( model0_serial == spec_serial ) return;
+	lam_spec_get( &sp );
+	if( lam_model_ini( &model0, &sp ) == SPEC_OK ) model0_serial = spec_serial;
+}
+
+/*****
+*	Function : semi_polar
+*	Note :	The semi-polar grid of the default model, which
+*		convert_scale computes as well.
+*****/
+void	semi_polar ( void )
+{
+	semi_polar_r( &model0 );
+}
+
+/*****
+*	Function : lam_setup
+*	Note :	convert_scale.  Call it before lam_r and sagittal_to_area_r
+*		are used from several threads with the default model; they
+*		only read it afterwards, as long as the spec in use is not
+*		changed.
+*****/
+void	lam_setup ( void )
+{
+	convert_scale();
+}
+
+/*****
+*	Function : lam_default
+*	Note :	The default model, set up (lam_setup) if need be.
+*****/
+const	lam_model	*lam_default ( void )
+{
+	lam_setup();
+	return( &model0 );
 }
 
 
@@ -711,9 +1320,9 @@ void	plot_semi_polar ( short nvp )
 	short	i;
 
 	vp_height = pixtolo_y(vp[nvp].h);
-	for(i=0; i<m1+m2+m3; i++)
-	{  mov( igd[i].x, vp_height - igd[i].y );
-	   drw( egd[i].x, vp_height - egd[i].y );
+	for(i=0; i<model0.sp.m1+model0.sp.m2+model0.sp.m3; i++)
+	{  mov( model0.igd[i].x, vp_height - model0.igd[i].y );
+	   drw( model0.egd[i].x, vp_height - model0.egd[i].y );
 	}
 }
 
@@ -6,21 +6,121 @@
 *	Note :	The definition of structures and prototypes.
 ********/
 
+#include <stddef.h>
 #include "vtconfig.h"
 #define NP	 29	/* = np        */
 
+/* Number of articulatory parameters */
+
+#define	JAW	1	/* number of jaw parameter */
+#define	LIP	2	/* number of intrinsic lip parameters (HT and PR) */
+#define	TNG	3	/* number of intrinsic tongue parameters */
+#define	LRX	1	/* number of intrinsic larynx parameter (height) */
+
+/* Number of variables (for arrays) */
+
+#define	M4	 31	/* =m1 + m2 + m3, total number of semi-polar grids */
+#define	NVRS_LIP  4	/* = nvrs_lip  */
+#define	NVRS_TNG 26	/* = nvrs_tng  */
+#define	NVRS_LRX  5	/* = nvrs_lrx  */
+#define NVRS_WAL 25	/* = nvrs_wal  */
+
 typedef	struct{ short x, y;} int2D;
 typedef	struct{ float x, y;} float2D;
 
+typedef	struct{				/* a VT profile computed by lam_r */
+	short	np;			/* number of points               */
+	float2D	ivt[NP];		/* VT inside contours             */
+	float2D	evt[NP];		/* VT exterior contours           */
+	float	lip_h, lip_w;		/* lip-tube height and width      */
+} vt_profile;
+
 extern float2D	ivt[NP];		/* VT inside contours             */
 extern float2D	evt[NP];		/* VT exterior contours           */
 
+/*****
+*	The specification of a model (pb1_spec.dat), in TEK units, with
+*	iniva_* and lstva_* as C indices.  The binary model file
+*	(lam_spec_write) holds this structure as it is, little-endian,
+*	after a header of 16 bytes: "LAMS", the version, the size of the
+*	structure and its checksum (32-bit FNV-1a), each 4 bytes.  The
+*	file can thus be mapped read-only (lam_spec_open) and shared by
+*	several processes.
+*****/
+
+#define	LAM_SPEC_VERSION	1
+
+typedef	struct{
+	short	m1, m2, m3;		/* semi-polar grid		  */
+	short	ix0, iy0;		/* its origin in TEK space	  */
+	short	nvrs_lip, nvrs_tng, nvrs_lrx, nvrs_wal;
+	short	iniva_tng, lstva_tng;	/* tongue points on the grid	  */
+	short	pad;			/* (floats on 4 bytes)		  */
+	float	dl, omega, theta;
+	float	TEKvt, TEKlip;		/* cm to TEK unit (points/cm)	  */
+	float	alph[M4], beta[M4];	/* sagittal-to-area coefficients  */
+	float	u_lip[NVRS_LIP], s_lip[NVRS_LIP], A_lip[NVRS_LIP][JAW+LIP];
+	float	inci_x, inci_y;		/* mean maxillary incisor	  */
+	float	u_tng[NVRS_TNG], s_tng[NVRS_TNG], A_tng[NVRS_TNG][JAW+TNG];
+	float	u_lrx[NVRS_LRX], s_lrx[NVRS_LRX], A_lrx[NVRS_LRX][JAW+LRX];
+	float	u_wal[NVRS_WAL];	/* rear wall			  */
+} lam_spec;
+
+typedef	struct{				/* a model file opened by	  */
+	const	lam_spec	*spec;	/* lam_spec_open		  */
+	void	*base;			/* the mapping, or a copy	  */
+	size_t	length;
+	short	mapped;
+} lam_spec_file;
+
+/*****
+*	A model ready for lam_r (lam_model_ini): the spec converted to
+*	viewport units, and the semi-polar grid.
+*****/
+typedef	struct{
+	lam_spec	sp;		/* the spec in viewport units	  */
+	unsigned long	sum;		/* lam_spec_checksum of the spec  */
+					/* it was made from		  */
+	float	vp_map;			/* viewport map coef. (cm/point)  */
+	float	inci_lip_vp;		/* inci_lip in viewport unit      */
+	float2D	igd[M4], egd[M4];	/* Semi-polar coordinate grids    */
+	float2D	vtos[M4];		/* vector to semi-polar map       */
+} lam_model;
+
+/* values returned by the functions reading and writing specifications */
+#define	SPEC_OK		0
+#define	SPEC_EFILE	-1	/* file could not be opened, read or written */
+#define	SPEC_EFORMAT	-2	/* not a model spec, or truncated	*/
+#define	SPEC_EVERSION	-3	/* binary file of another version	*/
+#define	SPEC_ECHECKSUM	-4	/* binary file corrupted		*/
+#define	SPEC_ERANGE	-5	/* dimensions beyond those of lam_lib	*/
+#define	SPEC_EMEMORY	-6
+
 
-void	read_model_spec( void );
+short	read_model_spec( void );
+short	read_model_spec_r( const char *path, lam_spec *sp );
+short	lam_spec_check( const lam_spec *sp );
+void	lam_spec_get( lam_spec *sp );
+short	lam_spec_set( const lam_spec *sp );
+void	lam_spec_changed( void );
+unsigned long	lam_spec_checksum( const lam_spec *sp );
+short	lam_spec_write( const lam_spec *sp, const char *path );
+short	lam_spec_open( lam_spec_file *f, const char *path );
+void	lam_spec_close( lam_spec_file *f );
+const	char	*lam_spec_error( short r );
+short	lam_model_ini( lam_model *md, const lam_spec *sp );
+short	lam_model_load( lam_model *md, const char *path );
 void	convert_scale( void );
 void	semi_polar( void );
+void	lam_setup( void );
+const	lam_model	*lam_default( void );
 void	lam( float *para);
+void	lam_r( const lam_model *md, float *para, vt_profile *vp );
+void	lam_batch( const lam_model *md, const float *pa, long m, long ldp,
+		   vt_profile *vp, short nss, area_function *af );
 void	sagittal_to_area( short *ns, area_function *af );
+void	sagittal_to_area_r( const lam_model *md, const vt_profile *vp,
+			    short *ns, area_function *af );
 void	appro_area_function (short ns1, area_function *A1, short ns2, area_function *A2);
 void	print_lam ( void );
 void    print_af (short ns, area_function *af);
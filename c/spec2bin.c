@@ -0,0 +1,51 @@
+/*****
+*	File :	spec2bin.c
+*	Note :	Converts a model specification from the text format
+*		(pb1_spec.dat) to the binary one (see lam_spec in
+*		lam_lib.h), and checks binary files.
+*
+*		  spec2bin pb1_spec.dat model.bin   converts a text spec
+*		  spec2bin model.bin                writes the built-in model
+*		  spec2bin -c model.bin             checks a binary file
+*
+*		Build, from this directory:
+*
+*		  cc -O2 -o spec2bin spec2bin.c lam_lib.c -lm
+*****/
+
+#include	"always.h"
+#include	"lam_lib.h"
+
+int	main ( int argc, char **argv )
+{
+	lam_spec	sp;
+	lam_spec_file	f;
+	short	r;
+
+	if( argc == 3 && strcmp( argv[1], "-c" ) == 0 )
+	{  if( (r = lam_spec_open( &f, argv[2] )) == SPEC_OK )
+	   {  printf( "%s: version %d, %d tongue and %d wall variables\n",
+		      argv[2], LAM_SPEC_VERSION, f.spec->nvrs_tng,
+		      f.spec->nvrs_wal );
+	      lam_spec_close( &f );
+	   }
+	}
+	else if( argc == 3 )
+	{  if( (r = read_model_spec_r( argv[1], &sp )) == SPEC_OK )
+	      r = lam_spec_write( &sp, argv[2] );
+	}
+	else if( argc == 2 )
+	{  lam_spec_get( &sp );
+	   r = lam_spec_write( &sp, argv[1] );
+	}
+	else
+	{  fprintf( stderr, "usage: spec2bin [pb1_spec.dat] model.bin\n"
+			    "       spec2bin -c model.bin\n" );
+	   return( 2 );
+	}
+	if( r != SPEC_OK )
+	{  fprintf( stderr, "spec2bin: %s\n", lam_spec_error( r ) );
+	   return( 1 );
+	}
+	return( 0 );
+}
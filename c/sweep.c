@@ -0,0 +1,484 @@
+/***************************************************************************
+*                                                                          *
+*	File :	sweep.c                                                    *
+*	Note :	Sweep of the articulatory parameters over a grid: area     *
+*		functions (lam_batch) and short stationary syntheses      *
+*		(synthesize_into_r) of all the grid points, computed by a  *
+*		pool of threads a chunk at a time, and written in place   *
+*		to one file per column.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<errno.h>
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<pthread.h>
+#include	<sys/stat.h>
+#include	"vtconfig.h"
+#include	"lam_lib.h"
+#include	"vsyn_lib.h"
+#include	"synthesize.h"
+#include	"sweep.h"
+
+#define	SW_COLS		4	/* para, area, length, wave */
+#define	SW_HEADER	2048	/* bytes of sweep.txt, at most */
+
+static	const	char	*col_file[SW_COLS] = { "para.f32", "area.f32",
+					       "length.f32", "wave.s16" };
+
+/*****
+*	Function : sweep_spec_default
+*	Note :	A single point at 0, the sections of the globals, chunks
+*		of SW_CHUNK points and no synthesis.
+*****/
+void	sweep_spec_default ( sweep_spec *sw )
+{
+	short	d;
+
+	memset( sw, 0, sizeof(sweep_spec) );
+	for(d=0; d<SW_NPAR; d++) sw->n[d] = 1;
+	sw->nss = nbu + nph;
+	sw->chunk = SW_CHUNK;
+	sw->dur = 0;
+	sw->f0 = 120.f;
+	sw->Ap = 0.2f;
+}
+
+/*****
+*	Function : sweep_spec_read
+*	Note :	Reads the grid of sw from a text file of 7 lines
+*		"n lo hi", one per parameter in the order of lam; blank
+*		lines and lines starting with '#' are skipped.  The other
+*		fields of sw are not changed.
+*****/
+short	sweep_spec_read ( sweep_spec *sw, const char *path )
+{
+	FILE	*fp;
+	char	line[256], *s;
+	short	d = 0, n;
+	float	lo, hi;
+
+	if( (fp = fopen( path, "r" )) == NULL ) return( SW_EFILE );
+	while( d < SW_NPAR && fgets( line, sizeof(line), fp ) != NULL )
+	{  s = line + strspn( line, " \t" );
+	   if( *s == '#' || *s == '\n' || *s == '\r' || *s == '\0' ) continue;
+	   if( sscanf( s, "%hd %f %f", &n, &lo, &hi ) != 3 ) break;
+	   sw->n[d]  = n;
+	   sw->lo[d] = lo;
+	   sw->hi[d] = hi;
+	   d++;
+	}
+	fclose( fp );
+	return( d == SW_NPAR ? SW_OK : SW_EFORMAT );
+}
+
+/*****
+*	Function : sweep_size
+*	Note :	Number of grid points, or -1 if the spec is not valid or
+*		the columns would be too large.
+*****/
+long	sweep_size ( const sweep_spec *sw )
+{
+	long	size = 1, row;
+	short	d;
+
+	if( sw->nss <= 0 || sw->chunk < 1 || !(sw->dur >= 0) ) return( -1 );
+	if( sw->dur > 0 && !(sw->f0 > 0) ) return( -1 );
+	row = 2L*sw->nss*sizeof(float);
+	for(d=0; d<SW_NPAR; d++)
+	{  if( sw->n[d] < 1 || !(sw->hi[d] >= sw->lo[d]) ) return( -1 );
+	   if( size > 0x7fffffffffffL/row/sw->n[d] ) return( -1 );
+	   size *= sw->n[d];
+	}
+	return( size );
+}
+
+/*****
+*	Function : stationary_track
+*	Note :	The two frames (time 0 and dur) of the synthesis of the
+*		articulatory parameters pa.
+*****/
+static	void	stationary_track ( const sweep_spec *sw, const float *pa,
+				   float frm[2][NPAR+1], float *par[2] )
+{
+	short	k, d;
+
+	for(k=0; k<2; k++)
+	{  frm[k][TIME] = k*sw->dur*1000;
+	   frm[k][F0_LOC] = sw->f0;
+	   frm[k][AP] = sw->Ap;
+	   for(d=0; d<SW_NPAR; d++) frm[k][AMloc+d] = pa != NULL ? pa[d] : 0;
+	   frm[k][NPAR] = 0;
+	   par[k] = frm[k];
+	}
+}
+
+/*****
+*	Function : sweep_samples
+*	Note :	Samples of the synthesis of each point at the rate of cf,
+*		with the 60 ms transition (see synthesize), 0 if none.
+*****/
+long	sweep_samples ( const sweep_spec *sw, const vt_config *cf )
+{
+	float	frm[2][NPAR+1], *par[2];
+
+	if( !(sw->dur > 0) ) return( 0 );
+	stationary_track( sw, NULL, frm, par );
+	return( synth_track_length( cf->smpfrq, par, 2 ) );
+}
+
+/*****
+*	Function : sweep_point
+*	Note :	The parameters pa of the grid point g, the last parameter
+*		varying fastest (as in codebook_build).
+*****/
+static	void	sweep_point ( const sweep_spec *sw, long g, float *pa )
+{
+	short	d, i;
+
+	for(d=SW_NPAR-1; d>=0; d--)
+	{  i = (short)(g % sw->n[d]);
+	   g /= sw->n[d];
+	   pa[d] = sw->n[d] == 1 ? sw->lo[d]
+		 : sw->lo[d] + (sw->hi[d] - sw->lo[d])*i/(sw->n[d] - 1);
+	}
+}
+
+/*****
+*	Function : sweep_header
+*	Note :	The text of sweep.txt for sw, size points and ns samples
+*		each, with the model of the given checksum (see
+*		lam_spec_checksum), into buf.  Returns its length, or -1
+*		if too long.
+*****/
+static	int	sweep_header ( const sweep_spec *sw, const vt_config *cf,
+			       long size, long ns, unsigned long model,
+			       char *buf )
+{
+	int	k, d;
+
+	k = snprintf( buf, SW_HEADER, "maeda sweep %d\npoints %ld\nchunk %ld\n"
+		      "nss %d\nmodel %08lx\ngrid\n", SW_VERSION, size, sw->chunk,
+		      sw->nss, model );
+	for(d=0; d<SW_NPAR && k < SW_HEADER; d++)
+	   k += snprintf( buf + k, SW_HEADER - k, "%d %.9g %.9g\n",
+			  sw->n[d], sw->lo[d], sw->hi[d] );
+	if( k < SW_HEADER && ns > 0 )
+	   k += snprintf( buf + k, SW_HEADER - k, "synthesis dur %.9g f0 %.9g "
+			  "Ap %.9g smpfrq %.9g simfrq %.9g nss %d\n", sw->dur,
+			  sw->f0, sw->Ap, cf->smpfrq, cf->simfrq,
+			  cf->nbu + cf->nph );
+	if( k < SW_HEADER )
+	   k += snprintf( buf + k, SW_HEADER - k, "columns\n%s float32 %d\n"
+			  "%s float32 %d\n%s float32 %d\n", col_file[0], SW_NPAR,
+			  col_file[1], sw->nss, col_file[2], sw->nss );
+	if( k < SW_HEADER && ns > 0 )
+	   k += snprintf( buf + k, SW_HEADER - k, "%s int16 %ld\n",
+			  col_file[3], ns );
+	return( k < SW_HEADER ? k : -1 );
+}
+
+/*****
+*	Function : put_at
+*	Note :	Writes n bytes at the offset off of the file fd.
+*		Returns 0, or -1 on error.
+*****/
+static	short	put_at ( int fd, const void *buf, size_t n, off_t off )
+{
+	const	char	*p = (const char *) buf;
+	ssize_t	w;
+
+	while( n > 0 )
+	{  if( (w = pwrite( fd, p, n, off )) < 0 )
+	   {  if( errno == EINTR ) continue;
+	      return( -1 );
+	   }
+	   p += w;
+	   n -= w;
+	   off += w;
+	}
+	return( 0 );
+}
+
+/*****
+*	Function : get_at
+*	Note :	Reads n bytes at the offset off of the file fd.
+*		Returns 0, or -1 on error or at the end of the file.
+*****/
+static	short	get_at ( int fd, void *buf, size_t n, off_t off )
+{
+	char	*p = (char *) buf;
+	ssize_t	r;
+
+	while( n > 0 )
+	{  if( (r = pread( fd, p, n, off )) <= 0 )
+	   {  if( r < 0 && errno == EINTR ) continue;
+	      return( -1 );
+	   }
+	   p += r;
+	   n -= r;
+	   off += r;
+	}
+	return( 0 );
+}
+
+/************************( the pool of threads )*************************/
+
+typedef struct {
+	const	sweep_spec	*sw;
+	const	vt_config	*cf;
+	const	lam_model	*md;
+	long	size, nchunk, ns;	/* points, chunks, samples per point */
+	int	fd[SW_COLS];		/* the columns, -1 if none	*/
+	int	fd_done;
+	char	*done;			/* a byte per chunk		*/
+	long	next;			/* next chunk to look at	*/
+	long	budget;			/* chunks left to hand out	*/
+	long	ndone;
+	short	failed;
+	pthread_mutex_t	lock;
+} sweep_pool;
+
+/*****
+*	Function : take_chunk
+*	Note :	The next chunk which is not done, or -1 if none is left
+*		(or the budget is spent, or a worker failed).
+*****/
+static	long	take_chunk ( sweep_pool *sp )
+{
+	long	c = -1;
+
+	pthread_mutex_lock( &sp->lock );
+	while( !sp->failed && sp->budget != 0 && sp->next < sp->nchunk )
+	   if( !sp->done[sp->next++] )
+	   {  c = sp->next - 1;
+	      if( sp->budget > 0 ) sp->budget--;
+	      break;
+	   }
+	pthread_mutex_unlock( &sp->lock );
+	return( c );
+}
+
+/*****
+*	Function : sweep_worker
+*	Note :	Computes and writes chunks until none is left.  The voice
+*		of the synthesis starts each point afresh (synthesize_into_r
+*		restores its source and the nasal coupling of sp->cf), so
+*		that the wave of a point does not depend on the points
+*		before it.
+*****/
+static	void	*sweep_worker ( void *arg )
+{
+	sweep_pool	*sp = (sweep_pool *) arg;
+	const	sweep_spec	*sw = sp->sw;
+	long	C = sw->chunk, c, g0, m, k, j;
+	short	nss = sw->nss, ok = 1, voice = 0;
+	float	*pa, *A, *x, frm[2][NPAR+1], *par[2];
+	vt_profile	*vp;
+	area_function	*af;
+	short	*wav = NULL;
+	synth_voice	sv;
+	char	one = 1;
+
+	pa = (float *) malloc( C*SW_NPAR*sizeof(float) );
+	A  = (float *) malloc( C*nss*sizeof(float) );
+	x  = (float *) malloc( C*nss*sizeof(float) );
+	vp = (vt_profile *) malloc( C*sizeof(vt_profile) );
+	af = (area_function *) malloc( C*nss*sizeof(area_function) );
+	if( sp->ns > 0 )
+	{  wav = (short *) malloc( C*sp->ns*sizeof(short) );
+	   voice = wav != NULL && synth_voice_ini( &sv, sp->cf ) == 0;
+	}
+	if( pa == NULL || A == NULL || x == NULL || vp == NULL || af == NULL
+	 || (sp->ns > 0 && !voice) ) ok = 0;
+
+	while( ok && (c = take_chunk( sp )) >= 0 )
+	{  g0 = c*C;
+	   m = sp->size - g0 < C ? sp->size - g0 : C;
+	   for(k=0; k<m; k++) sweep_point( sw, g0 + k, pa + k*SW_NPAR );
+	   lam_batch( sp->md, pa, m, SW_NPAR, vp, nss, af );
+	   for(j=0; j<m*nss; j++)
+	   {  A[j] = af[j].A;
+	      x[j] = af[j].x;
+	   }
+	   for(k=0; k<m && sp->ns > 0; k++)
+	   {  stationary_track( sw, pa + k*SW_NPAR, frm, par );
+	      if( synthesize_into_r( &sv, par, 2, wav + k*sp->ns, OUT_S16 ) < 0 )
+		 ok = 0;
+	   }
+	   ok = ok
+	     && put_at( sp->fd[0], pa, m*SW_NPAR*sizeof(float),
+			(off_t)g0*SW_NPAR*sizeof(float) ) == 0
+	     && put_at( sp->fd[1], A, m*nss*sizeof(float),
+			(off_t)g0*nss*sizeof(float) ) == 0
+	     && put_at( sp->fd[2], x, m*nss*sizeof(float),
+			(off_t)g0*nss*sizeof(float) ) == 0
+	     && (sp->ns == 0
+	      || put_at( sp->fd[3], wav, m*sp->ns*sizeof(short),
+			 (off_t)g0*sp->ns*sizeof(short) ) == 0)
+	     && fdatasync( sp->fd[0] ) == 0 && fdatasync( sp->fd[1] ) == 0
+	     && fdatasync( sp->fd[2] ) == 0
+	     && (sp->ns == 0 || fdatasync( sp->fd[3] ) == 0)
+	     && put_at( sp->fd_done, &one, 1, (off_t)c ) == 0;
+	   if( ok )
+	   {  pthread_mutex_lock( &sp->lock );
+	      sp->done[c] = 1;
+	      sp->ndone++;
+	      pthread_mutex_unlock( &sp->lock );
+	   }
+	}
+	if( !ok )
+	{  pthread_mutex_lock( &sp->lock );
+	   sp->failed = 1;
+	   pthread_mutex_unlock( &sp->lock );
+	}
+	if( voice ) synth_voice_term( &sv );
+	free( wav );
+	free( af );
+	free( vp );
+	free( x );
+	free( A );
+	free( pa );
+	return( NULL );
+}
+
+/*****
+*	Function : open_sweep
+*	Note :	Opens the files of the sweep in dir: those of an earlier
+*		run of the same sweep (header hd) with its done chunks, or
+*		new ones, the header being written last.
+*****/
+static	short	open_sweep ( sweep_pool *sp, const char *dir, const char *hd,
+			     int hlen )
+{
+	char	path[4096], old[SW_HEADER];
+	int	fd, i, fresh, flags;
+	ssize_t	r;
+
+	if( mkdir( dir, 0777 ) != 0 && errno != EEXIST ) return( SW_EFILE );
+	snprintf( path, sizeof(path), "%s/sweep.txt", dir );
+	fresh = (fd = open( path, O_RDONLY )) < 0;
+	if( !fresh )
+	{  r = read( fd, old, sizeof(old) );
+	   close( fd );
+	   if( r != hlen || memcmp( old, hd, hlen ) != 0 ) return( SW_EMISMATCH );
+	}
+	flags = O_RDWR | O_CREAT | (fresh ? O_TRUNC : 0);
+
+	for(i=0; i<SW_COLS; i++)
+	{  if( i == 3 && sp->ns == 0 ) continue;
+	   snprintf( path, sizeof(path), "%s/%s", dir, col_file[i] );
+	   if( (sp->fd[i] = open( path, flags, 0666 )) < 0 ) return( SW_EFILE );
+	}
+	snprintf( path, sizeof(path), "%s/done", dir );
+	if( (sp->fd_done = open( path, flags, 0666 )) < 0 ) return( SW_EFILE );
+
+	if( fresh )
+	{  if( put_at( sp->fd_done, sp->done, sp->nchunk, 0 ) != 0 )
+	      return( SW_EFILE );
+	   snprintf( path, sizeof(path), "%s/sweep.txt", dir );
+	   if( (fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) < 0 )
+	      return( SW_EFILE );
+	   i = put_at( fd, hd, hlen, 0 ) == 0 && fsync( fd ) == 0;
+	   close( fd );
+	   return( i ? SW_OK : SW_EFILE );
+	}
+	if( get_at( sp->fd_done, sp->done, sp->nchunk, 0 ) != 0 )
+	   return( SW_EFILE );
+	for(i=0; i<sp->nchunk; i++) sp->ndone += sp->done[i] != 0;
+	return( SW_OK );
+}
+
+/*****
+*	Function : sweep_run
+*	Note :	Computes the sweep sw into the directory dir (created if
+*		need be), with the rates and tract of cf for the
+*		synthesis, and nthreads threads (<= 0 for one per online
+*		processor).  If dir holds an earlier run of the same sweep,
+*		with the same model, only the chunks which are not done
+*		are computed; one which holds another sweep is left alone
+*		(SW_EMISMATCH).  At most max_chunks
+*		chunks are computed (<= 0 for all), so that a long sweep
+*		may be run in slices.  *done, if not NULL, is set to the
+*		chunks done on return, out of (size + chunk - 1)/chunk.
+*
+*		The model is lam_default(), which must not change during
+*		the run.  Returns SW_OK or one of the errors of sweep.h.
+*****/
+short	sweep_run (
+	const	sweep_spec	*sw,
+	const	vt_config	*cf,
+	const	char	*dir,
+	int	nthreads,
+	long	max_chunks,
+	long	*done )
+{
+	sweep_pool	sp;
+	lam_spec	spec;
+	pthread_t	*th;
+	char	hd[SW_HEADER];
+	int	hlen, i, started = 0;
+	short	r;
+
+	if( done != NULL ) *done = 0;
+	memset( &sp, 0, sizeof(sp) );
+	sp.sw = sw;
+	sp.cf = cf;
+	if( (sp.size = sweep_size( sw )) < 0 ) return( SW_EGRID );
+	sp.ns = sweep_samples( sw, cf );
+	if( sp.ns > 0x7fffffffffffL/(long)sizeof(short)/sp.size ) return( SW_EGRID );
+	sp.nchunk = (sp.size + sw->chunk - 1)/sw->chunk;
+	sp.md = lam_default();		/* set up before the threads */
+	lam_spec_get( &spec );
+	if( (hlen = sweep_header( sw, cf, sp.size, sp.ns,
+				  lam_spec_checksum( &spec ), hd )) < 0 )
+	   return( SW_EGRID );
+	sp.budget = max_chunks > 0 ? max_chunks : -1;
+	for(i=0; i<SW_COLS; i++) sp.fd[i] = -1;
+	sp.fd_done = -1;
+
+	if( nthreads <= 0 ) nthreads = (int) sysconf( _SC_NPROCESSORS_ONLN );
+	if( nthreads <= 0 ) nthreads = 1;
+	if( nthreads > sp.nchunk ) nthreads = (int) sp.nchunk;
+
+	sp.done = (char *) calloc( sp.nchunk, 1 );
+	th = (pthread_t *) malloc( nthreads*sizeof(pthread_t) );
+	if( sp.done == NULL || th == NULL ) r = SW_EMEMORY;
+	else r = open_sweep( &sp, dir, hd, hlen );
+
+	if( r == SW_OK )
+	{  pthread_mutex_init( &sp.lock, NULL );
+	   for(i=0; i<nthreads; i++)
+	      if( pthread_create( &th[i], NULL, sweep_worker, &sp ) == 0 ) started++;
+	   for(i=0; i<started; i++) pthread_join( th[i], NULL );
+	   pthread_mutex_destroy( &sp.lock );
+	   if( started == 0 ) r = SW_EMEMORY;
+	   else if( sp.failed ) r = SW_EFILE;
+	   if( done != NULL ) *done = sp.ndone;
+	}
+
+	for(i=0; i<SW_COLS; i++) if( sp.fd[i] >= 0 ) close( sp.fd[i] );
+	if( sp.fd_done >= 0 ) close( sp.fd_done );
+	free( th );
+	free( sp.done );
+	return( r );
+}
+
+/*****
+*	Function : sweep_error
+*	Note :	A message for a value returned by the functions above.
+*****/
+const	char	*sweep_error( short r )
+{
+	static	const	char	*msg[] = { "no error",
+		"file could not be opened, read or written",
+		"not a grid specification (7 lines of n lo hi)",
+		"grid or options not valid, or sweep too large",
+		"the directory holds another sweep",
+		"not enough memory, or no thread" };
+
+	return( r <= 0 && r >= SW_EMEMORY ? msg[-r] : "unknown error" );
+}
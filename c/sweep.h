@@ -0,0 +1,63 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+/*****
+*	File :	sweep.h
+*	Note :	A sweep of the 7 articulatory parameters over a grid: for
+*		each grid point, lam, sagittal_to_area and
+*		appro_area_function, and optionally a short stationary
+*		synthesis, computed by a pool of threads.
+*
+*		The results go to a directory, one file per column, so
+*		that a reader can map each one as an array:
+*
+*		  para.f32	7 floats per point (the grid point)
+*		  area.f32	nss floats per point (A, cm2)
+*		  length.f32	nss floats per point (x, cm)
+*		  wave.s16	samples shorts per point, if dur > 0
+*		  sweep.txt	the spec, the model (lam_spec_checksum),
+*				sizes and columns, as text
+*		  done		a byte per chunk, 1 once it is written
+*
+*		The points are computed and written a chunk at a time,
+*		in place, so that an interrupted sweep resumes at the
+*		chunks which are not done (see sweep_run).  The columns
+*		are in the byte order of the machine which wrote them.
+*****/
+
+#include "vtconfig.h"
+
+#define	SW_NPAR		7	/* articulatory parameters (= AMnum)	*/
+#define	SW_VERSION	2	/* version of the directory layout	*/
+#define	SW_CHUNK	1024	/* points per chunk, by default		*/
+
+/* values returned by sweep_spec_read and sweep_run */
+#define	SW_OK		0
+#define	SW_EFILE	-1	/* file could not be opened, read or written */
+#define	SW_EFORMAT	-2	/* not a grid specification		*/
+#define	SW_EGRID	-3	/* grid or options not valid		*/
+#define	SW_EMISMATCH	-4	/* the directory holds another sweep	*/
+#define	SW_EMEMORY	-5	/* not enough memory, or no thread	*/
+
+typedef struct {
+	short	n[SW_NPAR];		/* grid points per parameter, >= 1 */
+	float	lo[SW_NPAR];		/* parameter value of the first	   */
+	float	hi[SW_NPAR];		/* ... and of the last grid point  */
+	short	nss;			/* sections of each area function  */
+	long	chunk;			/* points per chunk		   */
+	float	dur;			/* seconds of synthesis per point, */
+					/* 0 for none			   */
+	float	f0, Ap;			/* f0 (Hz) and glottal opening of  */
+					/* the synthesis		   */
+} sweep_spec;
+
+void	sweep_spec_default( sweep_spec *sw );
+short	sweep_spec_read( sweep_spec *sw, const char *path );
+long	sweep_size( const sweep_spec *sw );
+long	sweep_samples( const sweep_spec *sw, const vt_config *cf );
+short	sweep_run( const sweep_spec *sw, const vt_config *cf,
+		   const char *dir, int nthreads, long max_chunks,
+		   long *done );
+const	char	*sweep_error( short r );
+
+#endif
@@ -0,0 +1,104 @@
+/*****
+*	File :	sweeprun.c
+*	Note :	Runs a parameter sweep (see sweep.h) from the command
+*		line, or resumes it:
+*
+*		  sweeprun [options] grid.txt outdir
+*
+*		  -j threads	threads, 0 for one per processor (= 0)
+*		  -c points	points per chunk (= SW_CHUNK)
+*		  -m chunks	chunks to compute in this run, 0 for all
+*		  -s sections	sections of the area functions (= nbu + nph)
+*		  -d seconds	stationary synthesis of each point, 0 for
+*				none (= 0)
+*		  -f f0		f0 of the synthesis in Hz (= 120)
+*		  -a Ap		glottal opening of the synthesis (= 0.2)
+*		  -r rate	output rate of the synthesis in Hz; the
+*				simulation runs at 3 times it
+*		  -p model.bin	articulatory model (see spec2bin), instead
+*				of the built-in one
+*
+*		grid.txt holds 7 lines "n lo hi", one per parameter (jaw,
+*		tongue dorsum position and shape, apex, lip height and
+*		protrusion, larynx height).  The exit status is 0 once the
+*		sweep is complete, 3 if chunks are left (-m), 1 on error.
+*
+*		Build, from this directory:
+*
+*		  cc -O2 -DSYNTHESIZE_NO_MAIN -o sweeprun sweeprun.c sweep.c \
+*		     synthesize.c vtt_lib.c lam_lib.c vsyn_lib.c codebook.c \
+*		     -lm -lpthread
+*****/
+
+#include	<unistd.h>
+#include	"always.h"
+#include	"synthesize.h"
+#include	"sweep.h"
+
+static	void	usage ( void )
+{
+	fprintf( stderr, "usage: sweeprun [-j threads] [-c points] [-m chunks] "
+		 "[-s sections]\n                [-d seconds] [-f f0] [-a Ap] "
+		 "[-r rate] [-p model.bin]\n                grid.txt outdir\n" );
+}
+
+int	main ( int argc, char **argv )
+{
+	sweep_spec	sw;
+	vt_config	cf;
+	lam_spec_file	f;
+	long	size, nchunk, done, max_chunks = 0;
+	int	nthreads = 0, opt;
+	float	rate = 0;
+	char	*model = NULL;
+	short	r;
+
+	sweep_spec_default( &sw );
+	while( (opt = getopt( argc, argv, "j:c:m:s:d:f:a:r:p:" )) != -1 )
+	   switch( opt )
+	   {  case 'j': nthreads = atoi( optarg ); break;
+	      case 'c': sw.chunk = atol( optarg ); break;
+	      case 'm': max_chunks = atol( optarg ); break;
+	      case 's': sw.nss = (short) atoi( optarg ); break;
+	      case 'd': sw.dur = (float) atof( optarg ); break;
+	      case 'f': sw.f0 = (float) atof( optarg ); break;
+	      case 'a': sw.Ap = (float) atof( optarg ); break;
+	      case 'r': rate = (float) atof( optarg ); break;
+	      case 'p': model = optarg; break;
+	      default:  usage(); return( 2 );
+	   }
+	if( argc - optind != 2 )
+	{  usage();
+	   return( 2 );
+	}
+
+	if( model != NULL )
+	{  if( (r = lam_spec_open( &f, model )) != SPEC_OK
+	    || (r = lam_spec_set( f.spec )) != SPEC_OK )
+	   {  fprintf( stderr, "sweeprun: %s: %s\n", model, lam_spec_error( r ) );
+	      return( 1 );
+	   }
+	   lam_spec_close( &f );
+	}
+
+	copy_vt_config( &cf );
+	if( rate > 0 && vt_rates_r( &cf, rate, 3*rate ) < 0 )
+	{  fprintf( stderr, "sweeprun: rate must be positive\n" );
+	   return( 2 );
+	}
+
+	if( (r = sweep_spec_read( &sw, argv[optind] )) != SW_OK
+	 || (r = (size = sweep_size( &sw )) < 0 ? SW_EGRID : SW_OK) != SW_OK )
+	{  fprintf( stderr, "sweeprun: %s: %s\n", argv[optind], sweep_error( r ) );
+	   return( 1 );
+	}
+	nchunk = (size + sw.chunk - 1)/sw.chunk;
+
+	r = sweep_run( &sw, &cf, argv[optind+1], nthreads, max_chunks, &done );
+	if( r != SW_OK )
+	{  fprintf( stderr, "sweeprun: %s: %s\n", argv[optind+1], sweep_error( r ) );
+	   return( 1 );
+	}
+	printf( "%ld points, %ld of %ld chunks done\n", size, done, nchunk );
+	return( done == nchunk ? 0 : 3 );
+}
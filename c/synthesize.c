@@ -6,45 +6,22 @@
 //  Copyright (c) 2014 Keith Johnson. All rights reserved.
 //
 
+#include	<pthread.h>
+#include	<time.h>
+#include	<unistd.h>
 #include	"always.h"
 #include	"lam_lib.h"
 #include	"vtconfig.h"
 #include	"vsyn_lib.h"
-
-/* parameter matrix - a sequence of frames  */
-#define NPAR 10     /* number of model parameters per frame */
-#define AMloc 3     /* starting location of the 7 Maeda model parameters */
-#define AMnum 7     /* how many Maeda model parameters are there */
-#define TIME 0  /* index of the time value of the frame */
-#define F0_LOC 1 /* index of the f0 value */
-#define AP 2 /* target amplitude of glottal opening */
-#define FRAME_DUR 0.005  /* duration (seconds) of a frame */
-
-/* NOTE BY RLS
-  The values of NPAR and AMnum are incorrect as given. They should be 11 and 8,
-  i.e. they are really 'last index', not 'number of'.
-  This probably hasn't mattered since the last parameter (nasal coupling) is
-  is always 0 in this code.
-*/
-
-/*   The columns in <par>:
- 0 time
- 1 f0
- 2 max glottal opening
- 3 Jaw position             <- Artic model params start here
- 4 Tongue dorsum position
- 5 Tongue dorsum shape
- 6 Tongue apex position
- 7 Lip height (aperture)
- 8 Lip protrusion
- 9 Larynx height
- 10 Nasal coupling (cm2)  *** not used? ***
-  */
+#include	"codebook.h"
+#include	"synthesize.h"
 
 /* Specific to time domain calculations */
 
 float	simfrq = 30000.0f;	/* simulation frequency in Hz	*/
 float	smpfrq = 10000.0f;	/* sampling freq. in Hz		*/
+short	decim_taps = 0;		/* decimation FIR length, 0 for auto	*/
+float	decim_cutoff = 0.9f;	/* its cutoff relative to smpfrq/2	*/
 
 /*( Used in the time and frequency domain calculations )*/
 
@@ -104,22 +81,83 @@ float	wall_comp = 3.0e+5f;	/* wall compliance			*/
 float	H2O_bar= 980.39f;
 
 
+/* Frames last FRAME_DUR whatever the rate, so that a frame need not be a whole
+ number of samples (110.25 at 22050 Hz).  Frame k starts at the sample
+ frame_start(rate, k), which keeps the frames on time over an utterance. */
+static long frame_start(float rate, long k) {
+    return (long) ceil(k*(rate*FRAME_DUR) - 1e-6);
+}
+
+/* start of the frame after the one containing the sample buf_count */
+static long next_frame(float rate, long buf_count) {
+    return frame_start(rate, (long)(buf_count/(rate*FRAME_DUR)) + 1);
+}
+
+/* the largest number of samples in a frame at the rate rate, for buffers */
+short frame_length(float rate) {
+    return (short) frame_start(rate, 1);
+}
+
+/* The samples of vtt_sim are staged in blocks and converted a block at a time
+ into the caller's buffer, in the format OUT_S16 or OUT_F32 (see pcm_s16). */
+#define SINK_BLOCK 256
+
+typedef struct {
+    void    *buf;       /* the caller's buffer */
+    short   format;
+    long    at;         /* where the next block goes in buf */
+    int     k;          /* samples in blk */
+    float   blk[SINK_BLOCK];
+} pcm_sink;
+
+static void sink_open(pcm_sink *snk, void *buf, short format) {
+    snk->buf = buf;
+    snk->format = format;
+    snk->at = 0L;
+    snk->k = 0;
+}
+
+static void sink_flush(pcm_sink *snk) {
+    if (snk->format == OUT_F32) pcm_f32(snk->blk, (float *)snk->buf + snk->at, snk->k);
+    else                        pcm_s16(snk->blk, (short *)snk->buf + snk->at, snk->k);
+    snk->at += snk->k;
+    snk->k = 0;
+}
+
+static void sink_put(pcm_sink *snk, float x) {
+    snk->blk[snk->k++] = x;
+    if (snk->k == SINK_BLOCK) sink_flush(snk);
+}
+
+static size_t sample_size(short format) {
+    return format == OUT_F32 ? sizeof(float) : sizeof(short);
+}
+
+/* the global afvt, for nss = nbu + nph sections; it is allocated at the first
+ initialization and kept for the next ones */
+static void legacy_afvt(void) {
+    static short afvt_len = 0;
+    
+    nss = nbu + nph;
+    if (nss > afvt_len) {
+        free(afvt);
+        afvt = (area_function *) calloc( nss, sizeof(area_function) );
+        afvt_len = afvt != NULL ? nss : 0;
+    }
+}
 
 long update_VT(float **par, long buf_count, int time_steps){
     
-    short	ns0 = 29;
-	static	area_function	*af0;
+    short	ns0 = NP;
+	static	area_function	af0[NP];
     int target_time, i;
     float AMpar[7];  /* articulatory model parameters */
     
     /* Initialization */
     if (buf_count==0L) {
         
-        af0 = (area_function *) calloc( ns0, sizeof(area_function) );
-        nss = nbu + nph;
-        afvt  = (area_function *) calloc( nss, sizeof(area_function) );
-        convert_scale();
-        semi_polar();
+        legacy_afvt();
+        lam_setup();        /* the default model, made once per spec */
     
         for (i=0;i<AMnum;i++) AMpar[i] = par[0][i+AMloc];  /* first vocal tract shape */
 
@@ -130,7 +168,7 @@ long update_VT(float **par, long buf_count, int time_steps){
         appro_area_function( ns0, af0, nss, afvt);  /* make tube lengths equal */
         print_af(nss,afvt);
         vtt_ini();
-        return (smpfrq*FRAME_DUR);  /* next update is due */
+        return frame_start(smpfrq, 1);  /* next update is due */
     }
     target_time = buf_count/smpfrq * 1000;  /* get parameters for frame at target_time */
     do time_steps--; while (par[time_steps][TIME] > target_time);
@@ -147,47 +185,115 @@ long update_VT(float **par, long buf_count, int time_steps){
         anc = (float) min( anc, afvt[nph].A );
         afvt[nph].A -= anc;
     }
-    return (buf_count + smpfrq*FRAME_DUR);  /* 0.005 = 5 ms */
+    return next_frame(smpfrq, buf_count);  /* 0.005 = 5 ms */
     
 }
 
-short update_pitch(float **par,long buf_count, int time_steps, float *Ap) {
+/* pitch period in samples at the rate rate, and Ap, for the frame at buf_count */
+static short pitch_at(float rate, float **par, long buf_count, int time_steps, float *Ap) {
     int target_time;
     
-    target_time = buf_count/smpfrq * 1000;  /* get parameters for frame at target_time */
+    target_time = buf_count/rate * 1000;  /* get parameters for frame at target_time */
     do time_steps--; while (par[time_steps][TIME] > target_time);
     
     *Ap = par[time_steps][AP];
-    return (short) ( 0.5+ smpfrq/par[time_steps][F0_LOC]);
+    return (short) ( 0.5+ rate/par[time_steps][F0_LOC]);
+
+}
+
+short update_pitch(float **par,long buf_count, int time_steps, float *Ap) {
+    return pitch_at(smpfrq, par, buf_count, time_steps, Ap);
+}
+
+
+/* Sub-frame interpolation of synth_frame.  With INTERP_LINEAR or INTERP_CUBIC,
+ a frame goes from the previous parameters to the new ones instead of jumping
+ to them: the area function is computed updates times over the frame,
+ at evenly spaced points, for the parameters interpolated at the end of each
+ step; Ap follows every sample and f0 every pitch period.  The cubic is a
+ Hermite spline through the frames, with the tangent at the previous frame
+ taken from the frames around it and the one at the new frame from the last
+ step (the next frame is not known yet). */
+static frame_interp legacy_interp = { .kind = INTERP_NONE, .updates = 1 };
+
+/* the value at u in [0,1] from b, in the frame before, to c, in the current
+ one; a is the value in the frame before b */
+static float interp_value(short kind, float a, float b, float c, float u) {
+    float m0, m1, u2, u3;
+    
+    if (kind == INTERP_LINEAR) return b + u*(c - b);
+    m0 = 0.5f*(c - a);
+    m1 = c - b;
+    u2 = u*u;
+    u3 = u2*u;
+    return (2*u3 - 3*u2 + 1)*b + (u3 - 2*u2 + u)*m0 + (3*u2 - 2*u3)*c + (u3 - u2)*m1;
+}
 
+/* frame: the parameters at u from the frame before to params */
+static void interp_frame(const frame_interp *ip, const float *params, float u, float *frame) {
+    int k;
+    
+    frame[TIME] = params[TIME];
+    for (k=1;k<NPAR;k++)
+        frame[k] = interp_value(ip->kind, ip->past[0][k], ip->past[1][k], params[k], u);
 }
 
+static void push_past(frame_interp *ip, const float *params) {
+    memcpy(ip->past[0], ip->past[1], sizeof(ip->past[1]));
+    memcpy(ip->past[1], params, sizeof(ip->past[1]));
+}
+
+static short interp_set(frame_interp *ip, short kind, short updates) {
+    if (kind < INTERP_NONE || kind > INTERP_CUBIC || updates < 1) return -1;
+    ip->kind = kind;
+    ip->updates = updates;
+    return 0;
+}
+
+/* synth_frame_interp
+ kind: INTERP_NONE (the default: the parameters of a frame apply from its
+       start), INTERP_LINEAR or INTERP_CUBIC
+ updates: area functions per frame, >= 1 (more than the samples of a frame
+       count as one per sample); Ap and f0 are interpolated whatever it is
+ returns 0, or -1 if kind or updates is not valid. It applies from the next
+ frame on.
+ */
+short synth_frame_interp(short kind, short updates) {
+    return interp_set(&legacy_interp, kind, updates);
+}
 
 /* synth_frame 
  input: 
  par: array of parameters
  buffer:  a pointer to a buffer in which one frame (5ms) of speech samples will be saved
-            size of buffer must be at least FRAME_DUR*smpfrq
+            size of buffer must be at least frame_length(smpfrq)
  mode: 1 = initialize, 2 = normal, >2 = fade-out mode for "mode" samples
+ In mode 2, the parameters are interpolated from those of the previous frame
+ as set by synth_frame_interp.
+ The memory of the simulator is kept after the fade-out and reused by the
+ next initialization, which allocates nothing after the first one.
+ returns the number of samples saved in buffer, which varies from frame to frame
+ when FRAME_DUR*smpfrq is not a whole number
+ synth_frame_f does the same with float samples (see pcm_f32)
  */
-void synth_frame(float *params, short *buffer, short mode) {
-    short i;
-    short	ns0 = 29;
-	static	area_function	*af0;
+static short frame_render(float *params, void *buffer, short format, short mode) {
+    short i, j, s0, s1, nstep;
+    short	ns0 = NP;
+	static	area_function	af0[NP];
     static short period,t0;
-    float AMpar[7];
+    static long nframe;   /* frames since the initialization */
+    float AMpar[7], frame[NPAR];
     float Ap = 0.2;
-    short nsamp = FRAME_DUR*smpfrq;
+    short nsamp = 0;
+    pcm_sink snk;
     
     for (i=0;i<AMnum;i++) AMpar[i]=params[i+AMloc];
+    sink_open(&snk, buffer, format);
     
     if (mode==1) {  // initialize
         
-        af0 = (area_function *) calloc( ns0, sizeof(area_function) );
-        nss = nbu + nph;
-        afvt  = (area_function *) calloc( nss, sizeof(area_function) );
-        convert_scale();
-        semi_polar();
+        legacy_afvt();
+        lam_setup();        /* the default model, made once per spec */
         
         lam(AMpar);				/* compute VT sagittal section */
         sagittal_to_area( &ns0, af0 );		/* compute area function from sagittal section */
@@ -196,16 +302,47 @@ void synth_frame(float *params, short *buffer, short mode) {
         
         Ap = params[AP];
         t0 = period = (short)(0.5 + smpfrq/params[F0_LOC]);
+        nframe = 0;
+        push_past(&legacy_interp, params);
+        push_past(&legacy_interp, params);
         
     }
 
-    if (mode==2) {  // normal
+    if (mode==2 && legacy_interp.kind != INTERP_NONE) {  // normal, interpolated
+        nsamp = (short)(frame_start(smpfrq, nframe+1) - frame_start(smpfrq, nframe));
+        nframe++;
+        nstep = min(legacy_interp.updates, nsamp);
+        for (j=0;j<nstep;j++) {
+            s0 = (short)((long)nsamp*j/nstep);
+            s1 = (short)((long)nsamp*(j+1)/nstep);
+            interp_frame(&legacy_interp, params, (float)s1/nsamp, frame);
+            lam(frame+AMloc);			/* compute VT sagittal section */
+            sagittal_to_area( &ns0, af0 );		/* compute area function from sagittal section */
+            appro_area_function( ns0, af0, nss, afvt);  /* make tube lengths equal */
+            for (i=s0;i<s1;i++) {
+                Ap = interp_value(legacy_interp.kind, legacy_interp.past[0][AP],
+                                  legacy_interp.past[1][AP], params[AP], (float)i/nsamp);
+                Ag = glottal_area( 'F', 'o', Ap, &t0 );  /* voice source */
+                sink_put(&snk, vtt_sim());  /* synthesize next sample */
+                period--;
+                if (period <= 0)
+                    t0 = period = (short)(0.5 + smpfrq/interp_value(legacy_interp.kind,
+                                    legacy_interp.past[0][F0_LOC], legacy_interp.past[1][F0_LOC],
+                                    params[F0_LOC], (float)(i+1)/nsamp));
+            }
+        }
+        push_past(&legacy_interp, params);
+    }
+    else if (mode==2) {  // normal
+        nsamp = (short)(frame_start(smpfrq, nframe+1) - frame_start(smpfrq, nframe));
+        nframe++;
+        push_past(&legacy_interp, params);
         lam(AMpar);				/* compute VT sagittal section */
         sagittal_to_area( &ns0, af0 );		/* compute area function from sagittal section */
         appro_area_function( ns0, af0, nss, afvt);  /* make tube lengths equal */
         for (i=0;i<nsamp;i++) {
             Ag = glottal_area( 'F', 'o', Ap, &t0 );  /* voice source */
-            buffer[i] = (short) (DACscale * vtt_sim());  /* synthesize next sample */
+            sink_put(&snk, vtt_sim());  /* synthesize next sample */
             period--;
             if (period <= 0) {
                 t0 = period = (short)(0.5 + smpfrq/params[F0_LOC]);
@@ -218,13 +355,22 @@ void synth_frame(float *params, short *buffer, short mode) {
         Ap = params[AP];
         for (i=0;i<mode;i++) {
             Ag = glottal_area( 'F', 't', Ap, &t0 );  /* voice source  'transition' */
-            buffer[i] = (short) (DACscale * vtt_sim());  /* synthesize next sample */
+            sink_put(&snk, vtt_sim());  /* synthesize next sample */
 
         }
-        vtt_term();
+        nsamp = mode;
 
     }
-    
+    sink_flush(&snk);
+    return nsamp;
+}
+
+short synth_frame(float *params, short *buffer, short mode) {
+    return frame_render(params, buffer, OUT_S16, mode);
+}
+
+short synth_frame_f(float *params, float *buffer, short mode) {
+    return frame_render(params, buffer, OUT_F32, mode);
 }
 
 /*  ----------------------------synthesize -----------------------------
@@ -235,20 +381,32 @@ void synth_frame(float *params, short *buffer, short mode) {
  
  Output:
  returns number of samples in sig_buf
+ 
+ synthesize_f does the same with float samples (see pcm_f32)
  */
 
+/* number of samples synthesize() renders for par at the rate rate: the track
+ and the 60 ms 'transition' after it */
+long synth_track_length(float rate, float **par, int time_steps) {
+    long buf_length = (par[time_steps-1][TIME]/1000)*rate, n = buf_length;
+    
+    while (n < buf_length + rate*0.06) n++;
+    return n;
+}
 
-long synthesize(float **par, short **sig_buf, int time_steps) {
+static long track_render(float **par, void **sig_buf, short format, int time_steps) {
     
     long buf_length, nextVTupdate, nextPitchUpdate, buf_count = 0L;
-    short t0, temp;  /* number of samples in a pitch period */
+    short t0;  /* number of samples in a pitch period */
     float	Ap = 0.2;
+    pcm_sink snk;
     
     buf_length = (par[time_steps-1][TIME]/1000)*smpfrq;  /* duration in sec */
     
-    if ((*sig_buf = (short *) calloc( buf_length + smpfrq*0.06, sizeof(short) ))==NULL) {
+    if ((*sig_buf = calloc( synth_track_length(smpfrq, par, time_steps), sample_size(format) ))==NULL) {
         fprintf(stderr,"%s/n","error allocating memory for wave");
     }
+    sink_open(&snk, *sig_buf, format);
     
     nextVTupdate = update_VT(par,buf_count,time_steps);   /* set initial VT area function */
     
@@ -259,9 +417,8 @@ long synthesize(float **par, short **sig_buf, int time_steps) {
     while (buf_count < buf_length) {
         
         Ag = glottal_area( 'F', 'o', Ap, &t0 );  /* voice source */
-        temp = (short) (DACscale * vtt_sim());  /* synthesize next sample */
-        //printf("%ld\t%0.3f\t%hd\n",buf_count,Ag,temp);
-        (*sig_buf)[buf_count++] = temp; /* add the sample to the sound buffer */
+        sink_put(&snk, vtt_sim());  /* synthesize next sample, add it to the sound buffer */
+        buf_count++;
         
         if (buf_count >= nextVTupdate) {
             nextVTupdate = update_VT(par,buf_count,time_steps);   /* move mouth every 5 ms */
@@ -274,14 +431,761 @@ long synthesize(float **par, short **sig_buf, int time_steps) {
     t0=update_pitch(par,buf_count,time_steps, &Ap);
     while (buf_count < buf_length + smpfrq*0.06)  {  /* 'transition' glottal vibration - 60 ms */
         Ag = glottal_area( 'F', 't', Ap, &t0 );
-        temp = (short) (DACscale * vtt_sim());  /* synthesize next sample */
-        //printf("%ld\t%0.3f\t%hd\n",buf_count,Ag,temp);
-        (*sig_buf)[buf_count++] = temp;
+        sink_put(&snk, vtt_sim());  /* synthesize next sample */
+        buf_count++;
+	}
+    sink_flush(&snk);
+    
+    return buf_count;
+}
+
+long synthesize(float **par, short **sig_buf, int time_steps) {
+    return track_render(par, (void **)sig_buf, OUT_S16, time_steps);
+}
+
+long synthesize_f(float **par, float **sig_buf, int time_steps) {
+    return track_render(par, (void **)sig_buf, OUT_F32, time_steps);
+}
+
+
+/*  ----------------------------synth_voice -----------------------------
+ The functions below do what update_VT and synthesize do, but on a
+ synth_voice instead of the globals, so that each thread can render
+ with its own voice.  lam_setup() must have been called first.
+ */
+
+/* synth_voice_ini
+ cf: configuration of the voice, e.g. filled by copy_vt_config()
+ returns 0, or -1 if memory could not be allocated
+ All the memory of the voice is allocated here and freed by synth_voice_term;
+ its utterances only reset the tract (see vtt_reset_r).
+ */
+short synth_voice_ini(synth_voice *sv, const vt_config *cf) {
+    
+    memset(&sv->gs, 0, sizeof(glottal_state));
+    sv->model = lam_default();
+    sv->cb = NULL;
+    sv->vt.cf = *cf;
+    sv->anc = cf->anc;
+    sv->vt.mem = NULL;
+    sv->vt.mem_size = 0;
+    sv->vt.cf.nss = sv->vt.cf.nbu + sv->vt.cf.nph;
+    if ((sv->afvt = (area_function *) calloc( sv->vt.cf.nss, sizeof(area_function) ))==NULL)
+        return -1;
+    if (vtt_alloc_r(&sv->vt) == 0) {    /* the tract, reset by each utterance */
+        free(sv->afvt);
+        sv->afvt = NULL;
+        return -1;
+    }
+    sv->vt.cf.afvt = sv->afvt;
+    return 0;
+}
+
+void synth_voice_term(synth_voice *sv) {
+    vtt_term_r(&sv->vt);
+    free(sv->afvt);
+    sv->afvt = NULL;
+}
+
+/* synth_voice_model
+ md: articulatory model of the voice (see lam_model_ini), or NULL for the
+ default one; md is not copied and is only read, so any number of voices may
+ share it.  Set it before the first frame and before the codebook, which
+ must have been built with the same model.
+ */
+void synth_voice_model(synth_voice *sv, const lam_model *md) {
+    sv->model = md != NULL ? md : lam_default();
+}
+
+/* synth_voice_codebook
+ cb: codebook the area functions of the voice are looked up in (see
+ codebook.h), or NULL to compute them with lam again; cb is not copied
+ returns 0, or -1 if the sections (nph, nbu) or the model of cb are not those
+ of the voice
+ */
+short synth_voice_codebook(synth_voice *sv, const af_codebook *cb) {
+    if (cb != NULL && (cb->nph != sv->vt.cf.nph || cb->nbu != sv->vt.cf.nbu
+                       || cb->model != sv->model->sum)) return -1;
+    sv->cb = cb;
+    return 0;
+}
+
+/* compute the area function of the voice for the articulatory parameters in frame */
+static void frame_area_function(synth_voice *sv, const float *frame) {
+    short ns0 = NP;
+    float AMpar[AMnum];
+    int i;
+    
+    for (i=0;i<AMnum;i++) AMpar[i] = frame[i+AMloc];
+    if (sv->cb != NULL) {
+        codebook_lookup( sv->cb, AMpar, sv->afvt );
+        return;
+    }
+    lam_r( sv->model, AMpar, &sv->prof );           /* compute VT sagittal section */
+    sagittal_to_area_r( sv->model, &sv->prof, &ns0, sv->af0 ); /* compute area function from sagittal section */
+    appro_area_function( ns0, sv->af0, sv->vt.cf.nss, sv->afvt);  /* make tube lengths equal */
+}
+
+/* new area function of the voice for frame, after the first one */
+static void move_tract(synth_voice *sv, float *frame) {
+    vt_config *cf = &sv->vt.cf;
+    
+    frame_area_function(sv, frame);
+    if( cf->nasal_tract == ON ){  /* add nose */
+        cf->anc = (float) min( cf->anc, sv->afvt[cf->nph].A );
+        sv->afvt[cf->nph].A -= cf->anc;
+    }
+}
+
+long update_VT_r(synth_voice *sv, float **par, long buf_count, int time_steps) {
+    vt_config *cf = &sv->vt.cf;
+    int target_time;
+    
+    /* Initialization */
+    if (buf_count==0L) {
+        frame_area_function(sv, par[0]);            /* first vocal tract shape */
+        if (vtt_reset_r(&sv->vt) < 0) return -1L;
+        return frame_start(cf->smpfrq, 1);  /* next update is due */
+    }
+    target_time = buf_count/cf->smpfrq * 1000;  /* get parameters for frame at target_time */
+    do time_steps--; while (par[time_steps][TIME] > target_time);
+    move_tract(sv, par[time_steps]);
+    return next_frame(cf->smpfrq, buf_count);  /* 0.005 = 5 ms */
+}
+
+/* synthesize_r: as synthesize(), with the voice sv, which can be used for the
+ next utterance on return; only sig_buf is allocated.
+ returns number of samples in sig_buf, or -1 if memory could not be allocated
+ synthesize_f_r does the same with float samples
+ */
+static long track_render_into(synth_voice *sv, float **par, void *out, short format, int time_steps) {
+    
+    vt_config *cf = &sv->vt.cf;
+    long buf_length, nextVTupdate, nextPitchUpdate, buf_count = 0L;
+    short t0;  /* number of samples in a pitch period */
+    float	Ap = 0.2;
+    pcm_sink snk;
+    
+    buf_length = (par[time_steps-1][TIME]/1000)*cf->smpfrq;  /* duration in sec */
+    sink_open(&snk, out, format);
+    
+    cf->anc = sv->anc;      /* as the voice was configured, whatever it rendered before */
+    memset(&sv->gs, 0, sizeof(glottal_state));
+    nextVTupdate = update_VT_r(sv,par,buf_count,time_steps);   /* set initial VT area function */
+    if (nextVTupdate < 0) return -1L;
+    
+    t0 = pitch_at(cf->smpfrq, par, buf_count, time_steps, &Ap);  /* set initial pitch period */
+    nextPitchUpdate = t0;
+    
+    while (buf_count < buf_length) {
+        
+        cf->Ag = glottal_area_r( &sv->gs, 'F', 'o', Ap, &t0 );  /* voice source */
+        sink_put(&snk, vtt_sim_r(&sv->vt));  /* synthesize next sample */
+        buf_count++;
+        
+        if (buf_count >= nextVTupdate) {
+            nextVTupdate = update_VT_r(sv,par,buf_count,time_steps);   /* move mouth every 5 ms */
+        }
+        if (buf_count >= nextPitchUpdate) {
+            t0 = pitch_at(cf->smpfrq, par, buf_count, time_steps, &Ap);  /* change pitch every cycle */
+            nextPitchUpdate += t0;
+        }
+    }
+    t0=pitch_at(cf->smpfrq, par, buf_count, time_steps, &Ap);
+    while (buf_count < buf_length + cf->smpfrq*0.06)  {  /* 'transition' glottal vibration - 60 ms */
+        cf->Ag = glottal_area_r( &sv->gs, 'F', 't', Ap, &t0 );
+        sink_put(&snk, vtt_sim_r(&sv->vt));
+        buf_count++;
 	}
+    sink_flush(&snk);
     
     return buf_count;
 }
 
+static long track_render_r(synth_voice *sv, float **par, void **sig_buf, short format, int time_steps) {
+    long n = synth_track_length(sv->vt.cf.smpfrq, par, time_steps);
+    
+    if ((*sig_buf = calloc( n, sample_size(format) ))==NULL) {
+        return -1L;
+    }
+    if (track_render_into(sv, par, *sig_buf, format, time_steps) < 0) {
+        free(*sig_buf);
+        *sig_buf = NULL;
+        return -1L;
+    }
+    return n;
+}
+
+long synthesize_r(synth_voice *sv, float **par, short **sig_buf, int time_steps) {
+    return track_render_r(sv, par, (void **)sig_buf, OUT_S16, time_steps);
+}
+
+long synthesize_f_r(synth_voice *sv, float **par, float **sig_buf, int time_steps) {
+    return track_render_r(sv, par, (void **)sig_buf, OUT_F32, time_steps);
+}
+
+/* synthesize_into_r: as synthesize_r, into the caller's buffer out, which holds
+ synth_track_length() samples of the format OUT_S16 or OUT_F32; nothing is
+ allocated.  returns the number of samples, or -1 if the tract could not be
+ initialized
+ */
+long synthesize_into_r(synth_voice *sv, float **par, int time_steps, void *out, short format) {
+    return track_render_into(sv, par, out, format, time_steps);
+}
+
+/*  ----------------------------synthesize_batch -----------------------------
+ Renders njobs parameter tracks with a pool of nthreads worker threads, each
+ with its own synth_voice.  Jobs are handed out one at a time, so utterances of
+ different lengths keep all the threads busy.
+ 
+ jobs: par, time_steps and model are inputs, sig_buf and length are set on return
+       (free sig_buf with free())
+ nthreads: number of threads, <= 0 for one per online processor
+ cf: configuration of the voices, NULL for the globals
+ 
+ returns 0, or -1 if a thread or memory for a job could not be allocated
+ */
+
+typedef struct {
+    synth_job *jobs;
+    int njobs;
+    int next;               /* next job to hand out */
+    int failed;
+    pthread_mutex_t lock;
+    const vt_config *cf;
+} synth_batch;
+
+static void *batch_worker(void *arg) {
+    synth_batch *b = (synth_batch *) arg;
+    synth_voice sv;
+    synth_job *job;
+    int k;
+    
+    if (synth_voice_ini(&sv, b->cf) != 0) {
+        pthread_mutex_lock(&b->lock);
+        b->failed = 1;
+        pthread_mutex_unlock(&b->lock);
+        return NULL;
+    }
+    for (;;) {
+        pthread_mutex_lock(&b->lock);
+        k = b->next++;
+        pthread_mutex_unlock(&b->lock);
+        if (k >= b->njobs) break;
+        
+        job = &b->jobs[k];
+        synth_voice_model(&sv, job->model);
+        job->length = synthesize_r(&sv, job->par, &job->sig_buf, job->time_steps);
+        if (job->length < 0) {
+            pthread_mutex_lock(&b->lock);
+            b->failed = 1;
+            pthread_mutex_unlock(&b->lock);
+        }
+    }
+    synth_voice_term(&sv);
+    return NULL;
+}
+
+int synthesize_batch(synth_job *jobs, int njobs, int nthreads, const vt_config *cf) {
+    synth_batch b;
+    vt_config gcf;
+    pthread_t *threads;
+    int i, started;
+    
+    if (cf == NULL) {
+        copy_vt_config(&gcf);
+        cf = &gcf;
+    }
+    if (nthreads <= 0) nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > njobs) nthreads = njobs;
+    if (nthreads < 1) nthreads = 1;
+    
+    for (i=0;i<njobs;i++) {
+        jobs[i].sig_buf = NULL;
+        jobs[i].length = -1L;
+    }
+    lam_setup();        /* the model is only read by the workers */
+    
+    b.jobs = jobs;
+    b.njobs = njobs;
+    b.next = 0;
+    b.failed = 0;
+    b.cf = cf;
+    pthread_mutex_init(&b.lock, NULL);
+    
+    if ((threads = (pthread_t *) calloc( nthreads, sizeof(pthread_t) ))==NULL) {
+        pthread_mutex_destroy(&b.lock);
+        return -1;
+    }
+    for (started=0;started<nthreads;started++) {
+        if (pthread_create(&threads[started], NULL, batch_worker, &b) != 0) break;
+    }
+    if (started == 0) batch_worker(&b);   /* no thread at all, render on the caller's */
+    for (i=0;i<started;i++) pthread_join(threads[i], NULL);
+    
+    free(threads);
+    pthread_mutex_destroy(&b.lock);
+    return b.failed ? -1 : 0;
+}
+
+
+/*  ----------------------------synth_framer -----------------------------
+ synth_frame on a voice of its own: the frames, modes, interpolation and
+ output are those of synth_frame and synth_frame_interp, but each framer has
+ its own tract, source and interpolation state, so that any number of them
+ can render at the same time, in as many threads.  The profile and the area
+ function of the last frame are in fr->sv.prof (unless the voice has a
+ codebook) and fr->sv.afvt.
+ */
+
+/* returns 0, or -1 if memory could not be allocated */
+short synth_framer_ini(synth_framer *fr, const vt_config *cf) {
+    
+    memset(&fr->ip, 0, sizeof(frame_interp));
+    fr->ip.kind = INTERP_NONE;
+    fr->ip.updates = 1;
+    fr->period = fr->t0 = 0;
+    fr->nframe = 0L;
+    return synth_voice_ini(&fr->sv, cf);
+}
+
+/* as synth_frame_interp, for the framer fr */
+short synth_framer_interp(synth_framer *fr, short kind, short updates) {
+    return interp_set(&fr->ip, kind, updates);
+}
+
+static short framer_render(synth_framer *fr, const float *params, void *buffer, short format, short mode) {
+    synth_voice *sv = &fr->sv;
+    vt_config *cf = &sv->vt.cf;
+    short i, j, s0, s1, nstep;
+    float frame[NPAR];
+    float Ap = 0.2;
+    short nsamp = 0;
+    pcm_sink snk;
+    
+    sink_open(&snk, buffer, format);
+    
+    if (mode==1) {  // initialize
+        cf->anc = sv->anc;      /* as the voice was configured, whatever it rendered before */
+        memset(&sv->gs, 0, sizeof(glottal_state));
+        frame_area_function(sv, params);
+        if (vtt_reset_r(&sv->vt) < 0) return -1;
+        Ap = params[AP];
+        fr->t0 = fr->period = (short)(0.5 + cf->smpfrq/params[F0_LOC]);
+        fr->nframe = 0;
+        push_past(&fr->ip, params);
+        push_past(&fr->ip, params);
+    }
+    
+    if (mode==2 && fr->ip.kind != INTERP_NONE) {  // normal, interpolated
+        nsamp = (short)(frame_start(cf->smpfrq, fr->nframe+1) - frame_start(cf->smpfrq, fr->nframe));
+        fr->nframe++;
+        nstep = min(fr->ip.updates, nsamp);
+        for (j=0;j<nstep;j++) {
+            s0 = (short)((long)nsamp*j/nstep);
+            s1 = (short)((long)nsamp*(j+1)/nstep);
+            interp_frame(&fr->ip, params, (float)s1/nsamp, frame);
+            frame_area_function(sv, frame);
+            for (i=s0;i<s1;i++) {
+                Ap = interp_value(fr->ip.kind, fr->ip.past[0][AP], fr->ip.past[1][AP],
+                                  params[AP], (float)i/nsamp);
+                cf->Ag = glottal_area_r( &sv->gs, 'F', 'o', Ap, &fr->t0 );  /* voice source */
+                sink_put(&snk, vtt_sim_r(&sv->vt));  /* synthesize next sample */
+                fr->period--;
+                if (fr->period <= 0)
+                    fr->t0 = fr->period = (short)(0.5 + cf->smpfrq/interp_value(fr->ip.kind,
+                                    fr->ip.past[0][F0_LOC], fr->ip.past[1][F0_LOC],
+                                    params[F0_LOC], (float)(i+1)/nsamp));
+            }
+        }
+        push_past(&fr->ip, params);
+    }
+    else if (mode==2) {  // normal
+        nsamp = (short)(frame_start(cf->smpfrq, fr->nframe+1) - frame_start(cf->smpfrq, fr->nframe));
+        fr->nframe++;
+        push_past(&fr->ip, params);
+        frame_area_function(sv, params);
+        for (i=0;i<nsamp;i++) {
+            cf->Ag = glottal_area_r( &sv->gs, 'F', 'o', Ap, &fr->t0 );  /* voice source */
+            sink_put(&snk, vtt_sim_r(&sv->vt));  /* synthesize next sample */
+            fr->period--;
+            if (fr->period <= 0) {
+                fr->t0 = fr->period = (short)(0.5 + cf->smpfrq/params[F0_LOC]);
+                Ap = params[AP];
+            }
+        }
+    }
+    if (mode > 2) {  // fade-out mode
+        fr->t0 = fr->period = (short)(0.5 + cf->smpfrq/params[F0_LOC]);
+        Ap = params[AP];
+        for (i=0;i<mode;i++) {
+            cf->Ag = glottal_area_r( &sv->gs, 'F', 't', Ap, &fr->t0 );  /* voice source  'transition' */
+            sink_put(&snk, vtt_sim_r(&sv->vt));
+        }
+        nsamp = mode;
+    }
+    sink_flush(&snk);
+    return nsamp;
+}
+
+/* synth_framer_frame: as synth_frame, with the framer fr; buffer holds at least
+ frame_length(rate of fr) samples, or mode in the fade-out mode.
+ returns the number of samples, or -1 if the tract could not be initialized
+ synth_framer_frame_f does the same with float samples
+ */
+short synth_framer_frame(synth_framer *fr, const float *params, short *buffer, short mode) {
+    return framer_render(fr, params, buffer, OUT_S16, mode);
+}
+
+short synth_framer_frame_f(synth_framer *fr, const float *params, float *buffer, short mode) {
+    return framer_render(fr, params, buffer, OUT_F32, mode);
+}
+
+void synth_framer_term(synth_framer *fr) {
+    synth_voice_term(&fr->sv);
+}
+
+
+/*  ----------------------------synth_stream -----------------------------
+ Streaming synthesis: the caller pushes parameter frames (rows of NPAR+1
+ values as in <par>, TIME in ms, in increasing order) and pulls the wave in
+ blocks of any size into its own buffer.  The frames are used as synthesize()
+ uses a parameter track: the tract moves every FRAME_DUR to the last frame at
+ or before that time, and the pitch is updated every cycle.  When the pulls
+ run past the last pushed frame, the last frame is held.  After
+ synth_stream_end, the voice fades out for 60 ms, as at the end of
+ synthesize(), and the stream is over.  lam_setup() must have been called.
+ 
+ A pushed frame is kept until a later frame is due, so capacity must cover the
+ frames pushed ahead of the pulls (e.g. 2 to 4 for frames pushed just in time).
+ */
+
+#define STREAM_IDLE     0   /* no frame yet */
+#define STREAM_RUN      1
+#define STREAM_FADE     2   /* 'transition' glottal vibration */
+#define STREAM_DONE     3
+
+/* returns 0, or -1 if memory could not be allocated */
+short synth_stream_ini(synth_stream *st, const vt_config *cf, int capacity) {
+    
+    if (capacity < 1) capacity = 1;
+    if ((st->queue = calloc( capacity, sizeof(*st->queue) ))==NULL)
+        return -1;
+    if (synth_voice_ini(&st->sv, cf) != 0) {
+        free(st->queue);
+        st->queue = NULL;
+        return -1;
+    }
+    st->capacity = capacity;
+    st->head = st->count = 0;
+    st->buf_count = 0L;
+    st->state = STREAM_IDLE;
+    st->ending = 0;
+    return 0;
+}
+
+/* returns 0, or -1 if the queue is full (pull some samples first) */
+int synth_stream_push(synth_stream *st, const float *frame) {
+    int i;
+    
+    if (st->count == st->capacity) return -1;
+    i = (st->head + st->count) % st->capacity;
+    memcpy(st->queue[i], frame, sizeof(*st->queue));
+    st->count++;
+    return 0;
+}
+
+/* the frame for the sample buf_count; the frames before it are dropped */
+static float *stream_frame(synth_stream *st, long buf_count) {
+    int target_time, next;
+    
+    target_time = buf_count/st->sv.vt.cf.smpfrq * 1000;
+    while (st->count > 1) {
+        next = (st->head + 1) % st->capacity;
+        if (st->queue[next][TIME] > target_time) break;
+        st->head = next;
+        st->count--;
+    }
+    return st->queue[st->head];
+}
+
+/* pitch period in samples, and Ap, for the sample buf_count */
+static short stream_pitch(synth_stream *st, long buf_count) {
+    float *frame = stream_frame(st, buf_count);
+    
+    st->Ap = frame[AP];
+    return (short) ( 0.5+ st->sv.vt.cf.smpfrq/frame[F0_LOC]);
+}
+
+/* synth_stream_pull
+ out: caller's buffer for n samples
+ returns the number of samples written in out, which is less than n only when
+ no frame has been pushed yet or the stream is over
+ synth_stream_pull_f does the same with float samples
+ */
+static long stream_render(synth_stream *st, void *out, short format, long n) {
+    synth_voice *sv = &st->sv;
+    vt_config *cf = &sv->vt.cf;
+    pcm_sink snk;
+    long i;
+    
+    if (st->state == STREAM_IDLE) {
+        if (st->count == 0) return 0L;
+        frame_area_function(sv, stream_frame(st, 0L));   /* first vocal tract shape */
+        if (vtt_reset_r(&sv->vt) < 0) {
+            st->state = STREAM_DONE;
+            return 0L;
+        }
+        st->nextVTupdate = frame_start(cf->smpfrq, 1);
+        st->t0 = stream_pitch(st, 0L);
+        st->nextPitchUpdate = st->t0;
+        st->state = STREAM_RUN;
+    }
+    sink_open(&snk, out, format);
+    
+    for (i=0;i<n;i++) {
+        if (st->state == STREAM_RUN && st->ending) {
+            st->t0 = stream_pitch(st, st->buf_count);
+            st->fade_end = st->buf_count + cf->smpfrq*0.06;
+            st->state = STREAM_FADE;
+        }
+        if (st->state == STREAM_RUN) {
+            cf->Ag = glottal_area_r( &sv->gs, 'F', 'o', st->Ap, &st->t0 );  /* voice source */
+            sink_put(&snk, vtt_sim_r(&sv->vt));  /* synthesize next sample */
+            st->buf_count++;
+            
+            if (st->buf_count >= st->nextVTupdate) {    /* move mouth every 5 ms */
+                move_tract(sv, stream_frame(st, st->buf_count));
+                st->nextVTupdate = next_frame(cf->smpfrq, st->buf_count);
+            }
+            if (st->buf_count >= st->nextPitchUpdate) {  /* change pitch every cycle */
+                st->t0 = stream_pitch(st, st->buf_count);
+                st->nextPitchUpdate += st->t0;
+            }
+        }
+        else if (st->state == STREAM_FADE) {
+            cf->Ag = glottal_area_r( &sv->gs, 'F', 't', st->Ap, &st->t0 );
+            sink_put(&snk, vtt_sim_r(&sv->vt));
+            if (++st->buf_count >= st->fade_end) st->state = STREAM_DONE;
+        }
+        else break;
+    }
+    sink_flush(&snk);
+    return i;
+}
+
+long synth_stream_pull(synth_stream *st, short *out, long n) {
+    return stream_render(st, out, OUT_S16, n);
+}
+
+long synth_stream_pull_f(synth_stream *st, float *out, long n) {
+    return stream_render(st, out, OUT_F32, n);
+}
+
+/* no more frames: the next pulls fade the voice out */
+void synth_stream_end(synth_stream *st) {
+    st->ending = 1;
+}
+
+void synth_stream_term(synth_stream *st) {
+    synth_voice_term(&st->sv);
+    free(st->queue);
+    st->queue = NULL;
+    st->state = STREAM_DONE;
+}
+
+
+/*  ----------------------------synth_rt -----------------------------
+ Real-time synthesis: a voice which always renders, e.g. from the callback of
+ an audio device, and parameter frames posted from any one other thread (the
+ GUI, a controller) through a lock-free single-producer/single-consumer queue.
+ Neither side ever waits for the other: the renderer takes the latest posted
+ frame at the start of each FRAME_DUR frame, whatever its TIME, and holds it
+ until a newer one comes; the pitch follows it every cycle.  Until the first
+ frame the output is silence.
+ 
+ synth_rt_render(_f) is the audio callback: it fills the caller's block and
+ does not allocate, lock or block.  synth_rt_start runs the same loop on a
+ thread of its own, in real time, into a file or a null sink, for testing
+ without an audio device.  lam_setup() must have been called.
+ */
+
+/* returns 0, or -1 if memory could not be allocated */
+short synth_rt_ini(synth_rt *rt, const vt_config *cf, int capacity) {
+    
+    memset(rt, 0, sizeof(synth_rt));
+    if (capacity < 1) capacity = 1;
+    if ((rt->queue = calloc( capacity, sizeof(*rt->queue) ))==NULL)
+        return -1;
+    if (synth_voice_ini(&rt->sv, cf) != 0) {
+        free(rt->queue);
+        rt->queue = NULL;
+        return -1;
+    }
+    rt->capacity = capacity;
+    atomic_init(&rt->head, 0);
+    atomic_init(&rt->tail, 0);
+    atomic_init(&rt->running, 0);
+    return 0;
+}
+
+/* producer side: returns 0, or -1 if the queue is full (the renderer has not
+ reached the next frame yet; post again later, or drop the frame) */
+int synth_rt_post(synth_rt *rt, const float *frame) {
+    unsigned long tail = atomic_load_explicit(&rt->tail, memory_order_relaxed);
+    
+    if (tail - atomic_load_explicit(&rt->head, memory_order_acquire) == (unsigned long)rt->capacity)
+        return -1;
+    memcpy(rt->queue[tail % rt->capacity], frame, sizeof(*rt->queue));
+    atomic_store_explicit(&rt->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+/* consumer side: the latest posted frame into rt->frame; returns 0 if there
+ was none */
+static int rt_take(synth_rt *rt) {
+    unsigned long head = atomic_load_explicit(&rt->head, memory_order_relaxed);
+    unsigned long tail = atomic_load_explicit(&rt->tail, memory_order_acquire);
+    
+    if (head == tail) return 0;
+    memcpy(rt->frame, rt->queue[(tail - 1) % rt->capacity], sizeof(rt->frame));
+    atomic_store_explicit(&rt->head, tail, memory_order_release);
+    return 1;
+}
+
+static short rt_pitch(synth_rt *rt) {
+    rt->Ap = rt->frame[AP];
+    return (short) ( 0.5+ rt->sv.vt.cf.smpfrq/rt->frame[F0_LOC]);
+}
+
+/* synth_rt_render
+ out: the block to fill, n samples
+ returns n, 0 if the tract could not be initialized, or -1 if the loop of
+ synth_rt_start is running (it is the renderer then)
+ synth_rt_render_f does the same with float samples
+ */
+static long rt_render(synth_rt *rt, void *out, short format, long n) {
+    synth_voice *sv = &rt->sv;
+    vt_config *cf = &sv->vt.cf;
+    pcm_sink snk;
+    long i = 0;
+    
+    sink_open(&snk, out, format);
+    if (!rt->started) {
+        if (!rt_take(rt)) {         /* silence until the first frame */
+            for (; i<n; i++) sink_put(&snk, 0.f);
+            sink_flush(&snk);
+            return n;
+        }
+        frame_area_function(sv, rt->frame);     /* first vocal tract shape */
+        if (vtt_reset_r(&sv->vt) < 0) return 0L;
+        rt->buf_count = 0L;
+        rt->nextVTupdate = frame_start(cf->smpfrq, 1);
+        rt->t0 = rt_pitch(rt);
+        rt->nextPitchUpdate = rt->t0;
+        rt->started = 1;
+    }
+    
+    for (; i<n; i++) {
+        cf->Ag = glottal_area_r( &sv->gs, 'F', 'o', rt->Ap, &rt->t0 );  /* voice source */
+        sink_put(&snk, vtt_sim_r(&sv->vt));  /* synthesize next sample */
+        rt->buf_count++;
+        
+        if (rt->buf_count >= rt->nextVTupdate) {    /* move mouth every 5 ms */
+            if (rt_take(rt)) move_tract(sv, rt->frame);
+            rt->nextVTupdate = next_frame(cf->smpfrq, rt->buf_count);
+        }
+        if (rt->buf_count >= rt->nextPitchUpdate) {  /* change pitch every cycle */
+            rt->t0 = rt_pitch(rt);
+            rt->nextPitchUpdate += rt->t0;
+        }
+    }
+    sink_flush(&snk);
+    return n;
+}
+
+long synth_rt_render(synth_rt *rt, short *out, long n) {
+    if (atomic_load(&rt->running)) return -1L;
+    return rt_render(rt, out, OUT_S16, n);
+}
+
+long synth_rt_render_f(synth_rt *rt, float *out, long n) {
+    if (atomic_load(&rt->running)) return -1L;
+    return rt_render(rt, out, OUT_F32, n);
+}
+
+/* the render loop of synth_rt_start: a block every block/smpfrq seconds */
+static void *rt_loop(void *arg) {
+    synth_rt *rt = (synth_rt *) arg;
+    struct timespec due, now;
+    double period = rt->block/rt->sv.vt.cf.smpfrq;
+    long n;
+    
+    clock_gettime(CLOCK_MONOTONIC, &due);
+    while (atomic_load_explicit(&rt->running, memory_order_acquire)) {
+        n = rt_render(rt, rt->blk, rt->format, rt->block);
+        if (rt->out != NULL && n > 0)
+            fwrite(rt->blk, rt->format == OUT_F32 ? sizeof(float) : sizeof(short), n, rt->out);
+        rt->rendered += n;
+        
+        due.tv_nsec += (long)(period*1e9);
+        while (due.tv_nsec >= 1000000000L) {
+            due.tv_nsec -= 1000000000L;
+            due.tv_sec++;
+        }
+        if (!rt->paced) continue;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > due.tv_sec || (now.tv_sec == due.tv_sec && now.tv_nsec > due.tv_nsec))
+            rt->late++;         /* an audio device would have run dry */
+        else
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+    }
+    return NULL;
+}
+
+/* synth_rt_start
+ out: file the samples are written to (e.g. raw 16 bit for OUT_S16), or NULL
+      for a null sink
+ block: samples per block; paced: 1 to render a block per block duration, as
+      an audio device would pull them, 0 to render as fast as possible
+ returns 0, or -1 if the loop is running already or could not be started
+ */
+short synth_rt_start(synth_rt *rt, FILE *out, short format, long block, short paced) {
+    
+    if (atomic_load(&rt->running) || block < 1) return -1;
+    if ((rt->blk = calloc( block, sample_size(format) ))==NULL)
+        return -1;
+    rt->out = out;
+    rt->format = format;
+    rt->block = block;
+    rt->paced = paced;
+    atomic_store(&rt->running, 1);
+    if (pthread_create(&rt->thread, NULL, rt_loop, rt) != 0) {
+        atomic_store(&rt->running, 0);
+        free(rt->blk);
+        rt->blk = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/* stops the loop of synth_rt_start, after the block in progress */
+void synth_rt_stop(synth_rt *rt) {
+    
+    if (!atomic_load(&rt->running)) return;
+    atomic_store(&rt->running, 0);
+    pthread_join(rt->thread, NULL);
+    free(rt->blk);
+    rt->blk = NULL;
+}
+
+void synth_rt_term(synth_rt *rt) {
+    synth_rt_stop(rt);
+    synth_voice_term(&rt->sv);
+    free(rt->queue);
+    rt->queue = NULL;
+}
+
 
 /* some Maeda model specifications for vowels
 0 Jaw position  1 Tongue dorsum position    2 Tongue dorsum shape   3 Tongue apex position
@@ -298,9 +1202,12 @@ float iw[7]=  {   0.5, -1.0, 1.0, -2.0, -0.5,  1.0, 0.0 };    /* iw */
 float ew[7]=  {   0.0, -0.2, 1.0, -1.5, -0.25, 0.5, 0.0 };    /* ew */
 float oe[7]=  {   -1.0, -0.5, 0.5, -2.0,  0.2, -0.5, 0.0 };   /* oe */
 
+/* test driver; compile with -DSYNTHESIZE_NO_MAIN to link this file into
+ another program (e.g. bench.c) */
+#ifndef SYNTHESIZE_NO_MAIN
 int main() {
     
-    short bufsize = (short)(FRAME_DUR*smpfrq);
+    short bufsize = frame_length(smpfrq);
     short buffer[bufsize];
     short final_buffer[bufsize*10];
     float parameters[NPAR],target1[NPAR],target2[NPAR];
@@ -339,7 +1246,7 @@ int main() {
         if (i>20 && i<80) {
             for (j=0; j<NPAR; j++) parameters[j] = target1[j] + d[j]*(i-20.0);
         }
-        synth_frame(parameters, buffer, 2);
+        n = synth_frame(parameters, buffer, 2);
         
         /* at this point in the calling code you can refer to evt[i].x and evt[i].y to 
             draw the "passive" surface of the vocal tract, and ivt[i].x and ivt[i].y to
@@ -352,7 +1259,7 @@ int main() {
         }
         */
          
-        if ((num_written = fwrite( buffer, sizeof(short), bufsize, soundfile )) != bufsize) {
+        if ((num_written = fwrite( buffer, sizeof(short), n, soundfile )) != n) {
             printf("%s\n","write to file failed");
         }
     }
@@ -365,6 +1272,7 @@ int main() {
 
     
 }
+#endif
 /*
 int main() {
     
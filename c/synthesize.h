@@ -0,0 +1,176 @@
+#ifndef SYNTHESIZE_H
+#define SYNTHESIZE_H
+
+//
+//  synthesize.h
+//  maeda
+//
+//  Parameter layout of synthesize.c, and the synthesizer "voice" which
+//  groups everything one utterance needs, so that several utterances
+//  can be rendered at the same time.
+//
+
+#include	<stdio.h>
+#include	<pthread.h>
+#include	<stdatomic.h>
+#include	"vtconfig.h"
+#include	"lam_lib.h"
+#include	"vsyn_lib.h"
+#include	"codebook.h"
+
+/* parameter matrix - a sequence of frames  */
+#define NPAR 10     /* number of model parameters per frame */
+#define AMloc 3     /* starting location of the 7 Maeda model parameters */
+#define AMnum 7     /* how many Maeda model parameters are there */
+#define TIME 0  /* index of the time value of the frame */
+#define F0_LOC 1 /* index of the f0 value */
+#define AP 2 /* target amplitude of glottal opening */
+#define FRAME_DUR 0.005  /* duration (seconds) of a frame */
+
+/* sample formats of the output */
+#define OUT_S16 0   /* short, DACscale*vtt_sim() saturated to the short range */
+#define OUT_F32 1   /* float, 1.0 = full scale of OUT_S16 */
+
+/* sub-frame interpolation of synth_frame (see synth_frame_interp) */
+#define INTERP_NONE   0
+#define INTERP_LINEAR 1
+#define INTERP_CUBIC  2
+
+/* NOTE BY RLS
+  The values of NPAR and AMnum are incorrect as given. They should be 11 and 8,
+  i.e. they are really 'last index', not 'number of'.
+  This probably hasn't mattered since the last parameter (nasal coupling) is
+  is always 0 in this code.
+*/
+
+/*   The columns in <par>:
+ 0 time
+ 1 f0
+ 2 max glottal opening
+ 3 Jaw position             <- Artic model params start here
+ 4 Tongue dorsum position
+ 5 Tongue dorsum shape
+ 6 Tongue apex position
+ 7 Lip height (aperture)
+ 8 Lip protrusion
+ 9 Larynx height
+ 10 Nasal coupling (cm2)  *** not used? ***
+  */
+
+typedef struct {
+    const lam_model *model;     /* articulatory model, shared, not owned */
+    vtt_context     vt;         /* the tract; vt.cf is the voice configuration */
+    float           anc;        /* nasal coupling of the configuration, which */
+                                /* each utterance starts from (vt.cf.anc moves) */
+    glottal_state   gs;         /* the voice source */
+    vt_profile      prof;       /* VT profile of the current frame */
+    area_function   af0[NP];    /* area function from the profile */
+    area_function   *afvt;      /* ... with nss equal sections, vt.cf.afvt */
+    const af_codebook *cb;      /* if not NULL, afvt is looked up in it and */
+                                /* prof and af0 are not computed */
+} synth_voice;
+
+/* sub-frame interpolation state of a frame-by-frame voice */
+typedef struct {
+    short   kind, updates;      /* see synth_frame_interp */
+    float   past[2][NPAR];      /* the two frames (NPAR floats) before the current one, [1] the latest */
+} frame_interp;
+
+/* A voice rendered frame by frame, as synth_frame does with the globals.  All
+ the memory is allocated by synth_framer_ini. */
+typedef struct {
+    synth_voice sv;
+    frame_interp ip;
+    short   period, t0;
+    long    nframe;             /* frames since the initialization */
+} synth_framer;
+
+typedef struct {
+    float   **par;          /* parameter track, as for synthesize() */
+    int     time_steps;     /* number of frames in par */
+    const lam_model *model; /* articulatory model, NULL for the default one */
+    short   *sig_buf;       /* the wave, allocated by synthesize_batch */
+    long    length;         /* number of samples in sig_buf, -1 on error */
+} synth_job;
+
+/* A stream: parameter frames are pushed as they come, and the wave is pulled
+ in blocks of any size.  All the memory is allocated by synth_stream_ini. */
+typedef struct {
+    synth_voice sv;
+    float   (*queue)[NPAR+1];   /* pushed frames, the oldest at head */
+    int     capacity, head, count;
+    long    buf_count;          /* samples pulled so far */
+    long    nextVTupdate, nextPitchUpdate, fade_end;
+    short   t0;
+    float   Ap;
+    short   state;              /* see synthesize.c */
+    short   ending;             /* synth_stream_end was called */
+} synth_stream;
+
+/* A real-time voice: frames are posted from another thread through a lock-free
+ queue, and the wave is rendered in blocks, e.g. by an audio callback (see
+ synthesize.c).  All the memory is allocated by synth_rt_ini. */
+typedef struct {
+    synth_voice sv;
+    float   (*queue)[NPAR+1];   /* posted frames, a ring of capacity slots */
+    int     capacity;
+    atomic_ulong head, tail;    /* frames taken and posted so far */
+    float   frame[NPAR+1];      /* the frame in use */
+    short   started;            /* the first frame has come */
+    long    buf_count, nextVTupdate, nextPitchUpdate;
+    short   t0;
+    float   Ap;
+    
+    /* the render loop of synth_rt_start */
+    pthread_t   thread;
+    atomic_int  running;
+    FILE    *out;               /* NULL for a null sink */
+    short   format, paced;
+    long    block;
+    void    *blk;               /* block samples */
+    long    rendered;           /* samples rendered by the loop */
+    long    late;               /* blocks rendered after they were due */
+} synth_rt;
+
+long    update_VT(float **par, long buf_count, int time_steps);
+short   update_pitch(float **par, long buf_count, int time_steps, float *Ap);
+short   synth_frame(float *params, short *buffer, short mode);
+short   synth_frame_f(float *params, float *buffer, short mode);
+short   synth_frame_interp(short kind, short updates);
+short   frame_length(float rate);
+long    synthesize(float **par, short **sig_buf, int time_steps);
+long    synthesize_f(float **par, float **sig_buf, int time_steps);
+long    synth_track_length(float rate, float **par, int time_steps);
+
+short   synth_voice_ini(synth_voice *sv, const vt_config *cf);
+void    synth_voice_term(synth_voice *sv);
+short   synth_voice_codebook(synth_voice *sv, const af_codebook *cb);
+void    synth_voice_model(synth_voice *sv, const lam_model *md);
+long    update_VT_r(synth_voice *sv, float **par, long buf_count, int time_steps);
+long    synthesize_r(synth_voice *sv, float **par, short **sig_buf, int time_steps);
+long    synthesize_f_r(synth_voice *sv, float **par, float **sig_buf, int time_steps);
+long    synthesize_into_r(synth_voice *sv, float **par, int time_steps, void *out, short format);
+int     synthesize_batch(synth_job *jobs, int njobs, int nthreads, const vt_config *cf);
+
+short   synth_stream_ini(synth_stream *st, const vt_config *cf, int capacity);
+int     synth_stream_push(synth_stream *st, const float *frame);
+long    synth_stream_pull(synth_stream *st, short *out, long n);
+long    synth_stream_pull_f(synth_stream *st, float *out, long n);
+void    synth_stream_end(synth_stream *st);
+void    synth_stream_term(synth_stream *st);
+
+short   synth_framer_ini(synth_framer *fr, const vt_config *cf);
+short   synth_framer_interp(synth_framer *fr, short kind, short updates);
+short   synth_framer_frame(synth_framer *fr, const float *params, short *buffer, short mode);
+short   synth_framer_frame_f(synth_framer *fr, const float *params, float *buffer, short mode);
+void    synth_framer_term(synth_framer *fr);
+
+short   synth_rt_ini(synth_rt *rt, const vt_config *cf, int capacity);
+int     synth_rt_post(synth_rt *rt, const float *frame);
+long    synth_rt_render(synth_rt *rt, short *out, long n);
+long    synth_rt_render_f(synth_rt *rt, float *out, long n);
+short   synth_rt_start(synth_rt *rt, FILE *out, short format, long block, short paced);
+void    synth_rt_stop(synth_rt *rt);
+void    synth_rt_term(synth_rt *rt);
+
+#endif
@@ -0,0 +1,158 @@
+/*****
+*	File :	test_bank.c
+*	Note :	Checks the voice bank (vtt_bank.c) against the simulator
+*		of one voice (vtt_lib.c): each lane of a bank and a
+*		vtt_context of the same configuration are given the same
+*		area functions and glottal areas, the lanes different
+*		ones, and their outputs must agree sample by sample, for
+*		each combination of nasal_tract, wall and rad_boundary,
+*		and with a simulation rate which is not a multiple of the
+*		output rate.
+*
+*		Build and run, from this directory (add e.g. -mavx2 to
+*		check the vector code of vtt_bank.c):
+*
+*		  cc -O2 -DSYNTHESIZE_NO_MAIN -o test_bank test_bank.c \
+*		     vtt_bank.c synthesize.c vtt_lib.c lam_lib.c vsyn_lib.c \
+*		     codebook.c -lm -lpthread
+*		  ./test_bank
+*
+*		It prints the largest difference of each case, relative
+*		to the largest output, and exits with 1 if one is above
+*		TOL.
+*****/
+
+#include	"always.h"
+#include	"synthesize.h"
+#include	"vtt_bank.h"
+
+#define	NSMP	4000		/* output samples per case		*/
+#define	TOL	1e-3		/* relative difference, at most		*/
+
+extern	float	iy[7], uw[7];
+
+/*****
+*	Function : lane_shape
+*	Note :	The area function (nss sections) of the lane l at the
+*		sample i: an [i]-[u] transition, a frame every 5 ms, at a
+*		speed and phase of its own.
+*****/
+
+static	void	lane_shape ( const vt_config *cf, int l, long i, area_function *af )
+{
+	area_function	af0[NP];
+	vt_profile	prof;
+	float	p[AMnum], f;
+	long	frm = (long)(FRAME_DUR*cf->smpfrq);
+	short	ns0 = NP;
+	int	j;
+
+	f = (float)fabs( sin( 0.02*(l + 1)*(i/frm) + 0.4*l ) );
+	for( j=0; j<AMnum; j++) p[j] = f*iy[j] + (1-f)*uw[j];
+	lam_r( lam_default(), p, &prof );
+	sagittal_to_area_r( lam_default(), &prof, &ns0, af0 );
+	appro_area_function( ns0, af0, cf->nss, af );
+}
+
+/*****
+*	Function : check_case
+*	Note :	Runs the bank and VB_LANES single voices of cf for NSMP
+*		samples.  Returns the largest difference, relative to the
+*		largest output.
+*****/
+
+static	double	check_case ( const vt_config *cf )
+{
+	vtt_bank	vb;
+	vtt_context	vt[VB_LANES];
+	area_function	*af;
+	glottal_state	gs[VB_LANES];
+	float	out[VB_LANES], ag, y;
+	short	t0[VB_LANES], period;
+	double	diff = 0, peak = 0;
+	long	frm = (long)(FRAME_DUR*cf->smpfrq), i;
+	int	l;
+
+	af = (area_function *) calloc( (size_t)2*VB_LANES*cf->nss, sizeof(area_function) );
+	memset( &vb, 0, sizeof(vb) );
+	memset( gs, 0, sizeof(gs) );
+	vb.cf = *cf;
+	for( l=0; l<VB_LANES; l++)
+	{  vb.afvt[l] = af + (size_t)l*cf->nss;
+	   lane_shape( cf, l, 0, vb.afvt[l] );
+	   vb.Ag[l] = 0;
+	   vb.Psub[l] = cf->Psub;
+	   vb.anc[l] = cf->anc;
+	   memset( &vt[l], 0, sizeof(vtt_context) );
+	   vt[l].cf = *cf;
+	   vt[l].cf.afvt = af + (size_t)(VB_LANES + l)*cf->nss;
+	   vt[l].cf.Ag = 0;
+	   memcpy( vt[l].cf.afvt, vb.afvt[l], cf->nss*sizeof(area_function) );
+	   vtt_ini_r( &vt[l] );
+	   t0[l] = 0;
+	}
+	vtt_bank_ini( &vb );
+
+	for( i=0; i<NSMP; i++)
+	{  for( l=0; l<VB_LANES; l++)
+	   {  if( i%frm == 0 && i > 0 )
+	      {  lane_shape( cf, l, i, vb.afvt[l] );
+		 memcpy( vt[l].cf.afvt, vb.afvt[l], cf->nss*sizeof(area_function) );
+	      }
+	      period = (short)(cf->smpfrq/(100. + 10*l) + 0.5);
+	      if( i%period == 0 ) t0[l] = period;
+	      ag = glottal_area_r( &gs[l], 'F', 'o', 0.2f, &t0[l] );
+	      vb.Ag[l] = vt[l].cf.Ag = ag;
+	   }
+	   vtt_bank_sim( &vb, out );
+	   for( l=0; l<VB_LANES; l++)
+	   {  y = vtt_sim_r( &vt[l] );
+	      if( fabs( y - out[l] ) > diff ) diff = fabs( y - out[l] );
+	      if( fabs( y ) > peak ) peak = fabs( y );
+	   }
+	}
+
+	vtt_bank_term( &vb );
+	for( l=0; l<VB_LANES; l++) vtt_term_r( &vt[l] );
+	free( af );
+	return( peak > 0 ? diff/peak : diff );
+}
+
+int	main ( void )
+{
+	static const char	*nasal_name[] = { "OFF", "ON" };
+	static const char	*wall_name[] = { "RIGID", "YIELDING" };
+	static const char	*rad_name[] = { "SHORT_CIRCUIT", "RL_CIRCUIT",
+					       "BESSEL_FUNCTION" };
+	vt_config	cf, cc;
+	double	d;
+	int	nasal, wal, rad, bad = 0;
+
+	copy_vt_config( &cf );
+	cf.nss = cf.nbu + cf.nph;
+	lam_setup();
+	printf( "%d lanes, %d samples per case\n", VB_LANES, NSMP );
+
+	for( nasal=OFF; nasal<=ON; nasal++)
+	for( wal=RIGID; wal<=YIELDING; wal++)
+	for( rad=SHORT_CIRCUIT; rad<=BESSEL_FUNCTION; rad++)
+	{  cc = cf;
+	   cc.nasal_tract = (short)nasal;
+	   cc.anc = nasal == ON ? 0.2f : 0.f;
+	   cc.wall = (short)wal;
+	   cc.rad_boundary = (short)rad;
+	   d = check_case( &cc );
+	   bad += d > TOL;
+	   printf( "nasal %-3s %-8s %-15s %10.2e %s\n", nasal_name[nasal],
+		   wall_name[wal], rad_name[rad], d, d > TOL ? "FAILED" : "ok" );
+	}
+
+	cc = cf;			/* deci not an integer: 3.4 rounds to 3 */
+	cc.simfrq = 3.4f*cf.smpfrq;
+	d = check_case( &cc );
+	bad += d > TOL;
+	printf( "simfrq %.0f Hz (smpfrq %.0f Hz) %19.2e %s\n", cc.simfrq,
+		cc.smpfrq, d, d > TOL ? "FAILED" : "ok" );
+
+	return( bad > 0 );
+}
@@ -0,0 +1,84 @@
+/*****
+*	File :	test_invert.c
+*	Note :	Checks that inv_build gives the same codebook, whatever
+*		the threads which share the work: for each of 1, 2, 4 and
+*		8 threads, the size, the entries, their keys and the tree
+*		must be those of one thread, and a codebook written and
+*		read back must be the same.
+*
+*		Build and run, from this directory (add -fsanitize=address
+*		to check the accesses as well):
+*
+*		  cc -O2 -DSYNTHESIZE_NO_MAIN -o test_invert test_invert.c \
+*		     invert.c vtf_lib.c synthesize.c vtt_lib.c lam_lib.c \
+*		     vsyn_lib.c codebook.c -lm -lpthread
+*		  ./test_invert
+*
+*		It exits with 1 if a check fails.
+*****/
+
+#include	"always.h"
+#include	"synthesize.h"
+#include	"invert.h"
+
+#define	NPOINTS	3000		/* articulations of each codebook	*/
+#define	SEED	1
+#define	NFMT	4
+
+/*****
+*	Function : same_codebook
+*	Note :	Whether a and b hold the same entries, keys and tree.
+*****/
+
+static	int	same_codebook ( const inv_codebook *a, const inv_codebook *b )
+{
+	return( a->size == b->size && a->nfmt == b->nfmt
+	     && memcmp( a->para, b->para, a->size*IV_NPAR*sizeof(float) ) == 0
+	     && memcmp( a->key, b->key, a->size*a->nfmt*sizeof(float) ) == 0
+	     && memcmp( a->dim, b->dim, a->size ) == 0 );
+}
+
+int	main ( void )
+{
+	static const int	threads[] = { 2, 4, 8 };
+	vt_config	cf;
+	inv_codebook	ib1, ib, rd;
+	float	lo[IV_NPAR], hi[IV_NPAR];
+	short	r;
+	int	i, ok, bad = 0;
+
+	memset( &rd, 0, sizeof(rd) );
+	copy_vt_config( &cf );
+	lam_setup();
+	for( i=0; i<IV_NPAR; i++)
+	{  lo[i] = -3.0f;
+	   hi[i] = 3.0f;
+	}
+
+	r = inv_build( &ib1, &cf, NPOINTS, SEED, lo, hi, NFMT, 90, 5000, 1 );
+	printf( "1 thread   %s, %ld of %d entries kept\n", inv_error( r ),
+		ib1.size, NPOINTS );
+	if( r != IV_OK || ib1.size < 1 ) return( 1 );
+
+	for( i=0; i<(int)(sizeof(threads)/sizeof(threads[0])); i++)
+	{  r = inv_build( &ib, &cf, NPOINTS, SEED, lo, hi, NFMT, 90, 5000,
+			  threads[i] );
+	   ok = r == IV_OK && same_codebook( &ib1, &ib );
+	   bad += !ok;
+	   printf( "%d threads  %s, %ld entries %s\n", threads[i], inv_error( r ),
+		   ib.size, ok ? "ok" : "FAILED" );
+	   inv_term( &ib );
+	}
+
+	r = inv_write( &ib1, "test_invert.bin" );
+	if( r == IV_OK ) r = inv_read( &rd, "test_invert.bin" );
+	ok = r == IV_OK && same_codebook( &ib1, &rd );
+	bad += !ok;
+	printf( "written and read back  %s %s\n", inv_error( r ),
+		ok ? "ok" : "FAILED" );
+	remove( "test_invert.bin" );
+
+	inv_term( &rd );
+	inv_term( &ib1 );
+	return( bad > 0 );
+}
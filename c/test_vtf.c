@@ -0,0 +1,114 @@
+/*****
+*	File :	test_vtf.c
+*	Note :	Checks the formant search of vtf_lib.c on a uniform tube,
+*		17.5 cm long and closed at the glottis, whose formants are
+*		near 500, 1500, 2500 and 3500 Hz: vtf_formants_r must
+*		return nfmt formants within TOL of those, for each wall
+*		and radiation option and with flo 0 (below the wall
+*		resonance) or 90 Hz, and must not touch F and B beyond
+*		nfmt; vtf_formants_batch must give the same on each row.
+*
+*		Build and run, from this directory (add -fsanitize=address
+*		to check the accesses as well):
+*
+*		  cc -O2 -DSYNTHESIZE_NO_MAIN -o test_vtf test_vtf.c \
+*		     vtf_lib.c synthesize.c vtt_lib.c lam_lib.c vsyn_lib.c \
+*		     codebook.c -lm -lpthread
+*		  ./test_vtf
+*
+*		It exits with 1 if a check fails.
+*****/
+
+#include	"always.h"
+#include	"synthesize.h"
+#include	"vtf_lib.h"
+
+#define	NFMT	4		/* formants sought			*/
+#define	GUARD	4		/* floats after them, not to be touched	*/
+#define	ROWS	3		/* area functions of the batch		*/
+#define	LENGTH	17.5		/* of the tube, cm			*/
+#define	TOL	0.1		/* relative distance from (2k+1)*500 Hz	*/
+
+/*****
+*	Function : check_formants
+*	Note :	The checks of the NFMT formants F and B, n of them found,
+*		for the case name, and of the GUARD floats after them if
+*		last.  Returns the failures.
+*****/
+
+static	int	check_formants ( const char *name, short n, const float *F,
+				 const float *B, int last )
+{
+	int	k, bad = 0;
+
+	if( n != NFMT ) bad++;
+	for( k=0; k<NFMT; k++)
+	   if( !(fabs( F[k]/(500.0*(2*k + 1)) - 1 ) < TOL) || !(B[k] > 0) ) bad++;
+	for( k=NFMT; k<NFMT+GUARD && last; k++)
+	   if( F[k] != 6400.f + 100*k || B[k] != 6400.f + 100*k ) bad++;
+	printf( "%-36s %2d %7.1f %7.1f %7.1f %7.1f %s\n", name, n, F[0], F[1],
+		F[2], F[3], bad ? "FAILED" : "ok" );
+	return( bad );
+}
+
+static	void	guard ( float *F, float *B )
+{
+	int	k;
+
+	for( k=NFMT; k<NFMT+GUARD; k++) F[k] = B[k] = 6400.f + 100*k;
+}
+
+int	main ( void )
+{
+	static const char	*wall_name[] = { "RIGID", "YIELDING" };
+	static const char	*rad_name[] = { "SHORT_CIRCUIT", "RL_CIRCUIT",
+					       "BESSEL_FUNCTION" };
+	vtf_context	vf;
+	area_function	*af;
+	float	F[ROWS*NFMT+GUARD], B[ROWS*NFMT+GUARD], flo;
+	short	n;
+	char	name[80];
+	int	nss, i, wal, rad, bad = 0;
+
+	copy_vt_config( &vf.cf );
+	nss = vf.cf.nph + vf.cf.nbu;
+	af = (area_function *) malloc( ROWS*nss*sizeof(area_function) );
+	for( i=0; i<ROWS*nss; i++)
+	{  af[i].A = 3.0f;
+	   af[i].x = (float)(LENGTH/nss);
+	}
+	vf.cf.afvt = af;
+	vf.cf.nasal_tract = OFF;
+	vf.cf.glt_boundary = CLOSE;
+	vf.cf.source_loc = 0;
+	vf.cf.source_typ = FLOW;
+	if( vtf_ini_r( &vf, VTF_GRID ) )
+	{  printf( "vtf_ini_r failed\n" );
+	   return( 1 );
+	}
+
+	for( wal=RIGID; wal<=YIELDING; wal++)
+	for( rad=SHORT_CIRCUIT; rad<=BESSEL_FUNCTION; rad++)
+	for( flo=0; flo<=90; flo+=90)
+	{  vf.cf.wall = (short)wal;
+	   vf.cf.rad_boundary = (short)rad;
+	   guard( F, B );
+	   n = vtf_formants_r( &vf, flo, 5000, NFMT, F, B );
+	   sprintf( name, "%-8s %-15s flo %2.0f", wall_name[wal],
+		    rad_name[rad], flo );
+	   bad += check_formants( name, n, F, B, 1 );
+
+	   guard( F + (ROWS-1)*NFMT, B + (ROWS-1)*NFMT );
+	   n = vtf_formants_batch( &vf.cf, af, NULL, ROWS, flo, 5000, NFMT,
+				   F, B, 2 );
+	   for( i=0; i<ROWS; i++)
+	   {  sprintf( name, "  vtf_formants_batch row %d", i );
+	      bad += check_formants( name, (short)(n == 0 ? NFMT : n),
+				     F + i*NFMT, B + i*NFMT, i == ROWS-1 );
+	   }
+	}
+
+	vtf_term_r( &vf );
+	free( af );
+	return( bad > 0 );
+}
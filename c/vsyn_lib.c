@@ -8,6 +8,9 @@
 #include	<math.h>
 #include    "vtconfig.h"
 #include	"vsyn_lib.h"
+#ifdef __SSE2__
+#include	<emmintrin.h>
+#endif
 
 /****************( externally defined global variables )*******************/
 
@@ -26,7 +29,8 @@ extern	float	Ag;
 *		area is returned by value to the calling program.
 *****/
 
-float	glottal_area (
+float	glottal_area_r (
+	glottal_state *gs,	/* state of the source of one voice	  */
 	char	model,		/* 'F' for Fant, 'M' for Maeda model	  */
 	char	mode,		/* 'o' for oscilating, 't' for transition */
 	float	Ap,		/* peak glottal area (cm2) with mode=1,	  */
@@ -40,12 +44,14 @@ float	glottal_area (
 				/* model.				  */
 	float	wp, oqM, cqM;	/* time warping coefficients for Maeda's  */
 				/* model.				  */
-	static	short	n;
-	static	float	amp;
-	static	short	t1, t2, t3;
-	static	float	a, b, A, A0;
+	short	n = gs->n;
+	float	amp = gs->amp;
+	short	t1 = gs->t1, t2 = gs->t2, t3 = gs->t3;
+	float	a = gs->a, b = gs->b, A = gs->A, A0 = gs->A0;
 	float	t;
 
+	if( mode != 'o' && mode != 't' ) return 0;
+
 /*** oscilation mode ***/
 	if(mode == 'o' ) {
         if( *t0 > 0 ) {		/* set a new glottal cycle */
@@ -81,7 +87,6 @@ float	glottal_area (
         }
         if( n >= t3 ) amp = 0.0;			/* closed */
         n++;
-        return( amp );
 	}
 /*** transion mode ***/
 	if( mode == 't' ) {
@@ -97,9 +102,74 @@ float	glottal_area (
         if( n < t1 ) amp = (float)(A0 + A*(1. - cos(a*n)));
         else         amp = Ap;
         n++;
-        return( amp );
 	}
-	return 0;
+
+	gs->n = n;
+	gs->amp = amp;
+	gs->t1 = t1; gs->t2 = t2; gs->t3 = t3;
+	gs->a = a; gs->b = b; gs->A = A; gs->A0 = A0;
+	return( amp );
+}
+
+/*****
+*	Function : glottal_area
+*	Note :	Same as glottal_area_r, for the single source of a main.
+*****/
+
+float	glottal_area ( char model, char mode, float Ap, short *t0 )
+{
+	static	glottal_state	gs;
+
+	return( glottal_area_r( &gs, model, mode, Ap, t0 ) );
+}
+
+/*****
+*	Functions : pcm_s16, pcm_f32
+*	Note :	Convert n output samples of vtt_sim, x, into 16 bits
+*		integers, (short)(DACscale*x) saturated to the short
+*		range instead of wrapping around, or into floats where
+*		1.0 is the full scale of the integers.  The integer
+*		conversion runs 8 samples at a time with SSE2; the
+*		products are in double, as in (short)(DACscale*x), so
+*		that both paths give the same values.
+*****/
+
+void	pcm_s16 ( const float *x, short *y, long n )
+{
+	long	i = 0;
+	double	v;
+
+#ifdef __SSE2__
+	const __m128d	scale = _mm_set1_pd( DACscale );
+	const __m128d	hi = _mm_set1_pd( 32767. ), lo = _mm_set1_pd( -32768. );
+	__m128	a, b;
+	__m128i	p, q;
+
+	for( ; i+8<=n; i+=8)
+	{  a = _mm_loadu_ps( x+i );
+	   b = _mm_loadu_ps( x+i+4 );
+#define	S16_PAIR(f)	_mm_cvttpd_epi32( _mm_max_pd( lo, _mm_min_pd( hi, \
+			_mm_mul_pd( scale, _mm_cvtps_pd( f ) ) ) ) )
+	   p = _mm_unpacklo_epi64( S16_PAIR(a), S16_PAIR(_mm_movehl_ps( a, a )) );
+	   q = _mm_unpacklo_epi64( S16_PAIR(b), S16_PAIR(_mm_movehl_ps( b, b )) );
+#undef	S16_PAIR
+	   _mm_storeu_si128( (__m128i *)(y+i), _mm_packs_epi32( p, q ) );
+	}
+#endif
+	for( ; i<n; i++)
+	{  v = DACscale*x[i];
+	   if( v >  32767. ) v =  32767.;
+	   if( v < -32768. ) v = -32768.;
+	   y[i] = (short) v;
+	}
+}
+
+void	pcm_f32 ( const float *x, float *y, long n )
+{
+	const float	scale = (float)(DACscale/32768.);
+	long	i;
+
+	for( i=0; i<n; i++) y[i] = scale*x[i];
 }
 
 /*****
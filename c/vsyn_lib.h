@@ -6,10 +6,23 @@
 *	Note :	Prototypes etc..
 *****/
 
+#include "vtt_lib.h"
+
 #define	DACscale 10000.0		/* scale-up signal to fit 16 bits integer */
 #define gltDACscale 100.*DACscale	/* sacle up for glottal source */
 
+typedef struct {			/* state of glottal_area_r */
+	short	n;
+	float	amp;
+	short	t1, t2, t3;
+	float	a, b, A, A0;
+} glottal_state;
+
 float	glottal_area( char model, char mode, float Ap, short *t0 );
+float	glottal_area_r( glottal_state *gs, char model, char mode, float Ap,
+			short *t0 );
+void	pcm_s16( const float *x, short *y, long n );
+void	pcm_f32( const float *x, float *y, long n );
 void	vowel_synthesis( FILE *sig_file );
 
 short	vtt_ini( );
@@ -25,6 +25,31 @@
 /*************************( typedefs )***********************************/
 typedef struct{ float A, x; } area_function;
 
+/*****
+*	The same configuration gathered in a structure, so that each
+*	simulator instance (see vtt_lib.h) can carry its own copy.
+*	Field names and meanings are those of the globals below.
+*****/
+typedef struct{
+	float		simfrq, smpfrq;		/* rates in Hz			*/
+	short		decim_taps;		/* decimation filter		*/
+	float		decim_cutoff;
+	float		Psub, Ag, xg, lg, Kc;	/* glottis and lungs		*/
+	short		nbu, nph, nvt;		/* VT sections			*/
+	area_function	*afvt;			/* AF from glottis to lips	*/
+	float		anc;			/* nasal coupling area in cm2	*/
+	short		nna;			/* # of nasal tract sections	*/
+	area_function	*afnt;			/* AF from nostrils to coupling	*/
+	short		nss;
+	short		nasal_tract, wall, rad_boundary, glt_boundary;
+	short		source_loc, source_typ;
+	short		vocal_tract, dynamic_term;
+	float		extra_loss_factor;
+	float		ro, c, eta, cp, lamda, mu;
+	float		wall_resi, wall_mass, wall_comp;
+	float		H2O_bar;
+} vt_config;
+
 
 /******************( Global variables defined in "main" )****************/
 
@@ -33,6 +58,9 @@ typedef struct{ float A, x; } area_function;
 
 extern float	simfrq;	/* simulation frequency in Hz	*/
 extern float	smpfrq;	/* sampling freq. in Hz		*/
+extern short	decim_taps;	/* length of the decimation FIR (odd),	*/
+				/* or 0 for 34*deci - 1 (=101)		*/
+extern float	decim_cutoff;	/* its cutoff relative to smpfrq/2	*/
 
 	/*( Used in the time and frequency domain calculations )*/
 
@@ -87,5 +115,14 @@ extern float	wall_mass;	/* wall mass per area, gm/cm2		*/
 extern float	wall_comp;	/* wall compliance			*/
 extern float	H2O_bar;
 
+/* copy the global variables above into a vt_config structure */
+void	copy_vt_config( vt_config *cf );
+
+/* set the output and simulation rates, of cf or of the globals, and the */
+/* decimation factor of cf */
+short	vt_rates_r( vt_config *cf, float smp, float sim );
+short	vt_rates( float smp, float sim );
+short	vt_deci( const vt_config *cf );
+
 #endif
 
@@ -0,0 +1,760 @@
+/***************************************************************************
+*                                                                          *
+*	File :	vtf_lib.c                                                  *
+*	Note :	Functions for a frequency-domain calculation of the vocal  *
+*		tract with a nasal side branch.                            *
+*                                                                          *
+***************************************************************************/
+
+#include	<stdlib.h>
+#include	<math.h>
+#include	<string.h>
+#include	<complex.h>
+#include	<unistd.h>
+#include	<pthread.h>
+#include	"vtconfig.h"
+#include	"vtf_lib.h"
+
+/*****
+*	Each tube section of area A and length l is a lossy transmission
+*	line, with per unit length
+*
+*	  Z = R + jwL,		  L = ro/A,  R = S/A^2*sqrt(w*ro*mu/2)
+*	  Y = G + jwC + Yw,	  C = A/(ro*c^2),
+*				  G = S*(eta-1)/(ro*c^2)*sqrt(w*lamda/(2*cp*ro))
+*	  Yw = S/(wall_resi + jw*wall_mass + wall_comp/jw)   (YIELDING)
+*
+*	S = 2*sqrt(pi*A) being the perimeter.  The heat conduction of the
+*	nasal tract is multiplied by extra_loss_factor.  Its chain matrix
+*	is [cosh(gl), Zc*sinh(gl); sinh(gl)/Zc, cosh(gl)], with
+*	g = sqrt(ZY) and Zc = Z/g.
+*
+*	The state of a pass (P, U and the radiated volume velocity O) is
+*	held in arrays over the frequencies, and a section is applied to
+*	all of them in a loop of its own, which the compiler vectorizes
+*	(e.g., cc -O3 -ffast-math, with the vector math of the libm).
+*
+*	The frequencies w may be complex, w = 2*pi*(f + jg) standing for
+*	exp(jwt), a sinusoid which decays as exp(-2*pi*g*t): the chain
+*	matrix is even in g, so that it does not matter which root g is,
+*	and the transfer function is continued off the real axis, where
+*	vtf_formants_r finds its poles.
+*****/
+
+/* the work arrays in vf->mem, nf_max doubles each, in (re, im) pairs */
+#define	V_W	0		/* angular frequency		*/
+#define	V_SW	2		/* sqrt(w)			*/
+#define	V_YW	4		/* wall admittance / S		*/
+#define	V_FP	6		/* front pass: P,		*/
+#define	V_FU	8		/*   U,				*/
+#define	V_FO	10		/*   O				*/
+#define	V_BP	12		/* back pass			*/
+#define	V_BU	14
+#define	V_BO	16
+#define	V_NP	18		/* nasal tract, at its inlet	*/
+#define	V_NU	20
+#define	V_CH	22		/* the section: cosh(gl),	*/
+#define	V_B	24		/*   Zc*sinh(gl),		*/
+#define	V_C	26		/*   sinh(gl)/Zc		*/
+#define	V_T	28		/* scratch			*/
+#define	V_D	30		/* H = N/D			*/
+#define	V_N	32
+#define	V_NUM	34
+
+#define	VA(vf,i)	((vf)->mem + (size_t)(i)*(vf)->nf_max)
+
+#define	F_MIN	1e-3		/* lowest frequency in Hz, for 0 */
+#define	VTF_ITER	8	/* root finding steps, at most,	*/
+#define	VTF_TOL		0.01	/* ... until they are below, in Hz */
+#define	VTF_STEP	40.0	/* scale of the steps of vtf_poles_r, Hz */
+#define	VTF_ROWS	16	/* area functions per take of a thread */
+
+/*****
+*	Function: line_coefs
+*	Note	: The loops of section_coefs, on arrays which do not
+*		  overlap (so that they vectorize): w, sw and yw are
+*		  those of V_W, V_SW and V_YW, q holds L, C, kr, kg, S
+*		  (0 for rigid walls) and l, and t two scratch arrays.
+*		  sin and cos are taken in loops of their own, lest the
+*		  compiler merge them into a sincos, which does not
+*		  vectorize.
+*****/
+
+static	void	line_coefs (
+	int	nf,
+	const	double	*restrict wr,  const double *restrict wi,
+	const	double	*restrict swr, const double *restrict swi,
+	const	double	*restrict ywr, const double *restrict ywi,
+	const	double	*restrict q,
+	double	*restrict chr, double *restrict chi,
+	double	*restrict br,  double *restrict bi,
+	double	*restrict cr,  double *restrict ci,
+	double	*restrict t0,  double *restrict t1 )
+{
+	double	L = q[0], C = q[1], kr = q[2], kg = q[3], S = q[4], l = q[5];
+	double	zr, zi, yr, yi, pr, pq, m, gr, gi, g2;
+	double	e, ch, sh, shr, shi, zcr, zci, ycr, yci;
+	int	k;
+
+	for(k=0; k<nf; k++)
+	{  zr = kr*swr[k] - L*wi[k];
+	   zi = kr*swi[k] + L*wr[k];
+	   yr = kg*swr[k] - C*wi[k] + S*ywr[k];
+	   yi = kg*swi[k] + C*wr[k] + S*ywi[k];
+
+	   pr = zr*yr - zi*yi;			/* g = sqrt(ZY), Re g >= 0 */
+	   pq = zr*yi + zi*yr;
+	   m  = sqrt(pr*pr + pq*pq);
+	   gr = sqrt(0.5*(m + pr));
+	   gi = copysign(sqrt(fmax(0.5*(m - pr), 0.0)), pq);
+	   g2 = gr*gr + gi*gi;
+	   br[k] = (zr*gr + zi*gi)/g2;		/* Zc = Z/g, 1/Zc = Y/g */
+	   bi[k] = (zi*gr - zr*gi)/g2;
+	   cr[k] = (yr*gr + yi*gi)/g2;
+	   ci[k] = (yi*gr - yr*gi)/g2;
+	   chr[k] = gr*l;
+	   chi[k] = gi*l;
+	}
+	for(k=0; k<nf; k++) t0[k] = cos(chi[k]);
+	for(k=0; k<nf; k++) t1[k] = sin(chi[k]);
+	for(k=0; k<nf; k++)
+	{  e  = exp(chr[k]);
+	   ch = 0.5*(e + 1.0/e);
+	   sh = 0.5*(e - 1.0/e);
+	   shr = sh*t0[k];			/* sinh(gl) */
+	   shi = ch*t1[k];
+	   chr[k] = ch*t0[k];			/* cosh(gl) */
+	   chi[k] = sh*t1[k];
+	   zcr = br[k];  zci = bi[k];
+	   ycr = cr[k];  yci = ci[k];
+	   br[k] = zcr*shr - zci*shi;
+	   bi[k] = zcr*shi + zci*shr;
+	   cr[k] = ycr*shr - yci*shi;
+	   ci[k] = ycr*shi + yci*shr;
+	}
+}
+
+/*****
+*	Function: section_coefs
+*	Note	: The chain matrix of a section of area A and length l
+*		  at all the frequencies, into V_CH, V_B and V_C.  heat
+*		  multiplies the heat conduction loss.
+*****/
+
+static	void	section_coefs ( vtf_context *vf, double A, double l,
+				double heat, int nf )
+{
+	vt_config	*cf = &vf->cf;
+	double	pi = 3.14159265358979, roc2 = cf->ro*cf->c*cf->c;
+	double	q[6], S;
+	int	n = vf->nf_max;
+
+	A = A > 1e-4 ? A : 1e-4;		/* as nonzero_t */
+	l = l > 1e-4 ? l : 1e-4;
+	S = 2.0*sqrt(pi*A);
+	q[0] = cf->ro/A;				/* L */
+	q[1] = A/roc2;					/* C */
+	q[2] = S/(A*A)*sqrt(cf->ro*cf->mu/2.0);		/* R/sqrt(w) */
+	q[3] = heat*S*(cf->eta - 1.0)/roc2
+	       *sqrt(cf->lamda/(2.0*cf->cp*cf->ro));	/* G/sqrt(w) */
+	q[4] = cf->wall == YIELDING ? S : 0;	/* rigid walls: Yw = 0 */
+	q[5] = l;
+	line_coefs( nf, VA(vf,V_W), VA(vf,V_W) + n, VA(vf,V_SW), VA(vf,V_SW) + n,
+		    VA(vf,V_YW), VA(vf,V_YW) + n, q,
+		    VA(vf,V_CH), VA(vf,V_CH) + n, VA(vf,V_B), VA(vf,V_B) + n,
+		    VA(vf,V_C), VA(vf,V_C) + n, VA(vf,V_T), VA(vf,V_T) + n );
+}
+
+/*****
+*	Function: chain
+*	Note	: Applies the section of section_coefs to the state (P,U)
+*		  in the arrays p and u: towards the glottis (dir = 1),
+*		  [P,U] = K[P,U], or towards the lips (dir = -1),
+*		  [P,U] = K^-1[P,U].
+*****/
+
+static	void	chain ( vtf_context *vf, int p, int u, double dir, int nf )
+{
+	double	*pr = VA(vf,p), *pi = pr + vf->nf_max;
+	double	*ur = VA(vf,u), *ui = ur + vf->nf_max;
+	double	*chr = VA(vf,V_CH), *chi = chr + vf->nf_max;
+	double	*br = VA(vf,V_B), *bi = br + vf->nf_max;
+	double	*cr = VA(vf,V_C), *ci = cr + vf->nf_max;
+	double	qr, qi, vr, vi;
+	int	k;
+
+	for(k=0; k<nf; k++)
+	{  qr = chr[k]*pr[k] - chi[k]*pi[k] + dir*(br[k]*ur[k] - bi[k]*ui[k]);
+	   qi = chr[k]*pi[k] + chi[k]*pr[k] + dir*(br[k]*ui[k] + bi[k]*ur[k]);
+	   vr = chr[k]*ur[k] - chi[k]*ui[k] + dir*(cr[k]*pr[k] - ci[k]*pi[k]);
+	   vi = chr[k]*ui[k] + chi[k]*ur[k] + dir*(cr[k]*pi[k] + ci[k]*pr[k]);
+	   pr[k] = qr;  pi[k] = qi;
+	   ur[k] = vr;  ui[k] = vi;
+	}
+}
+
+/*****
+*	Function: bessel01
+*	Note	: J0 and J1 of a complex x, by their series, which are
+*		  accurate enough for the |x| of the lips and nostrils.
+*****/
+
+static	void	bessel01 ( double complex x, double complex *j0x,
+			   double complex *j1x )
+{
+	double complex	q = -0.25*x*x, t0 = 1, t1 = 0.5*x;
+	int	k;
+
+	*j0x = t0;
+	*j1x = t1;
+	for(k=1; k<60 && cabs(t0) + cabs(t1) > 1e-17*(cabs(*j0x) + cabs(*j1x)); k++)
+	{  t0 *= q/((double)k*k);
+	   t1 *= q/((double)k*(k+1));
+	   *j0x += t0;
+	   *j1x += t1;
+	}
+}
+
+/*****
+*	Function: radiation
+*	Note	: The state at an opening of area A: U = 1 and P = the
+*		  radiation impedance (rad_boundary), and O = 1 if o >= 0.
+*****/
+
+static	void	radiation ( vtf_context *vf, double A, int p, int u, int o,
+			    int nf )
+{
+	vt_config	*cf = &vf->cf;
+	double	*wr = VA(vf,V_W), *wi = wr + vf->nf_max;
+	double	*pr = VA(vf,p), *pi = pr + vf->nf_max;
+	double	pie = 3.14159265358979, R, L, a, zc;
+	double complex	w, x, z, j0x, j1x, h1;
+	int	k;
+
+	A = A > 1e-4 ? A : 1e-4;
+	R = 128.0*cf->ro*cf->c/(9.0*pie*pie*A);
+	L = 8.0*cf->ro/(3.0*pie*sqrt(pie*A));
+	a = sqrt(A/pie);
+	zc = cf->ro*cf->c/A;
+	for(k=0; k<nf; k++)
+	{  w = wr[k] + I*wi[k];
+	   if( cf->rad_boundary == RL_CIRCUIT )	/* R and L in parallel */
+	      z = R*I*w*L/(R + I*w*L);
+	   else if( cf->rad_boundary == BESSEL_FUNCTION )
+	   {  x = 2.0*w/cf->c*a;		/* piston in a baffle */
+	      bessel01( x, &j0x, &j1x );
+	      h1 = 2.0/pie - j0x + (16.0/pie - 5.0)*csin(x)/x
+		 + (12.0 - 36.0/pie)*(1.0 - ccos(x))/(x*x);	/* Struve */
+	      z = zc*(1.0 - 2.0*j1x/x) + I*zc*2.0*h1/x;
+	   }
+	   else z = 0;				/* short circuit */
+	   pr[k] = creal(z);
+	   pi[k] = cimag(z);
+	}
+	for(k=0; k<nf; k++)
+	{  VA(vf,u)[k] = 1;
+	   VA(vf,u+1)[k] = 0;
+	}
+	for(k=0; k<nf && o >= 0; k++)
+	{  VA(vf,o)[k] = 1;
+	   VA(vf,o+1)[k] = 0;
+	}
+}
+
+/*****
+*	Function: nasal_branch
+*	Note	: Adds the nasal tract, the state of which at its inlet
+*		  is in V_NP and V_NU, at the branch point of the state
+*		  (P,U,O): the flow P*Un/Pn goes into the nose, and P/Pn
+*		  comes out of the nostrils.  The state is multiplied by
+*		  Pn, which leaves H as it is, but D without the poles of
+*		  1/Pn.  dir is as for chain.
+*****/
+
+static	void	nasal_branch ( vtf_context *vf, int p, int u, int o,
+			       double dir, int nf )
+{
+	double	*pr = VA(vf,p), *pi = pr + vf->nf_max;
+	double	*ur = VA(vf,u), *ui = ur + vf->nf_max;
+	double	*or = VA(vf,o), *oi = or + vf->nf_max;
+	double	*nr = VA(vf,V_NP), *ni = nr + vf->nf_max;
+	double	*mr = VA(vf,V_NU), *mi = mr + vf->nf_max;
+	double	qr, qi, vr, vi;
+	int	k;
+
+	for(k=0; k<nf; k++)
+	{  qr = pr[k]*nr[k] - pi[k]*ni[k];
+	   qi = pr[k]*ni[k] + pi[k]*nr[k];
+	   vr = ur[k]*nr[k] - ui[k]*ni[k] + dir*(pr[k]*mr[k] - pi[k]*mi[k]);
+	   vi = ur[k]*ni[k] + ui[k]*nr[k] + dir*(pr[k]*mi[k] + pi[k]*mr[k]);
+	   ur[k] = vr;  ui[k] = vi;
+	   vr = or[k]*nr[k] - oi[k]*ni[k] + pr[k];
+	   vi = or[k]*ni[k] + oi[k]*nr[k] + pi[k];
+	   or[k] = vr;  oi[k] = vi;
+	   pr[k] = qr;  pi[k] = qi;
+	}
+}
+
+/*****
+*	Function: tract
+*	Note	: The numerator and denominator of H (see vtf_transfer_r)
+*		  at the nf frequencies of V_W, into V_N and V_D; the
+*		  poles of H are the roots of D.  source_loc must be in
+*		  the tract.
+*****/
+
+static	void	tract ( vtf_context *vf, int nf )
+{
+	vt_config	*cf = &vf->cf;
+	area_function	*af = cf->afvt, *an = cf->afnt;
+	short	nph = cf->nph, nss = cf->nph + cf->nbu, loc = cf->source_loc;
+	short	nasal, i;
+	int	n = vf->nf_max, k;
+	double	*wr = VA(vf,V_W), *wi = wr + n;
+	double	*swr = VA(vf,V_SW), *swi = swr + n;
+	double	*ywr = VA(vf,V_YW), *ywi = ywr + n;
+	double	*fpr = VA(vf,V_FP), *fpi = fpr + n, *fur = VA(vf,V_FU), *fui = fur + n;
+	double	*bpr = VA(vf,V_BP), *bpi = bpr + n, *bur = VA(vf,V_BU), *bui = bur + n;
+	double	*for_ = VA(vf,V_FO), *foi = for_ + n, *bor = VA(vf,V_BO), *boi = bor + n;
+	double	*dr = VA(vf,V_D), *di = dr + n, *nr = VA(vf,V_N), *ni = nr + n;
+	double	Ag, Rg, Lg, m, sr, si, e2;
+
+	nasal = cf->nasal_tract == ON && cf->anc > 0 && cf->nna >= 2;
+
+	for(k=0; k<nf; k++)
+	{  m = sqrt(wr[k]*wr[k] + wi[k]*wi[k]);
+	   swr[k] = sqrt(0.5*(m + wr[k]));
+	   swi[k] = copysign(sqrt(fmax(0.5*(m - wr[k]), 0.0)), wi[k]);
+	   sr = cf->wall_comp - (wr[k]*wr[k] - wi[k]*wi[k])*cf->wall_mass
+		- wi[k]*cf->wall_resi;		/* Yw/S = jw/(wk-w^2*wm+jw*wr) */
+	   si = wr[k]*cf->wall_resi - 2.0*wr[k]*wi[k]*cf->wall_mass;
+	   e2 = sr*sr + si*si;
+	   ywr[k] = (wr[k]*si - wi[k]*sr)/e2;
+	   ywi[k] = (wr[k]*sr + wi[k]*si)/e2;
+	}
+
+/* the nasal tract, from the nostrils to the branch point */
+
+	if( nasal )
+	{  radiation( vf, an[0].A, V_NP, V_NU, -1, nf );
+	   for(i=0; i<cf->nna-1; i++)
+	   {  section_coefs( vf, an[i].A, an[i].x, cf->extra_loss_factor, nf );
+	      chain( vf, V_NP, V_NU, 1.0, nf );
+	   }
+	   section_coefs( vf, cf->anc, an[cf->nna-1].x, cf->extra_loss_factor, nf );
+	   chain( vf, V_NP, V_NU, 1.0, nf );
+	}
+
+/* the front pass, from the lips to the source */
+
+	radiation( vf, af[nss-1].A, V_FP, V_FU, V_FO, nf );
+	for(i=nss-1; i>=loc; i--)
+	{  section_coefs( vf, af[i].A, af[i].x, 1.0, nf );
+	   chain( vf, V_FP, V_FU, 1.0, nf );
+	   if( i == nph && nasal ) nasal_branch( vf, V_FP, V_FU, V_FO, 1.0, nf );
+	}
+
+/* the back pass, from the glottis to the source */
+
+	Ag = cf->glt_boundary == OPEN ? cf->Ag : 0;
+	Rg = Ag > 0 ? 12.0*cf->mu*cf->lg*cf->lg*cf->xg/(Ag*Ag*Ag) : 0;
+	Lg = Ag > 0 ? cf->ro*cf->xg/Ag : 0;
+	for(k=0; k<nf; k++)
+	{  if( Ag > 0 )				/* P = Zg, U = -1 */
+	   {  bpr[k] = Rg - wi[k]*Lg;  bpi[k] = wr[k]*Lg;
+	      bur[k] = -1;
+	   }
+	   else					/* closed: U = 0 */
+	   {  bpr[k] = 1;   bpi[k] = 0;
+	      bur[k] = 0;
+	   }
+	   bui[k] = bor[k] = boi[k] = 0;
+	}
+	for(i=0; i<loc; i++)
+	{  if( i == nph && nasal ) nasal_branch( vf, V_BP, V_BU, V_BO, -1.0, nf );
+	   section_coefs( vf, af[i].A, af[i].x, 1.0, nf );
+	   chain( vf, V_BP, V_BU, -1.0, nf );
+	}
+
+/* the source between the two: with D = Pb*Uf - Ub*Pf,
+   N = Pb*Of + Pf*Ob for a flow, -(Ub*Of + Uf*Ob) for a pressure */
+
+	for(k=0; k<nf; k++)
+	{  dr[k] = bpr[k]*fur[k] - bpi[k]*fui[k] - (bur[k]*fpr[k] - bui[k]*fpi[k]);
+	   di[k] = bpr[k]*fui[k] + bpi[k]*fur[k] - (bur[k]*fpi[k] + bui[k]*fpr[k]);
+	   if( cf->source_typ == PRESSURE )
+	   {  nr[k] = -(bur[k]*for_[k] - bui[k]*foi[k] + fur[k]*bor[k] - fui[k]*boi[k]);
+	      ni[k] = -(bur[k]*foi[k] + bui[k]*for_[k] + fur[k]*boi[k] + fui[k]*bor[k]);
+	   }
+	   else
+	   {  nr[k] = bpr[k]*for_[k] - bpi[k]*foi[k] + fpr[k]*bor[k] - fpi[k]*boi[k];
+	      ni[k] = bpr[k]*foi[k] + bpi[k]*for_[k] + fpr[k]*boi[k] + fpi[k]*bor[k];
+	   }
+	}
+}
+
+/*****
+*	Function : vtf_ini_r
+*	Note :	Work arrays of vf for nf_max frequencies.  Returns 0, or
+*		-1 if the memory could not be allocated.
+*****/
+
+short	vtf_ini_r ( vtf_context *vf, int nf_max )
+{
+	if( nf_max < 1 ) nf_max = 1;
+	vf->mem = (double *) malloc( (size_t)V_NUM*nf_max*sizeof(double) );
+	vf->nf_max = vf->mem != NULL ? nf_max : 0;
+	return( vf->mem != NULL ? 0 : -1 );
+}
+
+/*****
+*	Function : vtf_transfer_r
+*	Note :	The transfer function H at the nf frequencies freq (Hz)
+*		of the vocal tract vf->cf, as real and imaginary parts:
+*		the volume velocity radiated at the lips and, if the
+*		nasal tract is ON and anc > 0, at the nostrils, for a
+*		unit source.  The source is a flow (source_typ FLOW, H
+*		without dimension) or a pressure (PRESSURE, H in cm^3/s
+*		per dyne/cm^2) between the sections source_loc - 1 and
+*		source_loc of afvt (0 for the glottis).  The glottis is
+*		closed, or open (glt_boundary) with the impedance of a
+*		slit of area Ag.
+*
+*		The nasal tract is afnt[0] (nostrils) to afnt[nna-2],
+*		then a coupling section of area anc and length
+*		afnt[nna-1].x, branched between afvt[nph-1] and
+*		afvt[nph]; as for the time-domain simulation, anc is
+*		not taken from afvt[nph] here.
+*
+*		Returns 0, or -1 if nf > nf_max or source_loc is out of
+*		the tract.
+*****/
+
+short	vtf_transfer_r (
+	vtf_context	*vf,
+	const	float	*freq,
+	int	nf,
+	float	*Hre,
+	float	*Him )
+{
+	vt_config	*cf = &vf->cf;
+	double	pi = 3.14159265358979, *w, *dr, *di, *nr, *ni, d2;
+	int	k;
+
+	if( nf > vf->nf_max || cf->source_loc < 0
+	 || cf->source_loc >= cf->nph + cf->nbu ) return( -1 );
+
+	w = VA(vf,V_W);
+	for(k=0; k<nf; k++)
+	{  w[k] = 2.0*pi*fmax((double)freq[k], F_MIN);
+	   w[k + vf->nf_max] = 0;
+	}
+	tract( vf, nf );
+
+	dr = VA(vf,V_D);  di = dr + vf->nf_max;
+	nr = VA(vf,V_N);  ni = nr + vf->nf_max;
+	for(k=0; k<nf; k++)
+	{  d2 = dr[k]*dr[k] + di[k]*di[k];
+	   Hre[k] = (float)((nr[k]*dr[k] + ni[k]*di[k])/d2);
+	   Him[k] = (float)((ni[k]*dr[k] - nr[k]*di[k])/d2);
+	}
+	return( 0 );
+}
+
+/*****
+*	Function: root_step
+*	Note	: From D at z - h, z and z + h (dr, di, n apart), the
+*		  step from z to the root nearest to it of the parabola
+*		  through the three values (Muller's method).
+*****/
+
+static	double complex	root_step ( const double *dr, const double *di,
+				    int n, double h )
+{
+	double complex	g0, g1, g2, c1, c2, d, e;
+
+	g0 = dr[0] + I*di[0];
+	g1 = dr[n] + I*di[n];
+	g2 = dr[2*n] + I*di[2*n];
+	c1 = (g2 - g0)/(2.0*h);
+	c2 = (g2 - 2.0*g1 + g0)/(2.0*h*h);
+	d = csqrt( c1*c1 - 4.0*c2*g1 );
+	e = cabs(c1 + d) >= cabs(c1 - d) ? c1 + d : c1 - d;
+	return( cabs(e) > 0 ? -2.0*g1/e : 0 );
+}
+
+/*****
+*	Function: refine
+*	Note	: Steps of root_step from the n poles F + jB/2, at most
+*		  VTF_ITER, until they are below VTF_TOL; df scales the
+*		  stencil (df/10) and the largest step.  3*n must not
+*		  be above nf_max.
+*****/
+
+static	void	refine ( vtf_context *vf, int n, float *F, float *B, double df )
+{
+	int	ng = vf->nf_max, k, j, it;
+	double	pi = 3.14159265358979, *wr = VA(vf,V_W), *wi = wr + ng;
+	double	*dr = VA(vf,V_D), *di = dr + ng;
+	double	h = 0.1*df, step, lim;
+	double complex	dz;
+
+	for(it=0, step=df; it<VTF_ITER && n>0 && step>VTF_TOL; it++)
+	{  for(j=0; j<n; j++)			/* z - h, z, z + h */
+	      for(k=0; k<3; k++)
+	      {  wr[j + k*n] = 2.0*pi*(F[j] + (k - 1)*h);
+		 wi[j + k*n] = pi*B[j];
+	      }
+	   tract( vf, 3*n );
+	   for(j=0, step=0; j<n; j++)
+	   {  dz = root_step( dr + j, di + j, n, h );
+	      lim = fmax( df, 0.5*B[j] );	/* the largest step */
+	      F[j] += (float) fmax( -lim, fmin( creal(dz), lim ) );
+	      B[j] += (float)(2.0*fmax( -lim, fmin( cimag(dz), lim ) ));
+	      step = fmax( step, cabs(dz) );
+	   }
+	}
+}
+
+/*****
+*	Function : vtf_formants_r
+*	Note :	The first nfmt formants above flo (Hz) of the vocal tract
+*		vf->cf, and their bandwidths, into F and B (Hz): the
+*		poles F + jB/2 of H, as a function of the complex
+*		frequency.  The peaks of |H| are searched on nf_max
+*		frequencies from 0 to fhi, so that formants closer than
+*		about 2*fhi/nf_max may be taken as one; from each peak,
+*		the root of D is found by at most VTF_ITER steps of
+*		root_step, until they are below VTF_TOL.  A root which
+*		ends below flo, undamped or damped beyond B = 2F, or not
+*		above the one before, e.g. the wall resonance near 0 Hz,
+*		is not a formant: it is dropped and the search goes on
+*		from the next peak.  At most nf_max/3 formants are found per
+*		pass over the grid.
+*
+*		Returns the number of formants found, the others being
+*		0, or -1 if nf_max < 3, fhi <= 0 or source_loc is out of
+*		the tract.
+*****/
+
+short	vtf_formants_r (
+	vtf_context	*vf,
+	float	flo,
+	float	fhi,
+	int	nfmt,
+	float	*F,
+	float	*B )
+{
+	vt_config	*cf = &vf->cf;
+	int	ng = vf->nf_max, n = 0, m, k, k0 = 1, j, e;
+	double	pi = 3.14159265358979, *wr = VA(vf,V_W), *wi = wr + ng;
+	double	*dr = VA(vf,V_D), *di = dr + ng, *nr = VA(vf,V_N), *ni = nr + ng;
+	double	df, m0, m1, m2;
+
+	for(j=0; j<nfmt; j++) F[j] = B[j] = 0;
+	if( ng < 3 || fhi <= 0 || cf->source_loc < 0
+	 || cf->source_loc >= cf->nph + cf->nbu ) return( -1 );
+
+	df = fhi/(ng - 1.0);
+	while( n < nfmt && k0 < ng-1 )	/* a pass from the peak k0 on */
+	{  for(k=0; k<ng; k++)
+	   {  wr[k] = 2.0*pi*fmax(k*df, F_MIN);
+	      wi[k] = 0;
+	   }
+	   tract( vf, ng );
+
+	   m1 = (nr[k0-1]*nr[k0-1] + ni[k0-1]*ni[k0-1])
+		/(dr[k0-1]*dr[k0-1] + di[k0-1]*di[k0-1]);
+	   m2 = (nr[k0]*nr[k0] + ni[k0]*ni[k0])/(dr[k0]*dr[k0] + di[k0]*di[k0]);
+	   for(m=0, k=k0; k<ng-1 && n+m<nfmt && 3*(m+1) <= ng; k++)
+	   {  m0 = m1;
+	      m1 = m2;
+	      m2 = (nr[k+1]*nr[k+1] + ni[k+1]*ni[k+1])
+		   /(dr[k+1]*dr[k+1] + di[k+1]*di[k+1]);
+	      if( m1 > m0 && m1 >= m2 && k*df >= flo ) F[n + m++] = (float)(k*df);
+	   }
+	   k0 = k;
+	   if( m == 0 ) break;
+
+	   refine( vf, m, F+n, B+n, df );
+	   for(j=n, e=n+m; j<e; j++)		/* keep the formants */
+	      if( F[j] >= flo && B[j] > 0 && 2*F[j] > B[j]
+	       && (n == 0 || F[j] > F[n-1]) )
+	      {  F[n] = F[j];
+		 B[n++] = B[j];
+	      }
+	   for(j=n; j<nfmt; j++) F[j] = B[j] = 0;
+	}
+	return( (short) n );
+}
+
+/*****
+*	Function : vtf_poles_r
+*	Note :	The n poles of the vocal tract vf->cf nearest to F + jB/2
+*		(Hz), e.g. those of a nearby configuration, into F and B,
+*		as vtf_formants_r finds them from the peaks of |H|, but
+*		without the grid.  The estimates must be closer to their
+*		poles than to any other.  Returns 0, or -1 if 3*n > nf_max
+*		or source_loc is out of the tract.
+*****/
+
+short	vtf_poles_r ( vtf_context *vf, int n, float *F, float *B )
+{
+	vt_config	*cf = &vf->cf;
+
+	if( 3*n > vf->nf_max || cf->source_loc < 0
+	 || cf->source_loc >= cf->nph + cf->nbu ) return( -1 );
+	refine( vf, n, F, B, VTF_STEP );
+	return( 0 );
+}
+
+void	vtf_term_r ( vtf_context *vf )
+{
+	free( vf->mem );
+	vf->mem = NULL;
+	vf->nf_max = 0;
+}
+
+/*****
+*	Function : vtf_transfer
+*	Note :	Same as vtf_transfer_r, for the global configuration
+*		(afvt, anc, ...).  Returns 0, or -1 if the memory could
+*		not be allocated or source_loc is out of the tract.
+*****/
+
+short	vtf_transfer ( const float *freq, int nf, float *Hre, float *Him )
+{
+	static	vtf_context	vtf;		/* its arrays are kept */
+
+	if( nf > vtf.nf_max )
+	{  vtf_term_r( &vtf );
+	   if( vtf_ini_r( &vtf, nf ) ) return( -1 );
+	}
+	copy_vt_config( &vtf.cf );
+	return( vtf_transfer_r( &vtf, freq, nf, Hre, Him ) );
+}
+
+/*****
+*	Function : vtf_formants
+*	Note :	Same as vtf_formants_r, for the global configuration, on
+*		a grid of VTF_GRID frequencies.
+*****/
+
+short	vtf_formants ( float flo, float fhi, int nfmt, float *F, float *B )
+{
+	static	vtf_context	vtf;
+
+	if( vtf.mem == NULL && vtf_ini_r( &vtf, VTF_GRID ) ) return( -1 );
+	copy_vt_config( &vtf.cf );
+	return( vtf_formants_r( &vtf, flo, fhi, nfmt, F, B ) );
+}
+
+/*****************( the formants of many area functions )*****************/
+
+typedef struct {
+	const	vt_config	*cf;
+	const	area_function	*af;
+	const	float	*anc;
+	long	m, next;		/* area functions, next to take	*/
+	float	flo, fhi;
+	int	nfmt;
+	float	*F, *B;
+	short	failed;
+	pthread_mutex_t	lock;
+} formant_pool;
+
+/*****
+*	Function : formant_worker
+*	Note :	Takes VTF_ROWS area functions of the pool at a time, and
+*		finds their formants with a context of its own.
+*****/
+
+static	void	*formant_worker ( void *arg )
+{
+	formant_pool	*fp = (formant_pool *) arg;
+	vtf_context	vf;
+	short	nss = fp->cf->nph + fp->cf->nbu, ok;
+	long	i, i0, i1;
+
+	vf.cf = *fp->cf;
+	ok = vtf_ini_r( &vf, VTF_GRID ) == 0;
+	for( ; ; )
+	{  pthread_mutex_lock( &fp->lock );
+	   if( !ok ) fp->failed = 1;
+	   i0 = fp->failed ? fp->m : fp->next;
+	   i1 = fp->m - i0 < VTF_ROWS ? fp->m : i0 + VTF_ROWS;
+	   fp->next = i1;
+	   pthread_mutex_unlock( &fp->lock );
+	   if( i0 >= i1 ) break;
+
+	   for(i=i0; i<i1 && ok; i++)
+	   {  vf.cf.afvt = (area_function *) fp->af + i*nss;
+	      if( fp->anc != NULL ) vf.cf.anc = fp->anc[i];
+	      ok = vtf_formants_r( &vf, fp->flo, fp->fhi, fp->nfmt,
+				   fp->F + i*fp->nfmt, fp->B + i*fp->nfmt ) >= 0;
+	   }
+	}
+	vtf_term_r( &vf );
+	return( NULL );
+}
+
+/*****
+*	Function : vtf_formants_batch
+*	Note :	The formants and bandwidths of the m area functions af,
+*		each of cf->nph + cf->nbu sections from the glottis to the
+*		lips, as vtf_formants_r on a grid of VTF_GRID frequencies,
+*		into the m rows of nfmt floats F and B.  The nasal
+*		coupling area of each is anc[i], or cf->anc if anc is
+*		NULL; the other options (afnt, wall, ...) are those of cf.
+*		nthreads threads share the work (<= 0 for one per online
+*		processor).
+*
+*		Returns 0, or -1 if the memory or the threads could not be
+*		had or the arguments are not valid.
+*****/
+
+short	vtf_formants_batch (
+	const	vt_config	*cf,
+	const	area_function	*af,
+	const	float	*anc,
+	long	m,
+	float	flo,
+	float	fhi,
+	int	nfmt,
+	float	*F,
+	float	*B,
+	int	nthreads )
+{
+	formant_pool	fp;
+	pthread_t	*th;
+	int	i, started = 0;
+
+	if( m <= 0 ) return( 0 );
+	if( fhi <= 0 || nfmt < 1 || cf->nph + cf->nbu < 1 ) return( -1 );
+	fp.cf = cf;
+	fp.af = af;
+	fp.anc = anc;
+	fp.m = m;
+	fp.next = 0;
+	fp.flo = flo;
+	fp.fhi = fhi;
+	fp.nfmt = nfmt;
+	fp.F = F;
+	fp.B = B;
+	fp.failed = 0;
+
+	if( nthreads <= 0 ) nthreads = (int) sysconf( _SC_NPROCESSORS_ONLN );
+	if( nthreads <= 0 ) nthreads = 1;
+	if( nthreads > (m + VTF_ROWS - 1)/VTF_ROWS )
+	   nthreads = (int)((m + VTF_ROWS - 1)/VTF_ROWS);
+	if( (th = (pthread_t *) malloc( nthreads*sizeof(pthread_t) )) == NULL )
+	   return( -1 );
+
+	pthread_mutex_init( &fp.lock, NULL );
+	for(i=0; i<nthreads; i++)
+	   if( pthread_create( &th[i], NULL, formant_worker, &fp ) == 0 ) started++;
+	for(i=0; i<started; i++) pthread_join( th[i], NULL );
+	pthread_mutex_destroy( &fp.lock );
+	free( th );
+	return( started > 0 && !fp.failed ? 0 : -1 );
+}
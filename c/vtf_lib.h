@@ -0,0 +1,55 @@
+#ifndef VTF_LIB_H
+#define VTF_LIB_H
+
+/*****
+*	File :	vtf_lib.h
+*	Note :	Frequency-domain calculation of the vocal tract with a
+*		nasal side branch: the transfer function from the source
+*		to the volume velocity radiated at the lips and nostrils,
+*		on any grid of frequencies, by the chain (ABCD) matrices
+*		of lossy tube sections.
+*
+*		The same configuration as the time-domain simulator
+*		(vtconfig.h) is used: afvt (nph + nbu sections from the
+*		glottis to the lips), afnt and anc for the nasal tract,
+*		wall, rad_boundary, glt_boundary, source_loc, source_typ,
+*		extra_loss_factor and the physical constants.
+*
+*		vtf_formants_r finds the formants, i.e. the poles of the
+*		transfer function, and their bandwidths: the peaks of |H|
+*		on a grid of nf_max frequencies, from each of which the
+*		pole is found by root finding at complex frequencies.
+*****/
+
+#include "vtconfig.h"
+
+#define	VTF_GRID	128	/* grid of the formant search, by default */
+
+/*****************( state of a frequency-domain engine )*****************/
+
+typedef struct {
+	vt_config	cf;	/* configuration; the afvt[] contents, anc,	*/
+				/* Ag and the options are the inputs	*/
+	int	nf_max;		/* frequencies per call, at most	*/
+	double	*mem;		/* the work arrays, nf_max each		*/
+} vtf_context;
+
+/* cf of vf must be set first (e.g., by copy_vt_config) */
+short	vtf_ini_r( vtf_context *vf, int nf_max );
+short	vtf_transfer_r( vtf_context *vf, const float *freq, int nf,
+			float *Hre, float *Him );
+short	vtf_formants_r( vtf_context *vf, float flo, float fhi, int nfmt,
+			float *F, float *B );
+short	vtf_poles_r( vtf_context *vf, int n, float *F, float *B );
+void	vtf_term_r( vtf_context *vf );
+
+/* the same with the global configuration */
+short	vtf_transfer( const float *freq, int nf, float *Hre, float *Him );
+short	vtf_formants( float flo, float fhi, int nfmt, float *F, float *B );
+
+/* the formants of m area functions of cf->nph + cf->nbu sections each */
+short	vtf_formants_batch( const vt_config *cf, const area_function *af,
+			    const float *anc, long m, float flo, float fhi,
+			    int nfmt, float *F, float *B, int nthreads );
+
+#endif
@@ -0,0 +1,558 @@
+/***************************************************************************
+*                                                                          *
+*	File :	vtt_bank.c                                                 *
+*	Note :	Time-domain simulation of VB_LANES vocal tracts in         *
+*		lockstep.  The functions follow those of vtt_lib.c one     *
+*		by one, with vector arithmetic on the lanes.               *
+*                                                                          *
+***************************************************************************/
+
+#include	<stdlib.h>
+#include	<string.h>
+#include	<math.h>
+#include    "vtconfig.h"
+#include    "vtt_bank.h"
+
+/***********************( arithmetic on the lanes )***********************/
+
+#if defined(__AVX512F__)
+
+static	inline	vbf	vb_set( float a )	{ return _mm512_set1_ps(a); }
+static	inline	vbf	vb_load( const float *p ) { return _mm512_loadu_ps(p); }
+static	inline	void	vb_store( float *p, vbf a ) { _mm512_storeu_ps(p, a); }
+static	inline	vbf	vb_add( vbf a, vbf b )	{ return _mm512_add_ps(a, b); }
+static	inline	vbf	vb_sub( vbf a, vbf b )	{ return _mm512_sub_ps(a, b); }
+static	inline	vbf	vb_mul( vbf a, vbf b )	{ return _mm512_mul_ps(a, b); }
+static	inline	vbf	vb_div( vbf a, vbf b )	{ return _mm512_div_ps(a, b); }
+static	inline	vbf	vb_max( vbf a, vbf b )	{ return _mm512_max_ps(a, b); }
+static	inline	vbf	vb_sqrt( vbf a )	{ return _mm512_sqrt_ps(a); }
+static	inline	vbf	vb_abs( vbf a )		{ return _mm512_abs_ps(a); }
+
+#elif defined(__AVX__)
+
+static	inline	vbf	vb_set( float a )	{ return _mm256_set1_ps(a); }
+static	inline	vbf	vb_load( const float *p ) { return _mm256_loadu_ps(p); }
+static	inline	void	vb_store( float *p, vbf a ) { _mm256_storeu_ps(p, a); }
+static	inline	vbf	vb_add( vbf a, vbf b )	{ return _mm256_add_ps(a, b); }
+static	inline	vbf	vb_sub( vbf a, vbf b )	{ return _mm256_sub_ps(a, b); }
+static	inline	vbf	vb_mul( vbf a, vbf b )	{ return _mm256_mul_ps(a, b); }
+static	inline	vbf	vb_div( vbf a, vbf b )	{ return _mm256_div_ps(a, b); }
+static	inline	vbf	vb_max( vbf a, vbf b )	{ return _mm256_max_ps(a, b); }
+static	inline	vbf	vb_sqrt( vbf a )	{ return _mm256_sqrt_ps(a); }
+static	inline	vbf	vb_abs( vbf a )
+{	return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+}
+
+#else	/* scalar fallback */
+
+#define	VB_LOOP(e)	vbf r; short l; for(l=0; l<VB_LANES; l++) r.f[l] = (e); return r
+
+static	inline	vbf	vb_set( float a )	{ VB_LOOP( a ); }
+static	inline	vbf	vb_load( const float *p ) { VB_LOOP( p[l] ); }
+static	inline	void	vb_store( float *p, vbf a )
+{	short l; for(l=0; l<VB_LANES; l++) p[l] = a.f[l];
+}
+static	inline	vbf	vb_add( vbf a, vbf b )	{ VB_LOOP( a.f[l] + b.f[l] ); }
+static	inline	vbf	vb_sub( vbf a, vbf b )	{ VB_LOOP( a.f[l] - b.f[l] ); }
+static	inline	vbf	vb_mul( vbf a, vbf b )	{ VB_LOOP( a.f[l] * b.f[l] ); }
+static	inline	vbf	vb_div( vbf a, vbf b )	{ VB_LOOP( a.f[l] / b.f[l] ); }
+static	inline	vbf	vb_max( vbf a, vbf b )	{ VB_LOOP( a.f[l] > b.f[l] ? a.f[l] : b.f[l] ); }
+static	inline	vbf	vb_sqrt( vbf a )	{ VB_LOOP( sqrtf(a.f[l]) ); }
+static	inline	vbf	vb_abs( vbf a )		{ VB_LOOP( fabsf(a.f[l]) ); }
+
+#endif
+
+/* the same section of the input area function of every lane */
+static	inline	vbf	lane_A( vtt_bank *vb, short i )
+{	float	t[VB_LANES];
+	short	l;
+
+	for(l=0; l<VB_LANES; l++) t[l] = vb->afvt[l][i].A;
+	return( vb_load(t) );
+}
+static	inline	vbf	lane_x( vtt_bank *vb, short i )
+{	float	t[VB_LANES];
+	short	l;
+
+	for(l=0; l<VB_LANES; l++) t[l] = vb->afvt[l][i].x;
+	return( vb_load(t) );
+}
+
+/***************************( Local functions )***************************/
+
+/* limit x to a small nonzero positive value, as nonzero_t */
+static	inline	vbf	nonzero_v( vbf x )
+{
+	return( vb_max( x, vb_set(0.0001f) ) );
+}
+
+static	void	copy_initial_af_v ( vtt_bank *vb )
+{
+	short	nph = vb->cf.nph, nbu = vb->cf.nbu, nna = vb->cf.nna;
+	short	i, j;
+
+	for(i=0; i<nph; i++)
+	{  vb->afph[i].A = nonzero_v( lane_A(vb, i) );
+	   vb->afph[i].x = nonzero_v( lane_x(vb, i) );
+	}
+	for(i=0, j=nph+nbu-1; i<nbu; i++, j--)
+	{  vb->afbu[i].A = nonzero_v( lane_A(vb, j) );
+	   vb->afbu[i].x = nonzero_v( lane_x(vb, j) );
+	}
+	for(i=0; i<nna; i++)
+	{  vb->afna[i].A = vb_set( vb->cf.afnt[i].A );
+	   vb->afna[i].x = vb_set( vb->cf.afnt[i].x );
+	}
+	vb->afnc[0].A = nonzero_v( vb_load(vb->anc) );
+	vb->afnc[0].x = nonzero_v( vb->afna[nna-1].x );
+}
+
+static	void	dax_v ( vtt_bank *vb )
+{
+	short	nph = vb->cf.nph, nbu = vb->cf.nbu;
+	vbf	deci = vb_set( (float) vb->deci );
+	short	i, j;
+
+	for(i=0; i<nph; i++)
+	{  vb->dph[i].A = vb_div( vb_sub(lane_A(vb, i), vb->afph[i].A), deci );
+	   vb->dph[i].x = vb_div( vb_sub(lane_x(vb, i), vb->afph[i].x), deci );
+	}
+	for(i=0, j=nph+nbu-1; i<nbu; i++, j--)
+	{  vb->dbu[i].A = vb_div( vb_sub(lane_A(vb, j), vb->afbu[i].A), deci );
+	   vb->dbu[i].x = vb_div( vb_sub(lane_x(vb, j), vb->afbu[i].x), deci );
+	}
+	vb->dnc[0].A = vb_div( vb_sub(vb_load(vb->anc), vb->afnc[0].A), deci );
+	vb->dnc[0].x = vb_set( 0.0f );			/* constant length */
+}
+
+static	void	Ud_v ( vtt_bank *vb )
+{
+	short	nph = vb->cf.nph, nbu = vb->cf.nbu, nna = vb->cf.nna;
+	vbf	smpfrq = vb_set( vb->cf.smpfrq );
+	short	i, j;
+
+	for(i=0; i<nph; i++)
+	   vb->acph[i].Ud = vb_mul( smpfrq, vb_sub( vb_mul(lane_A(vb, i), lane_x(vb, i)),
+				    vb_mul(vb->afph[i].A, vb->afph[i].x) ) );
+	for(i=0, j=nph+nbu-1; i<nbu; i++, j--)
+	   vb->acbu[i].Ud = vb_mul( smpfrq, vb_sub( vb_mul(lane_A(vb, j), lane_x(vb, j)),
+				    vb_mul(vb->afbu[i].A, vb->afbu[i].x) ) );
+	vb->acna[nna].Ud = vb_mul( smpfrq,
+			   vb_sub( vb_mul(vb_load(vb->anc), vb->afna[nna-1].x),
+				   vb_mul(vb->afnc[0].A, vb->afnc[0].x) ) );
+}
+
+static	void	acou_mtrx_v (
+	vtt_bank		*vb,
+	short			ns,		/* # of sections */
+	vb_area_function	af[],
+	vb_area_function	daf[],		/* increment or decrimant */
+	vb_acoustic_elements	ac[],
+	vb_linear_equation	eq[],
+	vbf			r0,		/* arm of previous section */
+	vbf			L0   )
+{
+	vbf	Rv = vb_set(vb->Rv), La = vb_set(vb->La), Ca = vb_set(vb->Ca);
+	vbf	r1 = r0, L1 = L0, xda, ax, one = vb_set(1.0f);
+	short	i, j;
+
+/* compute the current area function by a linear interpolation */
+
+	for(i=0; i<ns; i++)
+	{  af[i].A = vb_add( af[i].A, daf[i].A );
+	   af[i].x = vb_add( af[i].x, daf[i].x );
+	}
+
+/* acoustic elements */
+
+	for(i=0, j=1; i<ns; i++, j++)
+	{  xda = vb_div( af[i].x, af[i].A );
+	   r1  = vb_div( vb_mul(Rv, xda), af[i].A );
+	   L1  = vb_mul( La, xda );
+	   ac[i].Rs = vb_add( r0, r1 ); r0 = r1;	/* series elements */
+	   ac[i].Ls = vb_add( L0, L1 ); L0 = L1;
+	   ac[j].Ca = vb_mul( vb_mul(Ca, af[i].A), af[i].x ); /* parallel elements */
+	}
+	ac[ns].Rs = r1;			/* left arm of the last section	*/
+	ac[ns].Ls = L1;
+
+	if( vb->cf.wall == YIELDING )			/* yielding walls */
+	{  vbf	Rw = vb_set(vb->Rw), Lw = vb_set(vb->Lw), Cw = vb_set(vb->Cw);
+
+	   for(i=0, j=1; i<ns; i++, j++)
+	   {  ax       = vb_mul( af[i].x, vb_sqrt(af[i].A) );
+	      ac[j].Rw = vb_div( Rw, ax );
+	      ac[j].Lw = vb_div( Lw, ax );
+	      ac[j].Cw = vb_div( Cw, ax );
+	      ac[j].Gw = vb_div( one, vb_add( vb_add(ac[j].Rw, ac[j].Lw), ac[j].Cw ) );
+	   }
+	}
+
+/* matrix coefficients */
+
+	eq[1].w   = vb_add( ac[0].Rs, ac[0].Ls );	/* right arm */
+
+	for(i=1, j=1; i<=ns; i++)
+	{  eq[++j].w = ac[i].Ca;
+	   eq[++j].w = vb_add( ac[i].Rs, ac[i].Ls );
+	}
+	if( vb->cf.wall == YIELDING )
+	   for(i=1; i<=ns; i++) eq[2*i].w = vb_add( eq[2*i].w, ac[i].Gw );
+}
+
+static	void	force_constants_v (
+	short			wall,		/* RIGID or YIELDING */
+	short			ns,		/* # of sections */
+	vb_acoustic_elements	ac[],
+	vb_linear_equation	eq[] )
+{
+	vbf	two = vb_set(2.0f), Uw;
+	short	i, j;
+
+/* Refresh current and voltage sources */
+
+	ac[0].els = vb_sub( vb_mul(vb_mul(two, ac[0].Ls), eq[1].x), ac[0].els );
+
+	for(i=1, j=1; i<=ns; i++)
+	{  ++j;
+	   ac[i].ica = vb_sub( vb_mul(vb_mul(two, ac[i].Ca), eq[j].x), ac[i].ica );
+	   ++j;
+	   ac[i].els = vb_sub( vb_mul(vb_mul(two, ac[i].Ls), eq[j].x), ac[i].els );
+	}
+	if( wall == YIELDING )				   /* wall imp.  */
+	{  for(i=1; i<=ns; i++)
+	   {  Uw = vb_mul( ac[i].Gw, vb_add( vb_sub(eq[2*i].x, ac[i].ecw), ac[i].elw ) );
+	      ac[i].elw = vb_sub( vb_mul(vb_mul(two, ac[i].Lw), Uw), ac[i].elw );
+	      ac[i].ecw = vb_add( ac[i].ecw, vb_mul(vb_mul(two, ac[i].Cw), Uw) );
+	   }
+	}
+
+/* Copy force terms */
+
+	for(i=1, j=1; i<=ns; i++)
+	{  eq[++j].s = vb_add( ac[i].ica, ac[i].Ud );
+	   eq[++j].s = vb_add( ac[i].els, ac[i].Ns );
+	}
+	if(wall == YIELDING)
+	for(i=1; i<=ns; i++)
+	   eq[2*i].s = vb_add( eq[2*i].s,
+			       vb_mul( ac[i].Gw, vb_sub(ac[i].ecw, ac[i].elw) ) );
+}
+
+static	void	elimination_v(
+	short	i0,		/* i0 = 0 for bucal and nasal tubes,	*/
+				/*    = 1 for pharynx tube		*/
+	short	ns3,		/* = 2*ns+1, ou ns = number of sections	*/
+	vb_linear_equation	eq[])
+{
+	short	i, i1;
+
+	i1 = i0 +1;
+	eq[i0].W = eq[i0].w;
+	eq[i0].S = eq[i0].s;
+
+	eq[i1].W = vb_add( vb_set(1.0f), vb_mul(eq[i0].W, eq[i1].w) );
+	eq[i1].S = vb_add( eq[i0].S, vb_mul(eq[i0].W, eq[i1].s) );
+
+	for(i=i0+2; i<=ns3; i++)
+	{  eq[i].W = vb_add( eq[i-2].W, vb_mul(eq[i-1].W, eq[i].w) );
+	   eq[i].S = vb_add( eq[i-1].S, vb_mul(eq[i-1].W, eq[i].s) );
+	}
+}
+
+static	void	substitution_v(
+	short	i0,		/* i0 = 0 for bucal and nasal tubes,	*/
+				/*    = 1 for pharynx tube		*/
+	short	ns3,		/* =2*ns+1, ou ns = number of sections	*/
+	vb_linear_equation	eq[] )
+{
+	short	i, i1;
+
+	i1 = i0 +1;
+	for(i=ns3; i>=i1; i--)
+	   eq[i].x = vb_div( vb_sub(eq[i].S, vb_mul(eq[i-1].W, eq[i+1].x)), eq[i].W );
+
+	eq[i0].x = vb_div( vb_sub(eq[i0].S, eq[i1].x), eq[i0].W );
+}
+
+/* the decimation filter of vtt_lib.c, on each lane */
+static	short	decim_init_v( vtt_bank *vb )
+{
+	short	p = vb->p_decim;
+
+	vb->count_decim = 0;
+	decim_coefs( &vb->cf, vb->deci, p, vb->h_decim );
+
+	/* return constant delay in output samples */
+	return( (short) ((float)((p-1)/2)/(float)vb->deci +0.5) );
+}
+
+static	vbf	decim_v(
+	vtt_bank *vb,
+	short	out_flag,	/* = 0 for storing x, = 1 for filtering */
+	vbf	x   )		/* input samples with the rate of simfrq Hz */
+{
+	short	p = vb->p_decim;
+	const vbf	*v;
+	vbf	sum = vb_set(0.0f);
+	short	i, n = vb->count_decim;
+
+	if( out_flag == 1 )
+	{  v = vb->v_decim + n;		/* the p inputs preceding x */
+	   for( i=0; i<p; i++)
+	      sum = vb_add( sum, vb_mul( vb_set(vb->h_decim[i]), v[i] ) );
+	}
+
+	vb->v_decim[n] = vb->v_decim[n+p] = x;
+	if( ++vb->count_decim == p ) vb->count_decim = 0;
+	return( sum );
+}
+
+/*****
+*	Function : vtt_bank_ini
+*	Note :	Initialize the VB_LANES tracts of vb, as vtt_ini_r.  It
+*		returns the constant delay due to the decimation filter,
+*		or -1 if memory could not be allocated.
+*****/
+
+short	vtt_bank_ini ( vtt_bank *vb )
+{
+	vt_config	*cf = &vb->cf;
+	short	nph = cf->nph, nbu = cf->nbu, nna = cf->nna;
+	float	pi = 3.141593f;
+	float	ro = cf->ro, c = cf->c;
+	vbf	zero = vb_set(0.0f), *p;
+	size_t	nv;
+	short	i, cnst_delay;
+
+	vb->nph2 = 2*nph; vb->nph3 = vb->nph2+1; vb->nph4 = vb->nph2+2;
+	vb->nbu2 = 2*nbu; vb->nbu3 = vb->nbu2+1; vb->nbu4 = vb->nbu2+2;
+	vb->nna2 = 2*nna; vb->nna3 = vb->nna2+1; vb->nna4 = vb->nna2+2;
+
+	vb->deci = vt_deci( cf );
+	vb->dt_sim = (float)(1./cf->simfrq);
+	vb->p_decim = decim_length( cf, vb->deci );
+
+	vb->Rk = (float)(1.2*ro);
+	vb->Rv = (float)((0.8*pi*cf->mu)/2.0);
+	vb->La = (float)((2.0/vb->dt_sim)*(ro/2.0));
+	vb->Ca = (float)((2.0/vb->dt_sim)/(ro*c*c));
+	vb->Rw = (float)(cf->wall_resi/(2.0*sqrt(pi)));
+	vb->Lw = (float)((2.0/vb->dt_sim)*cf->wall_mass/(2.0*sqrt(pi)));
+	vb->Cw = (float)((vb->dt_sim/2.0)*cf->wall_comp/(2.0*sqrt(pi)));
+	vb->Grad = (float)((9.0*pi*pi)/(128.0*ro*c));
+	vb->Srad = (float)((vb->dt_sim/2.0)*(3.0*pi*sqrt(pi))/(8.0*ro));
+	vb->Kr = (float)(ro*cf->simfrq/(2.0*pi*100.0));
+
+/*** memory allocations, in units of one vector, all cleared ***/
+
+	nv = 2*(size_t)(2*nph + 2*nbu + 2*nna + 2)
+	   + (size_t)13*(nph+1 + nbu+1 + nna+1)
+	   + (size_t)5*(2*nph+3 + 2*nbu+3 + 2*nna+3)
+	   + sizeof(vb_terminals)/sizeof(vbf)
+	   + 2*(size_t)vb->p_decim;
+	if( posix_memalign( &vb->mem, 64, nv*sizeof(vbf) ) != 0 ) return( -1 );
+	vb->h_decim = (float *) malloc( vb->p_decim*sizeof(float) );
+	if( vb->h_decim == NULL ) { free( vb->mem ); vb->mem = NULL; return( -1 ); }
+	p = (vbf *) vb->mem;
+	for(i=0; (size_t)i<nv; i++) p[i] = zero;
+
+	vb->afph = (vb_area_function *) p;	p += 2*nph;
+	vb->dph  = (vb_area_function *) p;	p += 2*nph;
+	vb->afbu = (vb_area_function *) p;	p += 2*nbu;
+	vb->dbu  = (vb_area_function *) p;	p += 2*nbu;
+	vb->afna = (vb_area_function *) p;	p += 2*nna;
+	vb->dna  = (vb_area_function *) p;	p += 2*nna;
+	vb->afnc = (vb_area_function *) p;	p += 2;
+	vb->dnc  = (vb_area_function *) p;	p += 2;
+	vb->acph = (vb_acoustic_elements *) p;	p += 13*(nph+1);
+	vb->acbu = (vb_acoustic_elements *) p;	p += 13*(nbu+1);
+	vb->acna = (vb_acoustic_elements *) p;	p += 13*(nna+1);
+	vb->eqph = (vb_linear_equation *) p;	p += 5*(2*nph+3);
+	vb->eqbu = (vb_linear_equation *) p;	p += 5*(2*nbu+3);
+	vb->eqna = (vb_linear_equation *) p;	p += 5*(2*nna+3);
+	vb->tm   = (vb_terminals *) p;		p += sizeof(vb_terminals)/sizeof(vbf);
+	vb->v_decim = p;
+
+	cnst_delay = decim_init_v( vb );
+
+/**** Acoustic and matrix elements (sources and flows are cleared) ****/
+
+	copy_initial_af_v( vb );
+	dax_v( vb );
+
+/* pharyngeal tract */
+	acou_mtrx_v( vb, nph, vb->afph, vb->dph, vb->acph, vb->eqph, zero, zero );
+	for(i=0; i<VB_LANES; i++)
+	   if( vb->Ag[i] < 0.0001f ) vb->Ag[i] = 0.0001f;
+	{  vbf	Ag = vb_load(vb->Ag);
+	   vb->eqph[1].w = vb_add( vb->eqph[1].w,
+		vb_div( vb_add( vb_div(vb_set(vb->Rv*cf->xg), Ag),
+				vb_mul(vb_set(vb->Rk), vb_abs(vb->eqph[1].x)) ),
+			vb_mul(Ag, Ag) ) );
+	}
+
+/* bucal cavity */
+	acou_mtrx_v( vb, nbu, vb->afbu, vb->dbu, vb->acbu, vb->eqbu, zero, zero );
+
+/* nasal tract */
+	acou_mtrx_v( vb, nna-1, vb->afna, vb->dna, vb->acna, vb->eqna, zero, zero );
+	for(i=1; i<=vb->nna3; i+=2)			/* add some extra loss */
+	   vb->eqna[i].w = vb_add( vb->eqna[i].w, vb_set(0.1f) );
+
+	vb->tm->Rs_na = vb->acna[nna-2].Rs;
+	vb->tm->Ls_na = vb->acna[nna-2].Ls;
+	acou_mtrx_v( vb, 1, vb->afnc, vb->dnc, vb->acna+nna-1, vb->eqna+2*(nna-1),
+		     vb->tm->Rs_na, vb->tm->Ls_na );
+
+/* Radiation loads */
+	if( cf->rad_boundary == RL_CIRCUIT )
+	{  vb->tm->Grad_lips = vb_mul( vb_set(vb->Grad), vb->afbu[0].A );
+	   vb->tm->Lrad_lips = vb_mul( vb_set(vb->Srad), vb_sqrt(vb->afbu[0].A) );
+	   vb->eqbu[0].w = vb_add( vb->tm->Grad_lips, vb->tm->Lrad_lips );
+
+	   vb->tm->Grad_nose = vb_mul( vb_set(vb->Grad), vb->afna[0].A );
+	   vb->tm->Lrad_nose = vb_mul( vb_set(vb->Srad), vb_sqrt(vb->afna[0].A) );
+	   vb->eqna[0].w = vb_add( vb->tm->Grad_nose, vb->tm->Lrad_nose );
+	}
+	else
+	{  vb->eqbu[0].w = vb_set(5.0f);		/* short circuit	 */
+	   vb->eqna[0].w = vb_set(5.0f);
+	}
+
+	return( cnst_delay );
+}
+
+/*****
+*	Function: vtt_bank_sim
+*	Note	: Simulate the tracts of vb as vtt_sim_r does, and put one
+*		  output sample (with the rate of smpfrq) of each lane in
+*		  out[].
+*****/
+
+void	vtt_bank_sim( vtt_bank *vb, float out[VB_LANES] )
+{
+	vt_config	*cf = &vb->cf;
+	short	nph2 = vb->nph2, nph3 = vb->nph3, nph4 = vb->nph4;
+	short	nbu2 = vb->nbu2, nbu3 = vb->nbu3, nbu4 = vb->nbu4;
+	short	nna2 = vb->nna2, nna3 = vb->nna3, nna4 = vb->nna4;
+	short	nna = cf->nna;
+	vb_acoustic_elements	*acph = vb->acph, *acbu = vb->acbu, *acna = vb->acna;
+	vb_linear_equation	*eqph = vb->eqph, *eqbu = vb->eqbu, *eqna = vb->eqna;
+	vb_terminals		*tm = vb->tm;
+	vbf	f, g, h, p, q, sound, sound_decim = vb_set(0.0f);
+	vbf	two = vb_set(2.0f), Kr = vb_set(vb->Kr);
+	vbf	Ag, Rg, Psub;
+	short	j;
+
+	if( cf->vocal_tract == TIME_VARYING)
+	{  dax_v( vb );
+	   if( cf->dynamic_term == ON ) Ud_v( vb );
+	}
+
+/* the glottis is constant during the deci cycles */
+	for(j=0; j<VB_LANES; j++)
+	   if( vb->Ag[j] < 0.0001f ) vb->Ag[j] = 0.0001f;
+	Ag   = vb_load( vb->Ag );
+	Rg   = vb_div( vb_set(vb->Rv*cf->xg), Ag );
+	Psub = vb_mul( vb_set(cf->H2O_bar), vb_load(vb->Psub) );
+
+	for(j=0; j<vb->deci; j++)
+	{
+
+/*** solve s = Wx ***/
+
+	   elimination_v(1, nph3, eqph);
+	   elimination_v(0, nbu3, eqbu);
+	   f = vb_div( eqph[nph3].S, eqph[nph3].W );
+	   g = vb_div( eqbu[nbu3].S, eqbu[nbu3].W );
+	   p = vb_add( f, g );
+	   f = vb_div( eqph[nph2].W, eqph[nph3].W );
+	   g = vb_div( eqbu[nbu2].W, eqbu[nbu3].W );
+	   q = vb_add( f, g );
+	   if( cf->nasal_tract == ON )
+	   {  elimination_v(0, nna3, eqna);
+	      h = vb_div( eqna[nna3].S, eqna[nna3].W );
+	      p = vb_add( p, h );
+	      h = vb_div( eqna[nna2].W, eqna[nna3].W );
+	      q = vb_add( q, h );
+	      eqna[nna4].x = vb_div( p, q );
+	   }
+	   eqph[nph4].x = eqbu[nbu4].x = vb_div( p, q );
+
+	   substitution_v(1, nph3, eqph);
+	   substitution_v(0, nbu3, eqbu);
+	   if( cf->nasal_tract == ON ) substitution_v(0, nna3, eqna);
+
+/*** Refresh acoustic and matrix elements ***/
+
+	   if( cf->vocal_tract == TIME_VARYING )
+	   {  vbf	zero = vb_set(0.0f);
+
+	      acou_mtrx_v( vb, cf->nph, vb->afph, vb->dph, acph, eqph, zero, zero );
+	      acou_mtrx_v( vb, cf->nbu, vb->afbu, vb->dbu, acbu, eqbu, zero, zero );
+	      if( cf->rad_boundary == RL_CIRCUIT )
+	      {  tm->Grad_lips = vb_mul( vb_set(vb->Grad), vb->afbu[0].A );
+		 tm->Lrad_lips = vb_mul( vb_set(vb->Srad), vb_sqrt(vb->afbu[0].A) );
+		 eqbu[0].w = vb_add( tm->Grad_lips, tm->Lrad_lips );
+	      }
+	      else
+		 eqbu[0].w = vb_set(10.0f);		/* short circuit */
+	      acou_mtrx_v( vb, 1, vb->afnc, vb->dnc, acna+nna-1, eqna+2*(nna-1),
+			   tm->Rs_na, tm->Ls_na );
+	   }
+/* add the glottal resistance */
+	   eqph[1].w = vb_add( vb_add(acph[0].Rs, acph[0].Ls),
+			       vb_div( vb_add(Rg, vb_mul(vb_set(vb->Rk), vb_abs(eqph[1].x))),
+				       vb_mul(Ag, Ag) ) );
+
+/*** Refresh force constants ***/
+
+	   force_constants_v(cf->wall, cf->nph, acph, eqph);
+	   eqph[1].s = vb_add( acph[0].els, Psub );	/* right arm */
+
+	   if( cf->rad_boundary == RL_CIRCUIT )
+	      tm->irad_lips = vb_add( vb_mul(vb_mul(two, tm->Lrad_lips), eqbu[0].x),
+				      tm->irad_lips );
+	   force_constants_v(cf->wall, cf->nbu, acbu, eqbu);
+	   eqbu[0].s = vb_sub( vb_set(0.0f), tm->irad_lips );
+	   eqbu[1].s = acbu[0].els;
+
+	   tm->U0_lips = tm->U1_lips;
+	   tm->U1_lips = vb_sub( vb_set(0.0f), eqbu[1].x );
+	   sound = vb_sub( tm->U1_lips, tm->U0_lips );
+
+	   if( cf->nasal_tract == ON )
+	   {  if( cf->rad_boundary == RL_CIRCUIT )
+		 tm->irad_nose = vb_add( vb_mul(vb_mul(two, tm->Lrad_nose), eqna[0].x),
+					 tm->irad_nose );
+	      force_constants_v(cf->wall, nna, acna, eqna);
+	      eqna[0].s = vb_sub( vb_set(0.0f), tm->irad_nose );
+	      eqna[1].s = acna[0].els;
+
+	      tm->U0_nose = tm->U1_nose;
+	      tm->U1_nose = vb_sub( vb_set(0.0f), eqna[1].x );
+	      sound = vb_add( sound, vb_sub(tm->U1_nose, tm->U0_nose) );
+	   }
+
+/*** decimation of the radiated sound ***/
+
+	   if( j == vb->deci - 1 ) sound_decim = decim_v( vb, 1, vb_mul(Kr, sound) );
+	   else                 		 decim_v( vb, 0, vb_mul(Kr, sound) );
+	}
+
+	vb_store( out, sound_decim );
+}
+
+/*****
+*	Function : vtt_bank_term
+*	Note :	free memories
+****/
+
+void	vtt_bank_term ( vtt_bank *vb )
+{
+	free( vb->mem );
+	vb->mem = NULL;
+	free( vb->h_decim );
+	vb->h_decim = NULL;
+}
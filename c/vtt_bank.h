@@ -0,0 +1,87 @@
+#ifndef VTT_BANK_H
+#define VTT_BANK_H
+
+/*****
+*	File :	vtt_bank.h
+*	Note :	A "voice bank": VB_LANES independent vocal tracts which
+*		share the configuration (number of sections, options,
+*		rates) and are simulated in lockstep, one tract per lane
+*		of a SIMD vector.  The recurrences of vtt_sim run along
+*		the tract and can not be vectorized within one voice, but
+*		they vectorize across voices.
+*
+*		The lane width follows the instruction set the file is
+*		compiled for: 16 with AVX-512, 8 with AVX2 (or AVX), and
+*		a scalar fallback of 8 lanes otherwise.
+*****/
+
+#include "vtconfig.h"
+#include "vtt_lib.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define	VB_LANES	16
+typedef	__m512	vbf;
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define	VB_LANES	8
+typedef	__m256	vbf;
+#else
+#define	VB_LANES	8
+typedef	struct { float f[VB_LANES]; } vbf;
+#endif
+
+/*********( the structures of vtt_lib.h, with a lane per voice )**********/
+
+typedef struct { vbf A, x; } vb_area_function;
+
+typedef struct { vbf	Rs, Ls, els, Ns, Ca, ica, Ud,
+			Rw, Lw, elw, Cw, ecw, Gw;
+		}  vb_acoustic_elements;
+
+typedef	struct { vbf	s, w, x, S, W;
+		}  vb_linear_equation;
+
+typedef struct { vbf	Grad_lips, Lrad_lips, irad_lips, U0_lips, U1_lips;
+		 vbf	Grad_nose, Lrad_nose, irad_nose, U0_nose, U1_nose;
+		 vbf	Rs_na, Ls_na;
+		}  vb_terminals;
+
+/***************************( a voice bank )******************************/
+
+typedef struct {
+	vt_config	cf;		/* shared configuration; its Ag, Psub,	*/
+					/* anc and afvt are ignored		*/
+
+/* inputs of each lane, which the caller may change between samples */
+	area_function	*afvt[VB_LANES];	/* nss = nph + nbu sections */
+	float		Ag[VB_LANES];
+	float		Psub[VB_LANES];
+	float		anc[VB_LANES];
+
+	short	deci;
+	float	dt_sim;
+	float	Rk, Rv, La, Ca, Grad, Srad, Rw, Lw, Cw, Kr;
+	short	nph2, nph3, nph4;
+	short	nbu2, nbu3, nbu4;
+	short	nna2, nna3, nna4;
+
+	void			*mem;	/* one aligned block for the below */
+	vb_area_function	*afph, *dph, *afbu, *dbu;
+	vb_area_function	*afna, *dna, *afnc, *dnc;
+	vb_acoustic_elements	*acph, *acbu, *acna;
+	vb_linear_equation	*eqph, *eqbu, *eqna;
+	vb_terminals		*tm;
+
+	short	count_decim;
+	short	p_decim;
+	float	*h_decim;
+	vbf	*v_decim;		/* 2*p_decim, as in vtt_lib.c */
+} vtt_bank;
+
+/* vb->cf (e.g., by copy_vt_config) and the lane inputs must be set before */
+short	vtt_bank_ini( vtt_bank *vb );
+void	vtt_bank_sim( vtt_bank *vb, float out[VB_LANES] );
+void	vtt_bank_term( vtt_bank *vb );
+
+#endif
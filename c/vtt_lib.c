@@ -8,61 +8,13 @@
 
 #include	<stdlib.h>
 #include	<math.h>
+#include	<string.h>
 #include    "vtconfig.h"
+#include    "vtt_lib.h"
 
-/*********************(stractue array definitions)***********************/
-
-typedef struct { float	Rs,	/* series (flow) resistance		*/
-			Ls,	/* series inductance (acoustic mass)	*/
-			els,	/* voltage source associated with Ls	*/
-			Ns,	/* dipole noise pressure sources	*/
-			Ca,	/* parallel capacitance (compliance)	*/
-			ica,	/* current source associated with Ca	*/
-			Ud,	/* parzllel flow source dur to dA/dt	*/
-			Rw,	/* wall mechanical resistance		*/
-			Lw,	/* wall mass (inductance)		*/
-			elw,	/* voltage source associated with Lw	*/
-			Cw,	/* wall compiance			*/
-			ecw,	/* voltage source associated with Cw	*/
-			Gw;	/* total wall conductance, 1/(Rw+Lw+Cw)	*/
-		}  td_acoustic_elements;
-
-typedef	struct { float	s,	/* forces (interlaced voltage-current	*/
-				/* sources)				*/
-			w,	/* matrix coefficients			*/
-			x,	/* variables (interlaced U and P's)	*/
-			S,	/* s after elimination procedure	*/
-			W;	/* w after elimination procedure	*/
-		}  td_linear_equation;
-
-/*******( global constants and variables for the following functions)*****/
-
-	static	short	deci;	/* decimation rate = simfrq/smpfrq */
-	static	float	dt_sim;
-	static	float	Rk, Rv, La, Ca, Grad, Srad, Rw, Lw, Cw, Kr;
-
-/* pharyngeal tube */
-	static	short			nph2, nph3, nph4;
-	static	area_function		*afph, *dph;
-	static	td_acoustic_elements	*acph;
-	static	td_linear_equation	*eqph;
-/* bucal tube	*/
-	static	short			nbu2, nbu3, nbu4;
-	static	area_function		*afbu, *dbu;
-	static	td_acoustic_elements	*acbu;
-	static	td_linear_equation	*eqbu;
-	static	float			Grad_lips, Lrad_lips, irad_lips;
-	static	float			U0_lips, U1_lips;
-/* nasal tract */
-	static	area_function		*dna;		     /* zeros */
-	static	short			nna2, nna3, nna4;
-	static	area_function		afnc[1], dnc[1];     /* NT inlet */
-	static	td_acoustic_elements	*acna;
-	static	float			Rs_na, Ls_na;
-	static	td_linear_equation	*eqna;
-	static	float			Grad_nose, Lrad_nose, irad_nose;
-	static	float			U0_nose, U1_nose;
+/*******( the simulator used by vtt_ini, vtt_sim and vtt_term )*********/
 
+	static	vtt_context	vtt;
 
 /***************************( Local functions )***************************/
 
@@ -78,6 +30,75 @@ float	nonzero_t( float x )
 	else             return( limit );
 }
 
+/*****
+*	Functions: ac_place, eq_place
+*	Note	: Lay out the storage for n acoustic elements or n linear
+*		  equations at p, which holds AC_FLOATS*n or EQ_FLOATS*n
+*		  floats.  In the VTT_SOA layout, the arrays of the fields
+*		  follow each other.
+*****/
+#define	AC_FLOATS	13	/* floats of an acoustic element  */
+#define	EQ_FLOATS	5	/* ... and of a linear equation	  */
+
+#ifdef VTT_SOA
+
+void	ac_place( short n, float *p, td_ac_array *ac )
+{
+	ac->Rs  = p;	ac->Ls  = p +   n;	ac->els = p + 2*n;
+	ac->Ns  = p + 3*n;	ac->Ca  = p + 4*n;	ac->ica = p + 5*n;
+	ac->Ud  = p + 6*n;	ac->Rw  = p + 7*n;	ac->Lw  = p + 8*n;
+	ac->elw = p + 9*n;	ac->Cw  = p +10*n;	ac->ecw = p +11*n;
+	ac->Gw  = p +12*n;
+}
+
+void	eq_place( short n, float *p, td_eq_array *eq )
+{
+	eq->s = p;	eq->w = p + n;	eq->x = p + 2*n;
+	eq->S = p + 3*n;	eq->W = p + 4*n;
+}
+
+#else
+
+void	ac_place( short n, float *p, td_ac_array *ac )
+{
+	(void) n;			/* the elements are contiguous */
+	*ac = (td_acoustic_elements *) p;
+}
+
+void	eq_place( short n, float *p, td_eq_array *eq )
+{
+	(void) n;
+	*eq = (td_linear_equation *) p;
+}
+
+#endif
+
+/*****
+*	Functions: ac_offset, eq_offset
+*	Note	: The elements from the k-th one on, as a tube by itself.
+*****/
+td_ac_array	ac_offset( td_ac_array ac, short k )
+{
+#ifdef VTT_SOA
+	ac.Rs  += k; ac.Ls  += k; ac.els += k; ac.Ns += k; ac.Ca += k;
+	ac.ica += k; ac.Ud  += k; ac.Rw  += k; ac.Lw += k; ac.elw += k;
+	ac.Cw  += k; ac.ecw += k; ac.Gw  += k;
+	return( ac );
+#else
+	return( ac + k );
+#endif
+}
+
+td_eq_array	eq_offset( td_eq_array eq, short k )
+{
+#ifdef VTT_SOA
+	eq.s += k; eq.w += k; eq.x += k; eq.S += k; eq.W += k;
+	return( eq );
+#else
+	return( eq + k );
+#endif
+}
+
 /*****
 *	Function: copy_initial_af_t
 *	Note :	Copy an initial input vocal tract area function, af,
@@ -87,20 +108,22 @@ float	nonzero_t( float x )
 *		end and afbu1[nbu-1] to the nasal branch point.
 ****/
 
-void	copy_initial_af_t ( )
+void	copy_initial_af_t ( vtt_context *vt )
 {
+	short	nph = vt->cf.nph, nbu = vt->cf.nbu, nna = vt->cf.nna;
+	area_function	*afvt = vt->cf.afvt;
 	short	i, j;
 
 	for(i=0; i<nph; i++)
-	{  afph[i].A = nonzero_t(afvt[i].A);
-	   afph[i].x = nonzero_t(afvt[i].x);
+	{  vt->afph[i].A = nonzero_t(afvt[i].A);
+	   vt->afph[i].x = nonzero_t(afvt[i].x);
 	}
 	for(i=0, j=nph+nbu-1; i<nbu; i++, j--)
-	{  afbu[i].A = nonzero_t(afvt[j].A);
-	   afbu[i].x = nonzero_t(afvt[j].x);
+	{  vt->afbu[i].A = nonzero_t(afvt[j].A);
+	   vt->afbu[i].x = nonzero_t(afvt[j].x);
 	}
-	afnc[0].A = nonzero_t( anc );
-	afnc[0].x = nonzero_t( afnt[nna-1].x );
+	vt->afnc[0].A = nonzero_t( vt->cf.anc );
+	vt->afnc[0].x = nonzero_t( vt->cf.afnt[nna-1].x );
 }
 
 /*****
@@ -112,20 +135,23 @@ void	copy_initial_af_t ( )
 *		simulation cycles by the linear interpolation.
 *****/
 
-void	dax ( )
+void	dax ( vtt_context *vt )
 {
+	short	nph = vt->cf.nph, nbu = vt->cf.nbu;
+	area_function	*afvt = vt->cf.afvt;
+	float	deci = (float) vt->deci;
 	short	i, j;
 
 	for(i=0; i<nph; i++)
-	{  dph[i].A = (afvt[i].A - afph[i].A)/(float) deci;
-	   dph[i].x = (afvt[i].x - afph[i].x)/(float) deci;
+	{  vt->dph[i].A = (afvt[i].A - vt->afph[i].A)/deci;
+	   vt->dph[i].x = (afvt[i].x - vt->afph[i].x)/deci;
 	}
 	for(i=0, j=nph+nbu-1; i<nbu; i++, j--)
-	{  dbu[i].A = (afvt[j].A - afbu[i].A)/(float) deci;
-	   dbu[i].x = (afvt[j].x - afbu[i].x)/(float) deci;
+	{  vt->dbu[i].A = (afvt[j].A - vt->afbu[i].A)/deci;
+	   vt->dbu[i].x = (afvt[j].x - vt->afbu[i].x)/deci;
 	}
-	dnc[0].A = (anc - afnc[0].A)/(float) deci;
-	dnc[0].x = 0.0;				/* constant length */
+	vt->dnc[0].A = (vt->cf.anc - vt->afnc[0].A)/deci;
+	vt->dnc[0].x = 0.0;				/* constant length */
 }
 
 /*****
@@ -136,18 +162,47 @@ void	dax ( )
 *		cycles, Ud is constant during the same cycles.
 *****/
 
-void	Ud ( )
+void	Ud ( vtt_context *vt )
 {
+	short	nph = vt->cf.nph, nbu = vt->cf.nbu, nna = vt->cf.nna;
+	area_function	*afvt = vt->cf.afvt;
+	float	smpfrq = vt->cf.smpfrq;
 	short	i, j;
 
 	for(i=0; i<nph; i++) {
-	   acph[i].Ud = smpfrq*(afvt[i].A*afvt[i].x - afph[i].A*afph[i].x);
+	   AC(vt->acph,i,Ud) = smpfrq*(afvt[i].A*afvt[i].x - vt->afph[i].A*vt->afph[i].x);
     }
 	for(i=0, j=nph+nbu-1; i<nbu; i++, j--) {
-	   acbu[i].Ud = smpfrq*(afvt[j].A*afvt[j].x - afbu[i].A*afbu[i].x);
+	   AC(vt->acbu,i,Ud) = smpfrq*(afvt[j].A*afvt[j].x - vt->afbu[i].A*vt->afbu[i].x);
     }
     
-	acna[nna].Ud = smpfrq*(anc*afnt[nna-1].x - afnc[0].A*afnc[0].x);
+	AC(vt->acna,nna,Ud) = smpfrq*(vt->cf.anc*vt->cf.afnt[nna-1].x
+			 - vt->afnc[0].A*vt->afnc[0].x);
+}
+
+/*****
+*	Function: new_input_af
+*	Note :	Returns 1 if the input area function (afvt[] and anc)
+*		differs from the one of the previous call, which is kept
+*		in afin[].  As long as it does not change, the section
+*		areas and lengths stay where the last interpolation left
+*		them, and so do the acoustic elements and the matrix
+*		coefficients: they need not be recomputed.
+*****/
+
+short	new_input_af ( vtt_context *vt )
+{
+	short	nvt = vt->cf.nph + vt->cf.nbu;
+	area_function	*afvt = vt->cf.afvt;
+	short	i;
+
+	for(i=0; i<nvt; i++)
+	   if( afvt[i].A != vt->afin[i].A || afvt[i].x != vt->afin[i].x ) break;
+	if( i == nvt && vt->cf.anc == vt->ancin ) return( 0 );
+
+	for( ; i<nvt; i++) vt->afin[i] = afvt[i];
+	vt->ancin = vt->cf.anc;
+	return( 1 );
 }
 
 /*****
@@ -157,15 +212,17 @@ void	Ud ( )
 *		having ns sections.
 *****/
 void	acou_mtrx (
+	vtt_context		*vt,
 	short			ns,		/* # of sections */
 	area_function		af[],
 	area_function		daf[],		/* increment or decrimant */
-	td_acoustic_elements	ac[],
-	td_linear_equation	eq[],
+	td_ac_array		ac,
+	td_eq_array		eq,
 	float			r0,		/* arm of previous section */
 	float			L0   )
 {
-	float	r1, L1, xda, ax;
+	float	Rv = vt->Rv, La = vt->La, Ca = vt->Ca;
+	float	r1 = 0, L1 = 0, xda, ax;
 	short	i, j;
 
 /* compute the current area function by a linear interpolation */
@@ -181,32 +238,32 @@ void	acou_mtrx (
 	{  xda = af[i].x / af[i].A;
 	   r1  = Rv*xda/af[i].A;
 	   L1  = La*xda;
-	   ac[i].Rs = r0 + r1; r0 = r1;		/* series elements */
-	   ac[i].Ls = L0 + L1; L0 = L1;
-	   ac[j].Ca = Ca*af[i].A*af[i].x;	/* parallel elements */
+	   AC(ac,i,Rs) = r0 + r1; r0 = r1;		/* series elements */
+	   AC(ac,i,Ls) = L0 + L1; L0 = L1;
+	   AC(ac,j,Ca) = Ca*af[i].A*af[i].x;	/* parallel elements */
 	}
-	ac[ns].Rs = r1;			/* left arm of the last section	*/
-	ac[ns].Ls = L1;
+	AC(ac,ns,Rs) = r1;			/* left arm of the last section	*/
+	AC(ac,ns,Ls) = L1;
 
-	if( wall == YIELDING )			/* yielding walls */
+	if( vt->cf.wall == YIELDING )			/* yielding walls */
 	   for(i=0, j=1; i<ns; i++, j++)
 	   {  ax       = (float)(af[i].x * sqrt(af[i].A));
-	      ac[j].Rw = Rw/ax;
-	      ac[j].Lw = Lw/ax;
-	      ac[j].Cw = Cw/ax;
-	      ac[j].Gw = (float)(1.0/(ac[j].Rw + ac[j].Lw + ac[j].Cw));
+	      AC(ac,j,Rw) = vt->Rw/ax;
+	      AC(ac,j,Lw) = vt->Lw/ax;
+	      AC(ac,j,Cw) = vt->Cw/ax;
+	      AC(ac,j,Gw) = (float)(1.0/(AC(ac,j,Rw) + AC(ac,j,Lw) + AC(ac,j,Cw)));
 	   }
 
 /* matrix coefficients */
 
-	eq[1].w   = ac[0].Rs + ac[0].Ls;	/* right arm */
+	EQ(eq,1,w)   = AC(ac,0,Rs) + AC(ac,0,Ls);	/* right arm */
 
 	for(i=1, j=1; i<=ns; i++)
-	{  eq[++j].w = ac[i].Ca;
-	   eq[++j].w = ac[i].Rs + ac[i].Ls;
+	{  EQ(eq,++j,w) = AC(ac,i,Ca);
+	   EQ(eq,++j,w) = AC(ac,i,Rs) + AC(ac,i,Ls);
 	}
-	if( wall == YIELDING )
-	   for(i=1; i<=ns; i++) eq[2*i].w += ac[i].Gw;
+	if( vt->cf.wall == YIELDING )
+	   for(i=1; i<=ns; i++) EQ(eq,2*i,w) += AC(ac,i,Gw);
 }
 
 /*****
@@ -215,17 +272,17 @@ void	acou_mtrx (
 *****/
 void	clear_sources (
 	short	ns,			/* # of sections */
-	td_acoustic_elements  ac[] )	/* acoustic elements */
+	td_ac_array  ac )	/* acoustic elements */
 {
 	short	i;
 
 	for(i=0; i<=ns; i++)
-	{  ac[i].els = 0;
-	   ac[i].Ns  = 0;
-	   ac[i].ica = 0;
-	   ac[i].elw = 0;
-	   ac[i].ecw = 0;
-	   ac[i].Ud  = 0;
+	{  AC(ac,i,els) = 0;
+	   AC(ac,i,Ns)  = 0;
+	   AC(ac,i,ica) = 0;
+	   AC(ac,i,elw) = 0;
+	   AC(ac,i,ecw) = 0;
+	   AC(ac,i,Ud)  = 0;
 	}
 }
 
@@ -235,11 +292,11 @@ void	clear_sources (
 *****/
 void	clear_pu (
 	short	ns4,			/* =2*ns+2, ou ns = # of sections */
-	td_linear_equation  eq[] )		/* matrix elements */
+	td_eq_array  eq )		/* matrix elements */
 {
 	short	i;
 
-	for(i=0; i<=ns4; i++) eq[i].x = 0;
+	for(i=0; i<=ns4; i++) EQ(eq,i,x) = 0;
 }
 
 /*****
@@ -249,38 +306,39 @@ void	clear_pu (
 *		  equation, s = wx.
 *****/
 void	force_constants (
+	short			wall,		/* RIGID or YIELDING */
 	short			ns,		/* # of sections */
-	td_acoustic_elements	ac[],
-	td_linear_equation		eq[] )
+	td_ac_array		ac,
+	td_eq_array		eq )
 {
 	short	i, j;
 	float	Uw;
 
 /* Refresh current and voltage sources */
 
-	ac[0].els = (float)(2.0*ac[0].Ls*eq[1].x - ac[0].els);	   /* right arm */
+	AC(ac,0,els) = (float)(2.0*AC(ac,0,Ls)*EQ(eq,1,x) - AC(ac,0,els));	   /* right arm */
 
 	for(i=1, j=1; i<=ns; i++)
-	{  ac[i].ica = (float)(2.0*ac[i].Ca*eq[++j].x - ac[i].ica); /* acoustic C */
-	   ac[i].els = (float)(2.0*ac[i].Ls*eq[++j].x - ac[i].els); /* acoustic L */
+	{  AC(ac,i,ica) = (float)(2.0*AC(ac,i,Ca)*EQ(eq,++j,x) - AC(ac,i,ica)); /* acoustic C */
+	   AC(ac,i,els) = (float)(2.0*AC(ac,i,Ls)*EQ(eq,++j,x) - AC(ac,i,els)); /* acoustic L */
 	}
 	if( wall == YIELDING )				   /* wall imp.  */
 	{  for(i=1; i<=ns; i++)
-	   {  Uw = ac[i].Gw * (eq[2*i].x - ac[i].ecw + ac[i].elw);
-	      ac[i].elw  = (float)(2.0*ac[i].Lw*Uw - ac[i].elw);
-	      ac[i].ecw += (float)(2.0*ac[i].Cw*Uw);
+	   {  Uw = AC(ac,i,Gw) * (EQ(eq,2*i,x) - AC(ac,i,ecw) + AC(ac,i,elw));
+	      AC(ac,i,elw)  = (float)(2.0*AC(ac,i,Lw)*Uw - AC(ac,i,elw));
+	      AC(ac,i,ecw) += (float)(2.0*AC(ac,i,Cw)*Uw);
 	   }
 	}
 
 /* Copy force terms */
 
 	for(i=1, j=1; i<=ns; i++)
-	{  eq[++j].s = ac[i].ica + ac[i].Ud;
-	   eq[++j].s = ac[i].els + ac[i].Ns;
+	{  EQ(eq,++j,s) = AC(ac,i,ica) + AC(ac,i,Ud);
+	   EQ(eq,++j,s) = AC(ac,i,els) + AC(ac,i,Ns);
 	}
 	if(wall == YIELDING)
 	for(i=1; i<=ns; i++)
-	   eq[2*i].s += ac[i].Gw*(ac[i].ecw - ac[i].elw);
+	   EQ(eq,2*i,s) += AC(ac,i,Gw)*(AC(ac,i,ecw) - AC(ac,i,elw));
 }
 
 /******
@@ -292,21 +350,21 @@ void	elimination_t(
 	short	i0,		/* i0 = 0 for bucal and nasal tubes,	*/
 				/*    = 1 for pharynx tube		*/
 	short	ns3,		/* = 2*ns+1, ou ns = number of sections	*/
-	td_linear_equation	eq[])
+	td_eq_array	eq)
 
 {
 	short	i, i1; 
 
 	i1 = i0 +1;
-	eq[i0].W = eq[i0].w;
-	eq[i0].S = eq[i0].s;
+	EQ(eq,i0,W) = EQ(eq,i0,w);
+	EQ(eq,i0,S) = EQ(eq,i0,s);
 
-	eq[i1].W =      (float)(1.0 + eq[i0].W*eq[i1].w);
-	eq[i1].S = eq[i0].S + eq[i0].W*eq[i1].s;
+	EQ(eq,i1,W) =      (float)(1.0 + EQ(eq,i0,W)*EQ(eq,i1,w));
+	EQ(eq,i1,S) = EQ(eq,i0,S) + EQ(eq,i0,W)*EQ(eq,i1,s);
 
 	for(i=i0+2; i<=ns3; i++)
-	{  eq[i].W = eq[i-2].W + eq[i-1].W*eq[i].w;
-	   eq[i].S = eq[i-1].S + eq[i-1].W*eq[i].s;
+	{  EQ(eq,i,W) = EQ(eq,i-2,W) + EQ(eq,i-1,W)*EQ(eq,i,w);
+	   EQ(eq,i,S) = EQ(eq,i-1,S) + EQ(eq,i-1,W)*EQ(eq,i,s);
 	}
 }
 
@@ -319,246 +377,400 @@ void	substitution_t(
 	short	i0,		/* i0 = 0 for bucal and nasal tubes,	*/
 				/*    = 1 for pharynx tube		*/
 	short	ns3,		/* =2*ns+1, ou ns = number of sections	*/
-	td_linear_equation	eq[] )
+	td_eq_array	eq )
 
 {
 	short	i, i1;
 
 	i1 = i0 +1;
 	for(i=ns3; i>=i1; i--)
-	   eq[i].x = (eq[i].S - eq[i-1].W*eq[i+1].x)/eq[i].W;
+	   EQ(eq,i,x) = (EQ(eq,i,S) - EQ(eq,i-1,W)*EQ(eq,i+1,x))/EQ(eq,i,W);
 
-	eq[i0].x = (eq[i0].S - eq[i1].x)/eq[i0].W;
+	EQ(eq,i0,x) = (EQ(eq,i0,S) - EQ(eq,i1,x))/EQ(eq,i0,W);
 }
 
 /*****
 *	Functions : decimation
-*	Note	: The following two functions, decim_init and decim, are
-*		  to reduce sampling rate by a factor "deci"
-*		  (= simfrq/smpfrq), using an FIR for the interpolation.
-*		  The filter length is fixed to a odd samples ( e.g.,101)
-*		  and its coefficients are calculated with "decim_init".
-*		  The output sample is returned by value.
+*	Note	: The following functions are to reduce sampling rate by
+*		  a factor "deci" (= simfrq/smpfrq), using a linear phase
+*		  FIR for the interpolation.  The filter has an odd
+*		  length, p = cf->decim_taps (by default 34*deci - 1,
+*		  i.e., 101 taps for deci = 3), and its cutoff is
+*		  cf->decim_cutoff times the output Nyquist frequency.
+*
+*		  The input samples are kept in a ring buffer which is
+*		  written twice, at n and n+p, so that the p most recent
+*		  samples always form one contiguous window, and only
+*		  every deci-th output of the FIR is computed (a
+*		  polyphase decimator).  The dot product then needs no
+*		  wrap-around test and runs in blocks of DECIM_BLOCK
+*		  taps, which the compiler vectorizes.
 *****/
 
-	short	count_decim;
-	short	q_decim = 51, p_decim = 101;	/* q = (p-1)/2 + 1 */
-	float	h_decim[51],  v_decim[101];
+short	decim_length( const vt_config *cf, short deci )
+{
+	short	p = cf->decim_taps;
+
+	if( p <= 0 ) p = (short)(34*deci - 1);
+	if( p%2 == 0 ) p++;				/* odd length */
+	return( p );
+}
 
-short	decim_init( void )
+void	decim_coefs(
+	const vt_config *cf,
+	short	deci,
+	short	p,		/* filter length (odd) */
+	float	*h )		/* p coefficients */
 {
 	float	cutoff, hd;
-	short	i, q1;
+	short	i, q1 = (p-1)/2;
 	float	temp, pi = 3.141593f;
 
-	count_decim = 0;
-	q1 = q_decim - 1;
-	temp = (float)(2.0*pi/(p_decim-1));
-	for( i=0; i<p_decim; i++) v_decim[i] = 0;
-
-	cutoff = (float)(0.9*pi/deci);			/* cutoff frequency */
+	temp = (float)(2.0*pi/(p-1));
+	cutoff = (float)(cf->decim_cutoff*pi/deci);	/* cutoff frequency */
 	for( i=0; i<q1; i++)
 	{  
 		hd   = (float)(sin(cutoff*(i-q1))/(pi*(i-q1)));
-		h_decim[i] = (float)(hd*( 0.54 - 0.46*cos(temp*i)));
+		h[i] = h[p-1-i] = (float)(hd*( 0.54 - 0.46*cos(temp*i)));
 	}
 
-	h_decim[q1] = (float)(0.5*cutoff/pi);
+	h[q1] = (float)(cutoff/pi);
+}
+
+/*****
+*	Functions: decim_size, decim_setup
+*	Note	: The lengths of the filter of vt, and its coefficients and
+*		  cleared memory, once h_decim and v_decim hold l_decim and
+*		  p_decim + l_decim floats.
+*****/
+static	void	decim_size( vtt_context *vt )
+{
+	vt->p_decim = decim_length( &vt->cf, vt->deci );
+	vt->l_decim = (short)((vt->p_decim + DECIM_BLOCK-1)/DECIM_BLOCK*DECIM_BLOCK);
+}
+
+static	short	decim_setup( vtt_context *vt )
+{
+	short	p = vt->p_decim, i;
+
+	vt->count_decim = 0;
+	for( i=0; i<vt->l_decim; i++) vt->h_decim[i] = 0;
+	for( i=0; i<p+vt->l_decim; i++) vt->v_decim[i] = 0;
+	decim_coefs( &vt->cf, vt->deci, p, vt->h_decim );
 
 	/* return constant delay in output samples */
-	return( (short) ((float)q_decim/(float)deci +0.5) );
+	return( (short) ((float)((p-1)/2)/(float)vt->deci +0.5) );
+}
+
+/*****
+*	Function : decim_init
+*	Note :	The filter of vt by itself, in arrays of its own which the
+*		caller frees (vtt_ini_r lays them out in vt->mem instead).
+*****/
+short	decim_init( vtt_context *vt )
+{
+	decim_size( vt );
+	vt->h_decim = (float *) calloc( vt->l_decim, sizeof(float) );
+	vt->v_decim = (float *) calloc( vt->p_decim + vt->l_decim, sizeof(float) );
+	return( decim_setup( vt ) );
 }
 
 float	decim(
+	vtt_context *vt,
 	short   out_flag,	/* = 0 for storing x, = 1 for filtering */
 	float x   )	/* input sample with the rate of simfrq Hz */
 {
-	float	sum =0;
-	short	i, j, k;
+	short	p = vt->p_decim, l = vt->l_decim;
+	const float	*h = vt->h_decim, *v;
+	float	acc[DECIM_BLOCK], sum = 0;
+	short	i, k, n = vt->count_decim;
 
-/* Store input sample in the filter memory */
-
-	if( count_decim == p_decim ) count_decim = 0;
-	v_decim[count_decim] = x;
-
-/* Filtering and output y */
+/* Filtering and output y, from the p inputs preceding x */
 
 	if( out_flag == 1 )
-	{  j = count_decim;
-	   k = count_decim - 1;
-	   sum = 0;
-	   for( i=0; i<q_decim; i++)
-	   {  --j; if(j == -1)      j = p_decim - 1;
-	      ++k; if(k == p_decim) k = 0;
-	      sum = sum + h_decim[i]*(v_decim[j] + v_decim[k]);
-	   }
+	{  v = vt->v_decim + n;
+	   for( k=0; k<DECIM_BLOCK; k++) acc[k] = 0;
+	   for( i=0; i<l; i+=DECIM_BLOCK)
+	      for( k=0; k<DECIM_BLOCK; k++) acc[k] += h[i+k]*v[i+k];
+	   for( k=0; k<DECIM_BLOCK; k++) sum += acc[k];
 	}
-	count_decim++;
+
+/* Store input sample in the filter memory */
+
+	vt->v_decim[n] = vt->v_decim[n+p] = x;
+	if( ++vt->count_decim == p ) vt->count_decim = 0;
 	return( sum );
 }
 
-/******************( Functions called from a main )***********************/
+/*******************( Functions for a simulator instance )****************/
 
 /*****
-*	Function : vtt_ini
-*	Note :	Initialize the vocal-tract state. It returns the constant
-*		delay due to the decimation filter.
+*	Function : take
+*	Note :	The next k floats of the block p, of which *n are taken.
 *****/
 
-short	vtt_ini ( )
+static	float	*take( float *p, size_t *n, size_t k )
 {
+	float	*q = p != NULL ? p + *n : NULL;
+
+	*n += k;
+	return( q );
+}
+
+/*****
+*	Function : vtt_layout
+*	Note :	Lays out the arrays of vt (sized from nph, nbu, nna and the
+*		decimation filter) at p, and returns the number of floats
+*		they take.  With p = NULL, only the number is returned.
+*****/
+
+static	size_t	vtt_layout ( vtt_context *vt, float *p )
+{
+	vt_config	*cf = &vt->cf;
+	short	nph = cf->nph, nbu = cf->nbu, nna = cf->nna;
+	size_t	n = 0;
+
+	vt->afph = (area_function *) take( p, &n, 2*nph );
+	vt->dph  = (area_function *) take( p, &n, 2*nph );
+	ac_place( nph+1, take( p, &n, AC_FLOATS*(nph+1) ), &vt->acph );
+	eq_place( 2*nph+3, take( p, &n, EQ_FLOATS*(2*nph+3) ), &vt->eqph );
+
+	vt->afbu = (area_function *) take( p, &n, 2*nbu );
+	vt->dbu  = (area_function *) take( p, &n, 2*nbu );
+	ac_place( nbu+1, take( p, &n, AC_FLOATS*(nbu+1) ), &vt->acbu );
+	eq_place( 2*nbu+3, take( p, &n, EQ_FLOATS*(2*nbu+3) ), &vt->eqbu );
+
+	vt->dna  = (area_function *) take( p, &n, 2*nna );
+	ac_place( nna+1, take( p, &n, AC_FLOATS*(nna+1) ), &vt->acna );
+	eq_place( 2*nna+3, take( p, &n, EQ_FLOATS*(2*nna+3) ), &vt->eqna );
+
+	vt->afin = (area_function *) take( p, &n, 2*(nph+nbu) );
+
+	vt->h_decim = take( p, &n, vt->l_decim );
+	vt->v_decim = take( p, &n, vt->p_decim + vt->l_decim );
+	return( n );
+}
+
+/*****
+*	Function : vtt_ini_r
+*	Note :	Initialize the vocal-tract state of the simulator vt, whose
+*		configuration vt->cf must have been filled in (e.g., by
+*		copy_vt_config).  It returns the constant delay due to the
+*		decimation filter, or -1 if the memory could not be
+*		allocated.
+*****/
+
+short	vtt_ini_r ( vtt_context *vt )
+{
+	vt->mem = NULL;
+	vt->mem_size = 0;
+	return( vtt_reset_r( vt ) );
+}
+
+/*****
+*	Function : vtt_alloc_r
+*	Note :	Makes vt->mem large enough for the arrays of the
+*		configuration vt->cf, e.g., so that the first vtt_reset_r
+*		allocates nothing either.  Returns the size of the arrays
+*		in bytes, or 0 if the memory could not be allocated.
+*****/
+
+size_t	vtt_alloc_r ( vtt_context *vt )
+{
+	vt_config	*cf = &vt->cf;
+	size_t	size;
+
+	vt->deci = vt_deci( cf );
+	decim_size( vt );
+	size = vtt_layout( vt, NULL )*sizeof(float);
+	if( size > vt->mem_size )
+	{  free( vt->mem );
+	   vt->mem_size = 0;
+	   if( (vt->mem = malloc( size )) == NULL ) return( 0 );
+	   vt->mem_size = size;
+	}
+	return( size );
+}
+
+/*****
+*	Function : vtt_reset_r
+*	Note :	Same as vtt_ini_r for a simulator which has been
+*		initialized before, and possibly terminated since.  All
+*		the arrays of vt are in one block, vt->mem, which is kept
+*		from one initialization to the next while it is large
+*		enough (the configuration may change in between), so that
+*		a reset does not allocate any memory.
+*****/
+
+short	vtt_reset_r ( vtt_context *vt )
+{
+	vt_config	*cf = &vt->cf;
+	short	nph = cf->nph, nbu = cf->nbu, nna = cf->nna;
 	short	i, cnst_delay;
 	float	pi = 3.141593f;
+	float	ro = cf->ro, c = cf->c;
+	size_t	size;
 
-	nph2 = 2*nph; nph3 = nph2+1; nph4 = nph2+2;
-	nbu2 = 2*nbu; nbu3 = nbu2+1; nbu4 = nbu2+2;
-	nna2 = 2*nna; nna3 = nna2+1; nna4 = nna2+2;
+	vt->nph2 = 2*nph; vt->nph3 = vt->nph2+1; vt->nph4 = vt->nph2+2;
+	vt->nbu2 = 2*nbu; vt->nbu3 = vt->nbu2+1; vt->nbu4 = vt->nbu2+2;
+	vt->nna2 = 2*nna; vt->nna3 = vt->nna2+1; vt->nna4 = vt->nna2+2;
 
-	deci = (short)(simfrq/smpfrq);
-	dt_sim = (float)(1./simfrq);
-	cnst_delay = decim_init();
+	vt->dt_sim = (float)(1./cf->simfrq);
+
+/*** memory: the block of the previous initialization, if large enough ***/
+
+	if( (size = vtt_alloc_r( vt )) == 0 ) return( -1 );
+	memset( vt->mem, 0, size );
+	vtt_layout( vt, (float *)vt->mem );
+	cnst_delay = decim_setup( vt );
 
 /*** Coefficients for computing acoustic-aerodynamic elements ***/
 
 /* flow registance */
-	Rk = (float)(1.2*ro);		/* kinetic resistance */
+	vt->Rk = (float)(1.2*ro);		/* kinetic resistance */
 
 	/* The Rk value depends on the cross-section shape: =1.38 for
 	   the glottis (rectangular) and =1. for a supragrottal
 	   constriction.  For the simplicity sake, the single value is
 	   used for the two cases. */
 
-	Rv = (float)((0.8*pi*mu)/2.0);	/* viscus resistance  */
+	vt->Rv = (float)((0.8*pi*cf->mu)/2.0);	/* viscus resistance  */
 	/* The vr value depends on the shapes.  The difference is
 	   relativly small, and the single value will be used. */
 
 /* acoustic elements */
-	La = (float)((2.0/dt_sim)*(ro/2.0));	/* acoustic mass (La)		*/
-	Ca = (float)((2.0/dt_sim)/(ro*c*c));	/* acoustic stiffness (1/Ca)	*/
+	vt->La = (float)((2.0/vt->dt_sim)*(ro/2.0));	/* acoustic mass (La)		*/
+	vt->Ca = (float)((2.0/vt->dt_sim)/(ro*c*c));	/* acoustic stiffness (1/Ca)	*/
 
 /* walls */
-	Rw = (float)(wall_resi/(2.0*sqrt(pi)));
-	Lw = (float)((2.0/dt_sim)*wall_mass/(2.0*sqrt(pi)));
-	Cw = (float)((dt_sim/2.0)*wall_comp/(2.0*sqrt(pi)));
+	vt->Rw = (float)(cf->wall_resi/(2.0*sqrt(pi)));
+	vt->Lw = (float)((2.0/vt->dt_sim)*cf->wall_mass/(2.0*sqrt(pi)));
+	vt->Cw = (float)((vt->dt_sim/2.0)*cf->wall_comp/(2.0*sqrt(pi)));
 
 /* radiation impedance; 1/G_rad and 1/S_rad in parallel */
-	Grad = (float)((9.0*pi*pi)/(128.0*ro*c));	  /* conductance (G_rad) */
-	Srad = (float)((dt_sim/2.0)*(3.0*pi*sqrt(pi))/(8.0*ro));/* suceptance  (S_rad) */
+	vt->Grad = (float)((9.0*pi*pi)/(128.0*ro*c));	  /* conductance (G_rad) */
+	vt->Srad = (float)((vt->dt_sim/2.0)*(3.0*pi*sqrt(pi))/(8.0*ro));/* suceptance  (S_rad) */
 
 /* radiated sound pressure at 1 m */
-	Kr = (float)(ro*simfrq/(2.0*pi*100.0));
-
-/*** memory allocations ***/
-
-	afph = (area_function *) calloc( nph, sizeof(area_function) );
-	dph  = (area_function *) calloc( nph, sizeof(area_function) );
-	acph = (td_acoustic_elements *) calloc( nph+1, sizeof(td_acoustic_elements) );
-	eqph = (td_linear_equation *) calloc( 2*nph+3, sizeof(td_linear_equation) );
-
-	afbu = (area_function *) calloc( nbu, sizeof(area_function) );
-	dbu  = (area_function *) calloc( nbu, sizeof(area_function) );
-	acbu = (td_acoustic_elements *) calloc( nbu+1, sizeof(td_acoustic_elements) );
-	eqbu = (td_linear_equation *) calloc( 2*nbu+3, sizeof(td_linear_equation) );
-
-	dna  = (area_function *) calloc( nna, sizeof(area_function) );
-	acna = (td_acoustic_elements *) calloc( nna+1, sizeof(td_acoustic_elements) );
-	eqna = (td_linear_equation *) calloc( 2*nna+3, sizeof(td_linear_equation) );
+	vt->Kr = (float)(ro*cf->simfrq/(2.0*pi*100.0));
 
 /***  Initalization of memory terms  ***/
 
 /* current/voltage sources associated with reactances */
-	clear_sources( nph, acph );
-	clear_sources( nbu, acbu );
-	irad_lips = 0;
-	clear_sources( nna, acna );
-	irad_nose = 0;
+	clear_sources( nph, vt->acph );
+	clear_sources( nbu, vt->acbu );
+	vt->irad_lips = 0;
+	clear_sources( nna, vt->acna );
+	vt->irad_nose = 0;
 
 /* initial volume velocities and central pressures (the rest condition) */
-	clear_pu( nph4, eqph );
-	clear_pu( nbu4, eqbu );
-	U1_lips = 0;
-	clear_pu( nna4, eqna );
-	U1_nose = 0;
+	clear_pu( vt->nph4, vt->eqph );
+	clear_pu( vt->nbu4, vt->eqbu );
+	vt->U1_lips = 0;
+	clear_pu( vt->nna4, vt->eqna );
+	vt->U1_nose = 0;
 
 /**** Acoustic and matrix elements ****/
 
-	copy_initial_af_t();		/* copy the initial area function */
-	dax();
+	copy_initial_af_t( vt );		/* copy the initial area function */
+	dax( vt );
+	new_input_af( vt );
+	vt->af_fresh = 1;
 
 /* pharyngeal tract */
-	acou_mtrx( nph, afph, dph, acph, eqph, 0., 0.);
-	Ag = nonzero_t( Ag );			/* add glottal resistance */
-	eqph[1].w =  (float)(eqph[1].w +( Rv*xg/Ag + Rk*fabs(eqph[1].x) )/(Ag*Ag));
+	acou_mtrx( vt, nph, vt->afph, vt->dph, vt->acph, vt->eqph, 0., 0.);
+	cf->Ag = nonzero_t( cf->Ag );			/* add glottal resistance */
+	EQ(vt->eqph,1,w) =  (float)(EQ(vt->eqph,1,w)
+		+ ( vt->Rv*cf->xg/cf->Ag + vt->Rk*fabs(EQ(vt->eqph,1,x)) )/(cf->Ag*cf->Ag));
 
 /* bucal cavity */
-	acou_mtrx( nbu, afbu, dbu, acbu, eqbu, 0., 0.);
+	acou_mtrx( vt, nbu, vt->afbu, vt->dbu, vt->acbu, vt->eqbu, 0., 0.);
 
 /* nasal tract */
-	acou_mtrx( nna-1, afnt, dna, acna, eqna, 0., 0. );
-	for(i=1; i<=nna3; i+=2) eqna[i].w += 0.1f;  /* add some extra loss */
+	acou_mtrx( vt, nna-1, cf->afnt, vt->dna, vt->acna, vt->eqna, 0., 0. );
+	for(i=1; i<=vt->nna3; i+=2) EQ(vt->eqna,i,w) += 0.1f;  /* add some extra loss */
 
-	Rs_na = acna[nna-2].Rs;			  /* left arm of the inlet*/
-	Ls_na = acna[nna-2].Ls;			  /* to the nasal tract.  */
-	acou_mtrx(1, afnc, dnc, acna+nna-1, eqna+2*(nna-1), Rs_na, Ls_na);
+	vt->Rs_na = AC(vt->acna,nna-2,Rs);			  /* left arm of the inlet*/
+	vt->Ls_na = AC(vt->acna,nna-2,Ls);			  /* to the nasal tract.  */
+	acou_mtrx( vt, 1, vt->afnc, vt->dnc, ac_offset(vt->acna, nna-1), eq_offset(vt->eqna, 2*(nna-1)),
+		   vt->Rs_na, vt->Ls_na);
 
 /* Radiation loads */
-	if( rad_boundary == RL_CIRCUIT )
-	{  Grad_lips = Grad*afbu[0].A;		/* radiation conductance */
-	   Lrad_lips = (float)(Srad*sqrt(afbu[0].A));	/* radiation suceptance  */
-	   eqbu[0].w = Grad_lips + Lrad_lips;	/* rad. admitance        */
-
-	   Grad_nose = Grad*afnt[0].A;
-	   Lrad_nose = (float)(Srad*sqrt(afnt[0].A));
-	   eqna[0].w = Grad_nose + Lrad_nose;
+	if( cf->rad_boundary == RL_CIRCUIT )
+	{  vt->Grad_lips = vt->Grad*vt->afbu[0].A;		/* radiation conductance */
+	   vt->Lrad_lips = (float)(vt->Srad*sqrt(vt->afbu[0].A));	/* radiation suceptance  */
+	   EQ(vt->eqbu,0,w) = vt->Grad_lips + vt->Lrad_lips;	/* rad. admitance        */
+
+	   vt->Grad_nose = vt->Grad*cf->afnt[0].A;
+	   vt->Lrad_nose = (float)(vt->Srad*sqrt(cf->afnt[0].A));
+	   EQ(vt->eqna,0,w) = vt->Grad_nose + vt->Lrad_nose;
 	}
 	else
-	{  eqbu[0].w = 5.0;			/* short circuit	 */
-	   eqna[0].w = 5.0;
+	{  EQ(vt->eqbu,0,w) = 5.0;			/* short circuit	 */
+	   EQ(vt->eqna,0,w) = 5.0;
 	}
 
 	return( cnst_delay );
 }
 
 /*****
-*	Function: vtt_sim
-*	Note	: time-domain simulation of the vocal tract. Returns
+*	Function: vtt_sim_r
+*	Note	: time-domain simulation of the vocal tract vt. Returns
 *		  a single speech sample as value with the rate of
 *		  smpfrq (Hz).
 *****/
 
-float	vtt_sim( )
+float	vtt_sim_r( vtt_context *vt )
 {
-	short	j;
-	float	f, g, h, p, q, sound, sound_decim;
+	vt_config	*cf = &vt->cf;
+	short	nph2 = vt->nph2, nph3 = vt->nph3, nph4 = vt->nph4;
+	short	nbu2 = vt->nbu2, nbu3 = vt->nbu3, nbu4 = vt->nbu4;
+	short	nna2 = vt->nna2, nna3 = vt->nna3, nna4 = vt->nna4;
+	short	nna = cf->nna;
+	td_ac_array	acph = vt->acph, acbu = vt->acbu, acna = vt->acna;
+	td_eq_array	eqph = vt->eqph, eqbu = vt->eqbu, eqna = vt->eqna;
+	short	j, varying = 0;
+	float	f, g, h, p, q, sound, sound_decim = 0;
+	float	Rg, Ag2;
 
 /*** compute da and dx with a new area function, and Ud=d(A*x)/dt ***/
 
-	if( vocal_tract == TIME_VARYING)
-	{  dax();
-	   if( dynamic_term == ON ) Ud();
+	if( cf->vocal_tract == TIME_VARYING)
+	{  if( new_input_af( vt ) || vt->af_fresh )
+	   {  dax( vt );			/* else the elements are kept */
+	      varying = 1;
+	      vt->af_fresh = 0;
+	   }
+	   if( cf->dynamic_term == ON ) Ud( vt );
 	}
 
+/*** the glottis is constant during the deci cycles ***/
+
+	cf->Ag = nonzero_t( cf->Ag );
+	Rg  = vt->Rv*cf->xg/cf->Ag;
+	Ag2 = cf->Ag*cf->Ag;
+
 /*** Simulate deci (=simfrq/smpfrq) cycles with intpolation of a and x ***/
 
-	for(j=0; j<deci; j++)
+	for(j=0; j<vt->deci; j++)
 	{
 
 /*** solve s = Wx ***/
 
-	   if( nasal_tract == ON )
+	   if( cf->nasal_tract == ON )
 	   {  elimination_t(1, nph3, eqph);
 	      elimination_t(0, nbu3, eqbu);
 	      elimination_t(0, nna3, eqna);
 
-	      f = eqph[nph3].S/eqph[nph3].W;
-	      g = eqbu[nbu3].S/eqbu[nbu3].W;
-	      h = eqna[nna3].S/eqna[nna3].W;
+	      f = EQ(eqph,nph3,S)/EQ(eqph,nph3,W);
+	      g = EQ(eqbu,nbu3,S)/EQ(eqbu,nbu3,W);
+	      h = EQ(eqna,nna3,S)/EQ(eqna,nna3,W);
 	      p = f + g + h;
-	      f = eqph[nph2].W/eqph[nph3].W;
-	      g = eqbu[nbu2].W/eqbu[nbu3].W;
-	      h = eqna[nna2].W/eqna[nna3].W;
+	      f = EQ(eqph,nph2,W)/EQ(eqph,nph3,W);
+	      g = EQ(eqbu,nbu2,W)/EQ(eqbu,nbu3,W);
+	      h = EQ(eqna,nna2,W)/EQ(eqna,nna3,W);
 	      q = f + g + h;
-	      eqph[nph4].x = eqbu[nbu4].x = eqna[nna4].x = p/q;
+	      EQ(eqph,nph4,x) = EQ(eqbu,nbu4,x) = EQ(eqna,nna4,x) = p/q;
 
 	      substitution_t(1, nph3, eqph);
 	      substitution_t(0, nbu3, eqbu);
@@ -568,13 +780,13 @@ float	vtt_sim( )
 	   {  elimination_t(1, nph3, eqph);
 	      elimination_t(0, nbu3, eqbu);
 
-	      f = eqph[nph3].S/eqph[nph3].W;
-	      g = eqbu[nbu3].S/eqbu[nbu3].W;
+	      f = EQ(eqph,nph3,S)/EQ(eqph,nph3,W);
+	      g = EQ(eqbu,nbu3,S)/EQ(eqbu,nbu3,W);
 	      p = f + g;
-	      f = eqph[nph2].W/eqph[nph3].W;
-	      g = eqbu[nbu2].W/eqbu[nbu3].W;
+	      f = EQ(eqph,nph2,W)/EQ(eqph,nph3,W);
+	      g = EQ(eqbu,nbu2,W)/EQ(eqbu,nbu3,W);
 	      q = f + g;
-	      eqph[nph4].x = eqbu[nbu4].x = p/q;
+	      EQ(eqph,nph4,x) = EQ(eqbu,nbu4,x) = p/q;
 
 	      substitution_t(1, nph3, eqph);
 	      substitution_t(0, nbu3, eqbu);
@@ -582,61 +794,61 @@ float	vtt_sim( )
 
 /*** Refresh acoustic and matrix elements ***/
 
-	   if( vocal_tract == TIME_VARYING )
+	   if( varying )
 	   {
 /* pharyngeal tract */
-	      acou_mtrx( nph, afph, dph, acph, eqph, 0., 0.);
+	      acou_mtrx( vt, cf->nph, vt->afph, vt->dph, acph, eqph, 0., 0.);
 
 /* bucal cavity */
-	      acou_mtrx( nbu, afbu, dbu, acbu, eqbu, 0., 0.);
-	      if( rad_boundary == RL_CIRCUIT )
+	      acou_mtrx( vt, cf->nbu, vt->afbu, vt->dbu, acbu, eqbu, 0., 0.);
+	      if( cf->rad_boundary == RL_CIRCUIT )
 	      { 
-			  Grad_lips = Grad*afbu[0].A;
-			  Lrad_lips = (float)(Srad*sqrt(afbu[0].A));
-			  eqbu[0].w = Grad_lips + Lrad_lips;
+			  vt->Grad_lips = vt->Grad*vt->afbu[0].A;
+			  vt->Lrad_lips = (float)(vt->Srad*sqrt(vt->afbu[0].A));
+			  EQ(eqbu,0,w) = vt->Grad_lips + vt->Lrad_lips;
 	      }
 	      else
-		 eqbu[0].w = 10.0;		/* short circuit */
+		 EQ(eqbu,0,w) = 10.0;		/* short circuit */
 /* nasal inlet */
-	      acou_mtrx(1, afnc, dnc, acna+nna-1, eqna+2*(nna-1), Rs_na, Ls_na);
+	      acou_mtrx( vt, 1, vt->afnc, vt->dnc, ac_offset(acna, nna-1), eq_offset(eqna, 2*(nna-1)),
+			 vt->Rs_na, vt->Ls_na);
 	   }
 /* add the glottal resistance (it is always time_varying) */
-	   Ag = nonzero_t( Ag );
-	   eqph[1].w = (float)(acph[0].Rs + acph[0].Ls
-		     + (Rv*xg/Ag + Rk*fabs(eqph[1].x))/(Ag*Ag));
+	   EQ(eqph,1,w) = (float)(AC(acph,0,Rs) + AC(acph,0,Ls)
+		     + (Rg + vt->Rk*fabs(EQ(eqph,1,x)))/Ag2);
 
 /*** Refresh force constants ***/
 
-	   force_constants(nph, acph, eqph);
-	   eqph[1].s = acph[0].els + H2O_bar*Psub;	/* right arm */
+	   force_constants(cf->wall, cf->nph, acph, eqph);
+	   EQ(eqph,1,s) = AC(acph,0,els) + cf->H2O_bar*cf->Psub;	/* right arm */
 
-	   if( rad_boundary == RL_CIRCUIT )
-	      irad_lips = (float)(2.0*Lrad_lips*eqbu[0].x + irad_lips);
-	   force_constants(nbu, acbu, eqbu);
-	   eqbu[0].s = -irad_lips;		/* rad. admitance */
-	   eqbu[1].s = acbu[0].els;		/* right arm      */
+	   if( cf->rad_boundary == RL_CIRCUIT )
+	      vt->irad_lips = (float)(2.0*vt->Lrad_lips*EQ(eqbu,0,x) + vt->irad_lips);
+	   force_constants(cf->wall, cf->nbu, acbu, eqbu);
+	   EQ(eqbu,0,s) = -vt->irad_lips;		/* rad. admitance */
+	   EQ(eqbu,1,s) = AC(acbu,0,els);		/* right arm      */
 
-	   U0_lips = U1_lips;
-	   U1_lips = -eqbu[1].x;
-	   sound   = U1_lips - U0_lips;
+	   vt->U0_lips = vt->U1_lips;
+	   vt->U1_lips = -EQ(eqbu,1,x);
+	   sound   = vt->U1_lips - vt->U0_lips;
 
-	   if( nasal_tract == ON )
+	   if( cf->nasal_tract == ON )
 	   {  
-		   if( rad_boundary == RL_CIRCUIT )
-			   irad_nose = (float)(2.0*Lrad_nose*eqna[0].x + irad_nose);
-		   force_constants(nna, acna, eqna);
-		   eqna[0].s = -irad_nose;		/* rad. admitance */
-		   eqna[1].s = acna[0].els;		/* right arm      */
+		   if( cf->rad_boundary == RL_CIRCUIT )
+			   vt->irad_nose = (float)(2.0*vt->Lrad_nose*EQ(eqna,0,x) + vt->irad_nose);
+		   force_constants(cf->wall, nna, acna, eqna);
+		   EQ(eqna,0,s) = -vt->irad_nose;		/* rad. admitance */
+		   EQ(eqna,1,s) = AC(acna,0,els);		/* right arm      */
 	
-		   U0_nose = U1_nose;
-		   U1_nose = -eqna[1].x;
-		   sound   = sound + U1_nose - U0_nose;
+		   vt->U0_nose = vt->U1_nose;
+		   vt->U1_nose = -EQ(eqna,1,x);
+		   sound   = sound + vt->U1_nose - vt->U0_nose;
 	   }
 
 /*** decimation of the radiated sound ***/
 
-	   if( j == deci - 1 ) sound_decim = decim( 1, Kr*sound );
-	   else                 	     decim( 0, Kr*sound );
+	   if( j == vt->deci - 1 ) sound_decim = decim( vt, 1, vt->Kr*sound );
+	   else                 	     decim( vt, 0, vt->Kr*sound );
 	}
 
 /*** return the radiated sound pressure ***/
@@ -644,6 +856,163 @@ float	vtt_sim( )
 	return( sound_decim );
 }
 
+/*****
+*	Function : vtt_term_r
+*	Note :	free memories of the simulator vt
+****/
+
+void	vtt_term_r ( vtt_context *vt )
+{
+	free( vt->mem );
+	vt->mem = NULL;
+	vt->mem_size = 0;
+}
+
+/*****
+*	Function : copy_vt_config
+*	Note :	Copy the global configuration, declared in a "main", into
+*		cf.  This is the usual way to start the configuration of
+*		a simulator instance.
+*****/
+
+void	copy_vt_config ( vt_config *cf )
+{
+	cf->simfrq = simfrq;
+	cf->smpfrq = smpfrq;
+	cf->decim_taps = decim_taps;
+	cf->decim_cutoff = decim_cutoff;
+	cf->Psub = Psub;
+	cf->Ag = Ag;
+	cf->xg = xg;
+	cf->lg = lg;
+	cf->Kc = Kc;
+	cf->nbu = nbu;
+	cf->nph = nph;
+	cf->nvt = nvt;
+	cf->afvt = afvt;
+	cf->anc = anc;
+	cf->nna = nna;
+	cf->afnt = afnt;
+	cf->nss = nss;
+	cf->nasal_tract = nasal_tract;
+	cf->wall = wall;
+	cf->rad_boundary = rad_boundary;
+	cf->glt_boundary = glt_boundary;
+	cf->source_loc = source_loc;
+	cf->source_typ = source_typ;
+	cf->vocal_tract = vocal_tract;
+	cf->dynamic_term = dynamic_term;
+	cf->extra_loss_factor = extra_loss_factor;
+	cf->ro = ro;
+	cf->c = c;
+	cf->eta = eta;
+	cf->cp = cp;
+	cf->lamda = lamda;
+	cf->mu = mu;
+	cf->wall_resi = wall_resi;
+	cf->wall_mass = wall_mass;
+	cf->wall_comp = wall_comp;
+	cf->H2O_bar = H2O_bar;
+}
+
+/*****
+*	Function : vt_rates_r
+*	Note :	Set the output rate (smp) and the simulation rate (sim)
+*		of cf, in Hz.  The simulation rate is rounded to the
+*		nearest integer multiple of the output rate, deci, so
+*		that the decimator remains a plain FIR; e.g., an output
+*		at 16 kHz is simulated at 32 or 48 kHz and one at 22.05
+*		kHz at 44.1 or 66.15 kHz.  The constants of the
+*		simulator and the decimation filter follow the rates at
+*		the next vtt_ini_r.  It returns deci, or -1 if a rate
+*		is not positive (cf is then unchanged).
+*****/
+
+short	vt_rates_r ( vt_config *cf, float smp, float sim )
+{
+	short	deci;
+
+	if( smp <= 0 || sim <= 0 ) return( -1 );
+	deci = (short)(sim/smp + 0.5);
+	if( deci < 1 ) deci = 1;
+
+	cf->smpfrq = smp;
+	cf->simfrq = deci*smp;
+	return( deci );
+}
+
+/*****
+*	Function : vt_deci
+*	Note :	The decimation factor of cf, simfrq/smpfrq rounded to the
+*		nearest integer (at least 1), as vt_rates_r sets it; every
+*		simulator of cf (vtt_lib.c, vtt_bank.c) takes it from here.
+*****/
+
+short	vt_deci ( const vt_config *cf )
+{
+	short	deci;
+
+	deci = (short)(cf->simfrq/cf->smpfrq + 0.5);
+	return( deci < 1 ? 1 : deci );
+}
+
+/******************( Functions called from a main )***********************/
+
+/*****
+*	Function : vtt_ini
+*	Note :	Initialize the vocal-tract state. It returns the constant
+*		delay due to the decimation filter.  The memory of the
+*		simulator is reused from the previous initialization,
+*		unless vtt_term has been called.
+*****/
+
+short	vtt_ini ( )
+{
+	short	cnst_delay;
+
+	copy_vt_config( &vtt.cf );
+	cnst_delay = vtt_reset_r( &vtt );	/* vtt is cleared: mem = NULL */
+	Ag = vtt.cf.Ag;
+	return( cnst_delay );
+}
+
+/*****
+*	Function: vtt_sim
+*	Note	: time-domain simulation of the vocal tract. Returns
+*		  a single speech sample as value with the rate of
+*		  smpfrq (Hz).  The global inputs (Ag, afvt, ...) are
+*		  taken over at every call.
+*****/
+
+float	vtt_sim( )
+{
+	float	sound;
+
+	copy_vt_config( &vtt.cf );
+	sound = vtt_sim_r( &vtt );
+	Ag = vtt.cf.Ag;
+	return( sound );
+}
+
+/*****
+*	Function : vt_rates
+*	Note :	Same as vt_rates_r, for the global smpfrq and simfrq.
+*		They must not change between vtt_ini and vtt_term.
+*****/
+
+short	vt_rates ( float smp, float sim )
+{
+	vt_config	cf;
+	short	deci;
+
+	deci = vt_rates_r( &cf, smp, sim );
+	if( deci > 0 )
+	{  smpfrq = cf.smpfrq;
+	   simfrq = cf.simfrq;
+	}
+	return( deci );
+}
+
 /*****
 *	Function : vtt_term
 *	Note :	free memories
@@ -651,17 +1020,5 @@ float	vtt_sim( )
 
 void	vtt_term ( void )
 {
-	free( afph );
-	free( dph );
-	free( acph );
-	free( eqph );
-
-	free( afbu );
-	free( dbu );
-	free( acbu );
-	free( eqbu );
-
-	free( dna );
-	free( acna );
-	free( eqna );
+	vtt_term_r( &vtt );
 }
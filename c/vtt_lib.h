@@ -0,0 +1,130 @@
+#ifndef VTT_LIB_H
+#define VTT_LIB_H
+
+/*****
+*	File :	vtt_lib.h
+*	Note :	Structures for the time-domain simulation of the vocal
+*		tract.  All the state of one simulator is held in a
+*		vtt_context, so that several independent voices can be
+*		simulated in the same process.
+*****/
+
+#include <stddef.h>
+#include "vtconfig.h"
+
+/*********************(stractue array definitions)***********************/
+
+typedef struct { float	Rs,	/* series (flow) resistance		*/
+			Ls,	/* series inductance (acoustic mass)	*/
+			els,	/* voltage source associated with Ls	*/
+			Ns,	/* dipole noise pressure sources	*/
+			Ca,	/* parallel capacitance (compliance)	*/
+			ica,	/* current source associated with Ca	*/
+			Ud,	/* parzllel flow source dur to dA/dt	*/
+			Rw,	/* wall mechanical resistance		*/
+			Lw,	/* wall mass (inductance)		*/
+			elw,	/* voltage source associated with Lw	*/
+			Cw,	/* wall compiance			*/
+			ecw,	/* voltage source associated with Cw	*/
+			Gw;	/* total wall conductance, 1/(Rw+Lw+Cw)	*/
+		}  td_acoustic_elements;
+
+typedef	struct { float	s,	/* forces (interlaced voltage-current	*/
+				/* sources)				*/
+			w,	/* matrix coefficients			*/
+			x,	/* variables (interlaced U and P's)	*/
+			S,	/* s after elimination procedure	*/
+			W;	/* w after elimination procedure	*/
+		}  td_linear_equation;
+
+/*****
+*	Storage of the tubes.  By default, the arrays of the structures
+*	above.  Compiled with VTT_SOA, a structure of arrays instead (one
+*	contiguous array per field), so that a pass over a tube only
+*	brings the fields it uses into the cache.  AC(ac,i,f) and
+*	EQ(eq,i,f) address the field f of the element i in both cases.
+*****/
+
+#ifdef VTT_SOA
+typedef struct { float	*Rs, *Ls, *els, *Ns, *Ca, *ica, *Ud,
+			*Rw, *Lw, *elw, *Cw, *ecw, *Gw;
+		}  td_ac_array;
+typedef struct { float	*s, *w, *x, *S, *W;
+		}  td_eq_array;
+#define	AC(ac,i,f)	((ac).f[i])
+#define	EQ(eq,i,f)	((eq).f[i])
+#else
+typedef	td_acoustic_elements	*td_ac_array;
+typedef	td_linear_equation	*td_eq_array;
+#define	AC(ac,i,f)	((ac)[i].f)
+#define	EQ(eq,i,f)	((eq)[i].f)
+#endif
+
+/*****************( state of a vocal tract simulator )*******************/
+
+#define	DECIM_BLOCK	8	/* the FIR dot product runs in blocks of */
+				/* this many taps			 */
+
+typedef struct {
+	vt_config	cf;	/* configuration; Ag, Psub, anc and the	*/
+				/* afvt[] contents are the inputs which	*/
+				/* the caller may change between samples*/
+
+	short	deci;		/* decimation rate = simfrq/smpfrq */
+	float	dt_sim;
+	float	Rk, Rv, La, Ca, Grad, Srad, Rw, Lw, Cw, Kr;
+
+/* pharyngeal tube */
+	short			nph2, nph3, nph4;
+	area_function		*afph, *dph;
+	td_ac_array		acph;
+	td_eq_array		eqph;
+/* bucal tube	*/
+	short			nbu2, nbu3, nbu4;
+	area_function		*afbu, *dbu;
+	td_ac_array		acbu;
+	td_eq_array		eqbu;
+	float			Grad_lips, Lrad_lips, irad_lips;
+	float			U0_lips, U1_lips;
+/* nasal tract */
+	area_function		*dna;		     /* zeros */
+	short			nna2, nna3, nna4;
+	area_function		afnc[1], dnc[1];     /* NT inlet */
+	td_ac_array		acna;
+	float			Rs_na, Ls_na;
+	td_eq_array		eqna;
+	float			Grad_nose, Lrad_nose, irad_nose;
+	float			U0_nose, U1_nose;
+
+/* input area function of the last sample (see new_input_af) */
+	area_function		*afin;
+	float			ancin;
+	short			af_fresh;	/* elements not refreshed yet */
+
+/* decimation filter (see decim_init) */
+	short	p_decim;	/* filter length, odd			*/
+	short	l_decim;	/* p_decim rounded up to DECIM_BLOCK	*/
+	short	count_decim;	/* position of the last input		*/
+	float	*h_decim;	/* l_decim coefficients, zero padded	*/
+	float	*v_decim;	/* p_decim + l_decim past inputs	*/
+
+/* one block for all the arrays above, kept by vtt_reset_r */
+	void	*mem;
+	size_t	mem_size;	/* bytes */
+} vtt_context;
+
+/*******************( reentrant simulator functions )*********************/
+
+short	vtt_ini_r( vtt_context *vt );
+short	vtt_reset_r( vtt_context *vt );
+size_t	vtt_alloc_r( vtt_context *vt );
+float	vtt_sim_r( vtt_context *vt );
+void	vtt_term_r( vtt_context *vt );
+
+/* the decimation filter, also used by vtt_bank.c */
+short	decim_length( const vt_config *cf, short deci );
+void	decim_coefs( const vt_config *cf, short deci, short p, float *h );
+short	decim_init( vtt_context *vt );
+float	decim( vtt_context *vt, short out_flag, float x );
+
+#endif
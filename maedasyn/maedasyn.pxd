@@ -5,16 +5,29 @@ Created on Wed Nov 20 14:44:19 2013
 @author: Ronald L. Sprouse (ronald@berkeley.edu)
 """
 
+from libc.stdio cimport FILE
+
 cdef extern from '../c/always.h':
     pass
 
 cdef extern from '../c/vtconfig.h':
     short nss
+    short nbu
+    short nph
+    short nna
+    float simfrq
+    float smpfrq
+    short vt_rates(float smp, float sim)
     ctypedef struct area_function:
         float A
         float x
     area_function *afvt
     area_function *afnt
+    ctypedef struct vt_config:
+        float simfrq
+        float smpfrq
+        short nss
+    short vt_rates_r(vt_config *cf, float smp, float sim)
 
 cdef extern from '../c/lam_lib.h':
     int NP
@@ -25,16 +38,37 @@ cdef extern from '../c/lam_lib.h':
     float2D *ivt
     float2D *evt
     float2D *f2d
+    short lam_np "np"
+    ctypedef struct vt_profile:
+        short np
+        float2D ivt[1]
+        float2D evt[1]
+        float lip_h
+        float lip_w
+    ctypedef struct lam_model:
+        pass
+    const lam_model *lam_default()
+    void lam_batch(const lam_model *md, const float *pa, long m, long ldp,
+                   vt_profile *vp, short nss, area_function *af) nogil
+    void lam_spec_changed()
+    void lam_setup()
 
 cdef extern from '../c/vsyn_lib.h':
     pass
 
+cdef extern from '../c/vtt_lib.h':
+    ctypedef struct vtt_context:
+        vt_config cf
+
 cdef extern from '../c/vtt_lib.c':
-    pass
+    void copy_vt_config(vt_config *cf)
 
 cdef extern from '../c/lam_lib.c':
     pass
 
+cdef extern from '../c/codebook.c':
+    pass
+
 cdef extern from '../c/vsyn_lib.c':
     int M4
     int NVRS_WAL
@@ -42,8 +76,83 @@ cdef extern from '../c/vsyn_lib.c':
     float *beta
     float *u_wal
 
+cdef extern from '../c/vtf_lib.c':
+    short vtf_transfer(const float *freq, int nf, float *Hre, float *Him)
+    short vtf_formants(float flo, float fhi, int nfmt, float *F, float *B)
+    short vtf_formants_batch(const vt_config *cf, const area_function *af,
+                             const float *anc, long m, float flo, float fhi,
+                             int nfmt, float *F, float *B, int nthreads) nogil
+
+cdef extern from '../c/invert.c':
+    ctypedef struct inv_codebook:
+        short nfmt
+        float flo, fhi
+        short nph, nbu
+        float smpfrq, simfrq
+        long size
+        float *para
+        float *key
+        char *dim
+    ctypedef struct inv_options:
+        int k
+        float smooth
+        float reg
+        int iter
+        float sigma
+    short inv_build(inv_codebook *ib, const vt_config *cf, long npoints,
+                    unsigned long seed, const float *lo, const float *hi,
+                    int nfmt, float flo, float fhi, int nthreads) nogil
+    short inv_write(const inv_codebook *ib, const char *path)
+    short inv_read(inv_codebook *ib, const char *path)
+    long inv_nearest(const inv_codebook *ib, const float *F, int k,
+                     long *idx, float *dist)
+    void inv_options_default(inv_options *op)
+    short inv_track(const inv_codebook *ib, const vt_config *cf,
+                    const inv_options *op, const float *F, long T,
+                    float *para, float *err, int nthreads) nogil
+    void inv_term(inv_codebook *ib)
+    const char *inv_error(short r)
+    int IV_NPAR
+    int IV_NFMT
+    int IV_EFILE
+    int IV_EARG
+
 cdef extern from '../c/synthesize.c':
-    void synth_frame(float *params, short *buffer, short mode)
+    ctypedef struct synth_voice:
+        vtt_context vt
+        vt_profile prof
+        area_function *afvt
+    short synth_voice_ini(synth_voice *sv, const vt_config *cf)
+    void synth_voice_term(synth_voice *sv)
+    long synth_track_length(float rate, float **par, int time_steps)
+    long synthesize_into_r(synth_voice *sv, float **par, int time_steps,
+                           void *out, short format) nogil
+    ctypedef struct synth_framer:
+        synth_voice sv
+    short synth_framer_ini(synth_framer *fr, const vt_config *cf)
+    short synth_framer_interp(synth_framer *fr, short kind, short updates)
+    short synth_framer_frame(synth_framer *fr, const float *params, short *buffer, short mode) nogil
+    short synth_framer_frame_f(synth_framer *fr, const float *params, float *buffer, short mode) nogil
+    void synth_framer_term(synth_framer *fr)
+    ctypedef struct synth_rt:
+        long rendered
+        long late
+    short synth_rt_ini(synth_rt *rt, const vt_config *cf, int capacity)
+    int synth_rt_post(synth_rt *rt, const float *frame)
+    long synth_rt_render(synth_rt *rt, short *out, long n) nogil
+    long synth_rt_render_f(synth_rt *rt, float *out, long n) nogil
+    short synth_rt_start(synth_rt *rt, FILE *out, short format, long block, short paced)
+    void synth_rt_stop(synth_rt *rt)
+    void synth_rt_term(synth_rt *rt)
+    int OUT_S16
+    int OUT_F32
+    short synth_frame(float *params, short *buffer, short mode)
+    short synth_frame_f(float *params, float *buffer, short mode)
+    short synth_frame_interp(short kind, short updates)
+    int INTERP_NONE
+    int INTERP_LINEAR
+    int INTERP_CUBIC
+    short frame_length(float rate)
     int AMloc
     int AMnum
     int AP
@@ -51,7 +160,6 @@ cdef extern from '../c/synthesize.c':
     int F0_LOC
     int TIME
     float FRAME_DUR
-    float smpfrq
     float *aa
     float *uw
     float *iy
@@ -8,6 +8,10 @@ Created on Wed Nov 20 15:01:24 2013
 import numpy as np
 cimport numpy as np
 cimport maedasyn.maedasyn as ms
+from libc.stdio cimport FILE, fopen, fclose
+from libc.stdlib cimport malloc, free
+
+np.import_array()
 
 
 ########################################################################
@@ -26,28 +30,272 @@ NPAR = ms.NPAR
 F0_LOC = ms.F0_LOC
 TIME = ms.TIME
 FRAME_DUR = ms.FRAME_DUR
-smpfrq = ms.smpfrq
+smpfrq = ms.smpfrq      # the default rate; see get_rates() for the current one
 
 NP = ms.NP
 
-# Wrapper for C code synth_frame() in synthesize.c.
+# Wrapper for C code synth_frame() in synthesize.c. params is a frame of at
+# least NPAR values (as FrameParam.fields). Returns the number of samples
+# written in buff, which must hold at least frame_length() samples.
 def synth_frame(
     np.ndarray[float, ndim=1, mode="c"] params not None,
     np.ndarray[short, ndim=1, mode="c"] buff not None,
     mode
 ):
-    ms.synth_frame(&params[0], &buff[0], mode)
-    return None
+    if params.shape[0] < NPAR:
+        raise ValueError("params must hold at least %d values" % NPAR)
+    if mode > 2:
+        assert(buff.shape[0] >= mode)
+    else:
+        assert(buff.shape[0] >= ms.frame_length(ms.smpfrq))
+    return ms.synth_frame(&params[0], &buff[0], mode)
+
+# As synth_frame(), with float32 samples; 1.0 is the full scale of the int16 ones.
+def synth_frame_f(
+    np.ndarray[float, ndim=1, mode="c"] params not None,
+    np.ndarray[float, ndim=1, mode="c"] buff not None,
+    mode
+):
+    if params.shape[0] < NPAR:
+        raise ValueError("params must hold at least %d values" % NPAR)
+    if mode > 2:
+        assert(buff.shape[0] >= mode)
+    else:
+        assert(buff.shape[0] >= ms.frame_length(ms.smpfrq))
+    return ms.synth_frame_f(&params[0], &buff[0], mode)
+
+INTERP_NONE = ms.INTERP_NONE
+INTERP_LINEAR = ms.INTERP_LINEAR
+INTERP_CUBIC = ms.INTERP_CUBIC
+
+# Interpolation of the parameters within a frame of synth_frame (mode 2):
+# INTERP_NONE (the default), INTERP_LINEAR or INTERP_CUBIC from the previous
+# frame, with the area function computed updates times per frame.
+def set_interp(kind, updates=1):
+    if ms.synth_frame_interp(kind, updates) < 0:
+        raise ValueError("unknown kind or updates < 1")
+
+# Output and simulation rates in Hz. The simulation rate is rounded to a whole
+# multiple of the output rate. They take effect at the next initialization
+# (synth_frame mode 1), e.g. when a Synth is created.
+def set_rates(smp, sim=None):
+    if sim is None:
+        sim = 3 * smp
+    if ms.vt_rates(smp, sim) < 0:
+        raise ValueError("rates must be positive")
+
+def get_rates():
+    return (ms.smpfrq, ms.simfrq)
+
+# Largest number of samples in a frame at the current rate.
+def frame_length():
+    return ms.frame_length(ms.smpfrq)
  
+# Synthesize a whole utterance in one native call, without the GIL.
+# params: (T x 11) array of frames (columns as in FrameParam.fields, time in
+# ms, increasing), as for the C function synthesize(); the voice has the
+# current configuration and rates but a tract of its own.
+# dtype: np.int16 (saturated) or np.float32 (1.0 = int16 full scale)
+# Returns the wave, with the 60 ms 'transition' after the last frame.
+def synthesize_utterance(params, dtype=np.int16):
+    cdef np.ndarray[float, ndim=2, mode="c"] p = np.ascontiguousarray(params, dtype=np.float32)
+    cdef np.ndarray out
+    cdef ms.vt_config cf
+    cdef ms.synth_voice *sv
+    cdef float **rows
+    cdef void *buf
+    cdef int T = p.shape[0], i
+    cdef short fmt
+    cdef long n
+    dtype = np.dtype(dtype)
+    if dtype == np.int16:
+        fmt = ms.OUT_S16
+    elif dtype == np.float32:
+        fmt = ms.OUT_F32
+    else:
+        raise ValueError("dtype must be np.int16 or np.float32")
+    if p.ndim != 2 or p.shape[1] != NPAR + 1 or T < 1:
+        raise ValueError("params must be a (T x %d) array, T >= 1" % (NPAR + 1))
+    ms.copy_vt_config(&cf)
+    rows = <float **> malloc(T * sizeof(float *))
+    sv = <ms.synth_voice *> malloc(sizeof(ms.synth_voice))
+    if rows == NULL or sv == NULL or ms.synth_voice_ini(sv, &cf) != 0:
+        free(rows)
+        free(sv)
+        raise MemoryError()
+    try:
+        for i in range(T):
+            rows[i] = &p[i, 0]
+        out = np.zeros(ms.synth_track_length(cf.smpfrq, rows, T), dtype=dtype)
+        buf = out.data
+        with nogil:
+            n = ms.synthesize_into_r(sv, rows, T, buf, fmt)
+        if n < 0:
+            raise MemoryError()
+    finally:
+        ms.synth_voice_term(sv)
+        free(sv)
+        free(rows)
+    return out
+
 ###### Access to C arrays #####
 #
 #
-#  We copy values from C arrays. This is a quick and easy way to get the job done.
-#  It would be better to import them more directly through their pointers.
+#  get_ivt() etc. copy values from C arrays into lists of dicts.  ivt_view() etc.
+#  return read-only (n x 2) float32 arrays which view the C memory directly, so
+#  they follow the synthesizer without any copy: columns x, y for the profiles
+#  and A, x for the area functions.  A view of afvt is valid until the number
+#  of sections grows (a larger afvt is then allocated at the next
+#  initialization).  These are the arrays of synth_frame; a Synth has its own
+#  (see Synth.ivt_x etc.).
 #
 #
 ################################
 
+# owner: the object which holds data, kept alive by the view, or None
+cdef object _view(void *data, int n, object owner=None):
+    cdef np.npy_intp dims[2]
+    cdef np.ndarray a
+    if data == NULL:
+        return None
+    dims[0] = n
+    dims[1] = 2
+    a = np.PyArray_SimpleNewFromData(2, dims, np.NPY_FLOAT32, data)
+    if owner is not None:
+        np.set_array_base(a, owner)
+    a.flags.writeable = False
+    return a
+
+# the points of the last profile computed by synth_frame
+def ivt_view():
+    return _view(ms.ivt, ms.lam_np)
+
+def evt_view():
+    return _view(ms.evt, ms.lam_np)
+
+def afvt_view():
+    return _view(ms.afvt, ms.nss)
+
+def afnt_view():
+    return _view(ms.afnt, ms.nna)
+
+# Geometry of many frames in one native call (lam_batch): params is a (T x 11)
+# array of frames, as for synth_frame, or (T x 7) of articulatory parameters.
+# Returns (profiles, af): profiles is a structured array of T records with
+# fields np (number of points), ivt and evt (NP x 2, the first np points are
+# valid), lip_h and lip_w; af is a (T x nsec x 2) float32 array of the area
+# functions with nsec equal sections, by default the nph + nbu of synth_frame.
+def frame_records(params, nsec=None):
+    cdef np.ndarray[float, ndim=2, mode="c"] p = np.ascontiguousarray(params, dtype=np.float32)
+    cdef np.ndarray prof, af
+    cdef ms.vt_profile v
+    cdef char *base = <char *>&v
+    cdef const ms.lam_model *md
+    cdef const float *pa
+    cdef ms.vt_profile *vp
+    cdef ms.area_function *afp
+    cdef long off, m, ldp
+    cdef short ns
+    if p.shape[1] == NPAR + 1:
+        off = AMloc
+    elif p.shape[1] == AMnum:
+        off = 0
+    else:
+        raise ValueError("params must have %d or %d columns" % (NPAR + 1, AMnum))
+    if nsec is None:
+        nsec = ms.nph + ms.nbu
+    if nsec < 1:
+        raise ValueError("nsec must be positive")
+    dt = np.dtype({
+        'names': ['np', 'ivt', 'evt', 'lip_h', 'lip_w'],
+        'formats': [np.int16, (np.float32, (NP, 2)), (np.float32, (NP, 2)),
+                    np.float32, np.float32],
+        'offsets': [<char *>&v.np - base, <char *>&v.ivt[0] - base,
+                    <char *>&v.evt[0] - base, <char *>&v.lip_h - base,
+                    <char *>&v.lip_w - base],
+        'itemsize': sizeof(ms.vt_profile)})
+    prof = np.zeros(p.shape[0], dtype=dt)
+    af = np.zeros((p.shape[0], nsec, 2), dtype=np.float32)
+    m = p.shape[0]
+    ns = nsec
+    if m > 0:
+        md = ms.lam_default()
+        pa = &p[0, off]
+        ldp = p.shape[1]
+        vp = <ms.vt_profile *>prof.data
+        afp = <ms.area_function *>af.data
+        with nogil:
+            ms.lam_batch(md, pa, m, ldp, vp, ns, afp)
+    return prof, af
+
+# Transfer function (vtf_transfer in vtf_lib.c) of the area function of the
+# last synth_frame, at the frequencies freq (Hz), computed in the frequency
+# domain: a complex64 array, the volume velocity at the lips and nostrils per
+# unit source.
+def transfer_function(freq):
+    cdef np.ndarray[float, ndim=1, mode="c"] f = np.ascontiguousarray(freq, dtype=np.float32).ravel()
+    cdef np.ndarray[float, ndim=1, mode="c"] hr = np.empty(f.shape[0], dtype=np.float32)
+    cdef np.ndarray[float, ndim=1, mode="c"] hi = np.empty(f.shape[0], dtype=np.float32)
+    if f.shape[0] > 0 and ms.vtf_transfer(&f[0], f.shape[0], &hr[0], &hi[0]) != 0:
+        raise RuntimeError("vtf_transfer failed")
+    h = np.empty(f.shape[0], dtype=np.complex64)
+    h.real = hr
+    h.imag = hi
+    return h
+
+# Formants of the area function of the last synth_frame (vtf_formants): the
+# first nfmt poles of the transfer function above flo Hz, searched up to fhi
+# Hz. Returns (F, B), float32 arrays of nfmt frequencies and bandwidths in Hz,
+# 0 for those not found.
+def formants(nfmt=4, flo=90.0, fhi=5000.0):
+    cdef np.ndarray[float, ndim=1, mode="c"] F = np.zeros(nfmt, dtype=np.float32)
+    cdef np.ndarray[float, ndim=1, mode="c"] B = np.zeros(nfmt, dtype=np.float32)
+    if nfmt < 1:
+        raise ValueError("nfmt must be positive")
+    if ms.vtf_formants(flo, fhi, nfmt, &F[0], &B[0]) < 0:
+        raise RuntimeError("vtf_formants failed")
+    return F, B
+
+# The same for many area functions in parallel (vtf_formants_batch): af is a
+# (T x nsec x 2) array of area functions with the nph + nbu sections of
+# synth_frame, as frame_records returns, and anc None or T nasal coupling
+# areas. Returns (F, B) as (T x nfmt) float32 arrays. nthreads 0 takes one
+# thread per processor.
+def formants_batch(af, anc=None, nfmt=4, flo=90.0, fhi=5000.0, nthreads=0):
+    cdef np.ndarray[float, ndim=3, mode="c"] a = np.ascontiguousarray(af, dtype=np.float32)
+    cdef np.ndarray[float, ndim=1, mode="c"] n
+    cdef np.ndarray F, B
+    cdef ms.vt_config cf
+    cdef const float *ap = NULL
+    cdef float *Fp
+    cdef float *Bp
+    cdef long m = a.shape[0]
+    cdef int nf = nfmt, nt = nthreads
+    cdef float lo = flo, hi = fhi
+    cdef short r = 0
+    if a.shape[1] != ms.nph + ms.nbu or a.shape[2] != 2:
+        raise ValueError("af must be T x %d x 2" % (ms.nph + ms.nbu))
+    if nfmt < 1:
+        raise ValueError("nfmt must be positive")
+    if anc is not None:
+        n = np.ascontiguousarray(anc, dtype=np.float32).ravel()
+        if n.shape[0] != m:
+            raise ValueError("anc must have %d values" % m)
+        if m > 0:
+            ap = &n[0]
+    F = np.zeros((m, nfmt), dtype=np.float32)
+    B = np.zeros((m, nfmt), dtype=np.float32)
+    if m > 0:
+        ms.copy_vt_config(&cf)
+        Fp = <float *>F.data
+        Bp = <float *>B.data
+        with nogil:
+            r = ms.vtf_formants_batch(&cf, <ms.area_function *>a.data, ap,
+                                      m, lo, hi, nf, Fp, Bp, nt)
+    if r != 0:
+        raise RuntimeError("vtf_formants_batch failed")
+    return F, B
+
 def get_ivt():
     ivt = []
     for idx in np.arange(ms.NP):
@@ -81,6 +329,7 @@ def get_alph():
 def set_alph(alph):
     for idx in np.arange(ms.M4):
         ms.alph[idx] = alph[idx]
+    ms.lam_spec_changed()
     
 def get_beta():
     beta = []
@@ -91,6 +340,7 @@ def get_beta():
 def set_beta(beta):
     for idx in np.arange(ms.M4):
         ms.beta[idx] = beta[idx]
+    ms.lam_spec_changed()
     
 def get_u_wal():
     u_wal = []
@@ -101,57 +351,74 @@ def get_u_wal():
 def set_u_wal(u_wal):
     for idx in np.arange(ms.NVRS_WAL):
         ms.u_wal[idx] = u_wal[idx]
+    ms.lam_spec_changed()
 
 ###### End of C array access #####
 
 ###### End of C-style API #####
 
 cdef class Synth(object):
-    '''The synthesizer object.'''
+    '''The synthesizer object.
+
+    Each Synth has a voice of its own (see synth_framer in synthesize.c): its
+    rates, tract, source and interpolation are independent of the other Synth
+    objects and of synth_frame(), and synthesize() renders without the GIL, so
+    that Synth objects can render in as many threads.  A Synth is used by one
+    thread at a time.  alph, beta and u_wal are those of the articulatory
+    model, which all the voices share; change them when no voice renders.'''
     cdef public int _bufsize
+    cdef int _nsamp
+    cdef object _dtype
     cdef np.ndarray _buffer
+    cdef ms.synth_framer *_fr
     property rate:
         def __get__(self):
-            return ms.smpfrq
+            return self._fr.sv.vt.cf.smpfrq
+    property simrate:
+        def __get__(self):
+            return self._fr.sv.vt.cf.simfrq
+    property dtype:
+        def __get__(self):
+            return self._dtype
     property buffer:
         def __get__(self):
-            return self._buffer
+            return self._buffer[:self._nsamp]
     property ivt:
         def __get__(self):
-            return get_ivt()
+            return [{"x": x, "y": y} for x, y in self.ivt_view()]
     property ivt_x:
         def __get__(self):
-            return [ms.ivt[idx].x for idx in np.arange(ms.NP)]
+            return self.ivt_view()[:, 0]
     property ivt_y:
         def __get__(self):
-            return [ms.ivt[idx].y for idx in np.arange(ms.NP)]
+            return self.ivt_view()[:, 1]
     property evt:
         def __get__(self):
-            return get_evt()
+            return [{"x": x, "y": y} for x, y in self.evt_view()]
     property evt_x:
         def __get__(self):
-            return [ms.evt[idx].x for idx in np.arange(ms.NP)]
+            return self.evt_view()[:, 0]
     property evt_y:
         def __get__(self):
-            return [ms.evt[idx].y for idx in np.arange(ms.NP)]
+            return self.evt_view()[:, 1]
     property afvt:
         def __get__(self):
-            return get_afvt()
+            return [{"A": A, "x": x} for A, x in self.afvt_view()]
     property afvt_A:
         def __get__(self):
-            return [ms.afvt[idx].A for idx in np.arange(ms.nss)]
+            return self.afvt_view()[:, 0]
     property afvt_x:
         def __get__(self):
-            return [ms.afvt[idx].x for idx in np.arange(ms.nss)]
+            return self.afvt_view()[:, 1]
     property afnt:
         def __get__(self):
             return get_afnt()
     property afnt_A:
         def __get__(self):
-            return [ms.afnt[idx].A for idx in np.arange(13)]
+            return afnt_view()[:, 0]
     property afnt_x:
         def __get__(self):
-            return [ms.afnt[idx].x for idx in np.arange(13)]
+            return afnt_view()[:, 1]
     property alph:
         def __get__(self):
             return get_alph()
@@ -171,20 +438,297 @@ cdef class Synth(object):
             assert(len(vals) == len(get_u_wal()))
             set_u_wal(vals)
 
-    def __cinit__(self):
-        self._bufsize = np.floor(ms.FRAME_DUR * ms.smpfrq)
-        self._buffer = np.zeros(self._bufsize, dtype=np.int16)
+    # rate, simrate: output and simulation rates in Hz of this Synth (as for
+    # set_rates), or None for the current ones
+    # dtype: np.int16 (saturated) or np.float32 (1.0 = int16 full scale)
+    # samples in buffer
+    def __cinit__(self, rate=None, simrate=None, dtype=np.int16):
+        cdef ms.vt_config cf
+        self._fr = NULL
+        self._dtype = np.dtype(dtype)
+        assert(self._dtype in (np.int16, np.float32))
+        ms.copy_vt_config(&cf)
+        if rate is not None:
+            if simrate is None:
+                simrate = 3 * rate
+            if ms.vt_rates_r(&cf, rate, simrate) < 0:
+                raise ValueError("rates must be positive")
+        self._fr = <ms.synth_framer *> malloc(sizeof(ms.synth_framer))
+        if self._fr == NULL:
+            raise MemoryError()
+        if ms.synth_framer_ini(self._fr, &cf) != 0:
+            free(self._fr)
+            self._fr = NULL
+            raise MemoryError()
+        self._bufsize = ms.frame_length(cf.smpfrq)
+        self._buffer = np.zeros(self._bufsize, dtype=self._dtype)
+        self._nsamp = 0
         self.synthesize(FrameParam(), 1)  # Initialize
 
+    def __dealloc__(self):
+        if self._fr != NULL:
+            ms.synth_framer_term(self._fr)
+            free(self._fr)
+
+    # as set_interp(), for this Synth
+    def set_interp(self, kind, updates=1):
+        if ms.synth_framer_interp(self._fr, kind, updates) < 0:
+            raise ValueError("unknown kind or updates < 1")
+
+    # mode: 1 = initialize, 2 = next frame, > 2 = fade out for mode samples,
+    # as for synth_frame()
     def synthesize(self, params, mode):
-        #self._buffer = np.zeros(self._bufsize * mode, dtype=np.int16)
-        synth_frame(params.as_ndarray(), self._buffer, mode)
+        cdef np.ndarray[float, ndim=1, mode="c"] p = params.as_ndarray()
+        cdef float *pp = &p[0]
+        cdef void *buf
+        cdef short m = mode, n
+        if mode > self._bufsize:
+            self._buffer = np.zeros(mode, dtype=self._dtype)
+            self._bufsize = mode
+        if mode == 1:
+            ms.lam_setup()      # the model, if its spec changed
+        buf = self._buffer.data
+        if self._dtype == np.float32:
+            with nogil:
+                n = ms.synth_framer_frame_f(self._fr, pp, <float *>buf, m)
+        else:
+            with nogil:
+                n = ms.synth_framer_frame(self._fr, pp, <short *>buf, m)
+        if n < 0:
+            raise MemoryError()
+        self._nsamp = n
+
+    # read-only (n x 2) float32 views of the profiles and area function of the
+    # last frame of this Synth, as ivt_view() etc.; they keep the Synth alive
+    def ivt_view(self):
+        return _view(&self._fr.sv.prof.ivt[0], self._fr.sv.prof.np, self)
+
+    def evt_view(self):
+        return _view(&self._fr.sv.prof.evt[0], self._fr.sv.prof.np, self)
+
+    def afvt_view(self):
+        return _view(self._fr.sv.afvt, self._fr.sv.vt.cf.nss, self)
 
     def time_for_frameidx(self, idx):
         '''Calculate value of time from a frame index.'''
         return (idx * ms.FRAME_DUR) * 1000
 
-        
+
+
+cdef class RealtimeSynth(object):
+    '''A voice rendered in real time (see synth_rt in synthesize.c).
+
+    Frames are posted from any one thread and the voice takes the latest one
+    at the start of each 5 ms frame. render() fills an audio block, e.g. from
+    the callback of an audio stream; start() runs the render loop on a native
+    thread into a raw file, or a null sink if path is None.'''
+    cdef ms.synth_rt *_rt
+    cdef FILE *_out
+
+    # capacity: frames which can be posted ahead of the renderer
+    def __cinit__(self, capacity=16):
+        cdef ms.vt_config cf
+        ms.copy_vt_config(&cf)
+        self._out = NULL
+        self._rt = <ms.synth_rt *> malloc(sizeof(ms.synth_rt))
+        if self._rt == NULL:
+            raise MemoryError()
+        if ms.synth_rt_ini(self._rt, &cf, capacity) != 0:
+            free(self._rt)
+            self._rt = NULL
+            raise MemoryError()
+
+    def __dealloc__(self):
+        if self._rt != NULL:
+            ms.synth_rt_term(self._rt)
+            free(self._rt)
+        if self._out != NULL:
+            fclose(self._out)
+
+    property rendered:
+        def __get__(self):
+            return self._rt.rendered
+    property late:
+        def __get__(self):
+            return self._rt.late
+
+    # Returns True, or False if the queue is full.
+    def post(self, params):
+        cdef np.ndarray[float, ndim=1, mode="c"] a = params.as_ndarray()
+        return ms.synth_rt_post(self._rt, &a[0]) == 0
+
+    # The next n samples, np.float32 (1.0 = int16 full scale) or np.int16.
+    # RuntimeError while the loop of start() is running.
+    def render(self, n, dtype=np.float32):
+        cdef np.ndarray[float, ndim=1, mode="c"] f
+        cdef np.ndarray[short, ndim=1, mode="c"] i
+        cdef long m = n, r
+        cdef void *buf
+        if np.dtype(dtype) == np.int16:
+            i = np.zeros(n, dtype=np.int16)
+            buf = i.data
+            with nogil:
+                r = ms.synth_rt_render(self._rt, <short *>buf, m)
+            out = i
+        else:
+            f = np.zeros(n, dtype=np.float32)
+            buf = f.data
+            with nogil:
+                r = ms.synth_rt_render_f(self._rt, <float *>buf, m)
+            out = f
+        if r < 0:
+            raise RuntimeError("the render loop of start() is running")
+        return out
+
+    # path: raw int16 output file, or None; paced: a block per block duration
+    def start(self, path=None, block=256, paced=True):
+        cdef bytes bpath
+        if path is not None:
+            bpath = path.encode()
+            self._out = fopen(bpath, "wb")
+            if self._out == NULL:
+                raise IOError("can not open " + path)
+        if ms.synth_rt_start(self._rt, self._out, ms.OUT_S16, block, 1 if paced else 0) != 0:
+            if self._out != NULL:
+                fclose(self._out)
+                self._out = NULL
+            raise RuntimeError("the render loop is running or could not start")
+
+    def stop(self):
+        ms.synth_rt_stop(self._rt)
+        if self._out != NULL:
+            fclose(self._out)
+            self._out = NULL
+
+
+cdef class Inverter(object):
+    '''Acoustic-to-articulatory inversion (see invert.h).
+
+    A codebook of random articulations and their formants, computed by the
+    forward model with the current tract configuration, is built once (build)
+    or loaded (load), and indexed by a k-d tree over the log formants. track()
+    then gives the AMnum articulatory parameters of each frame of a formant
+    track: an entry per frame chosen among the k nearest so that the
+    articulation moves little between frames, refined on the forward model,
+    the frames being shared by native threads.'''
+    cdef ms.inv_codebook _ib
+
+    def __cinit__(self):
+        self._ib.size = 0
+        self._ib.para = NULL
+        self._ib.key = NULL
+        self._ib.dim = NULL
+
+    def __dealloc__(self):
+        ms.inv_term(&self._ib)
+
+    property size:
+        def __get__(self):
+            return self._ib.size
+    property nfmt:
+        def __get__(self):
+            return self._ib.nfmt
+
+    # npoints articulations drawn between lo and hi (scalars or AMnum
+    # values), of which those with nfmt formants from flo to fhi Hz are kept.
+    # The same seed gives the same codebook. nthreads 0 takes one thread per
+    # processor.
+    def build(self, npoints=20000, seed=1, lo=-3.0, hi=3.0, nfmt=4,
+              flo=90.0, fhi=5000.0, nthreads=0):
+        cdef np.ndarray[float, ndim=1, mode="c"] l = np.ascontiguousarray(np.broadcast_to(lo, (ms.IV_NPAR,)), dtype=np.float32)
+        cdef np.ndarray[float, ndim=1, mode="c"] h = np.ascontiguousarray(np.broadcast_to(hi, (ms.IV_NPAR,)), dtype=np.float32)
+        cdef ms.vt_config cf
+        cdef long n = npoints
+        cdef unsigned long s = seed
+        cdef int nf = nfmt, nt = nthreads
+        cdef float fl = flo, fh = fhi
+        cdef short r
+        ms.inv_term(&self._ib)
+        ms.copy_vt_config(&cf)
+        with nogil:
+            r = ms.inv_build(&self._ib, &cf, n, s, &l[0], &h[0], nf, fl, fh, nt)
+        if r != 0:
+            raise RuntimeError(ms.inv_error(r).decode())
+
+    def save(self, path):
+        cdef bytes bpath = path.encode()
+        cdef short r = ms.inv_write(&self._ib, bpath)
+        if r != 0:
+            raise IOError("%s: %s" % (path, ms.inv_error(r).decode()))
+
+    def load(self, path):
+        cdef bytes bpath = path.encode()
+        cdef short r
+        ms.inv_term(&self._ib)
+        r = ms.inv_read(&self._ib, bpath)
+        if r == ms.IV_EFILE:
+            raise IOError("%s: %s" % (path, ms.inv_error(r).decode()))
+        if r != 0:
+            raise ValueError("%s: %s" % (path, ms.inv_error(r).decode()))
+
+    # The articulatory parameters of the entries, a (size x AMnum) array.
+    def entries(self):
+        if self._ib.size == 0:
+            return np.zeros((0, ms.IV_NPAR), dtype=np.float32)
+        return np.array(<float[:self._ib.size, :ms.IV_NPAR]> self._ib.para)
+
+    # The k entries nearest to the nfmt formants F (Hz), nearest first:
+    # (indices into entries(), distances between the log formants).
+    def nearest(self, F, k=8):
+        cdef np.ndarray[float, ndim=1, mode="c"] f = np.ascontiguousarray(F, dtype=np.float32).ravel()
+        cdef np.ndarray[long, ndim=1, mode="c"] idx = np.zeros(k, dtype=np.int_)
+        cdef np.ndarray[float, ndim=1, mode="c"] dist = np.zeros(k, dtype=np.float32)
+        cdef long n
+        if f.shape[0] != self._ib.nfmt or self._ib.size == 0:
+            raise ValueError("F must have the %d formants of a codebook" % self._ib.nfmt)
+        n = ms.inv_nearest(&self._ib, &f[0], k, &idx[0], &dist[0])
+        if n < 0:
+            raise ValueError("k or a formant not valid")
+        return idx[:n], dist[:n]
+
+    # The parameters of the frames of F, a (T x nfmt) array of formants (Hz):
+    # (para, err), a (T x AMnum) float32 array and the T rms relative formant
+    # errors. A frame with a formant <= 0 is not inverted (para 0, err -1).
+    # k: entries per frame; smooth: weight of the articulatory distance
+    # between frames; reg: weight of the distance from the entry; iter:
+    # refinement steps; sigma: relative formant error of unit cost. Raises
+    # ValueError if the codebook was built with another tract or model.
+    def track(self, F, k=16, smooth=1.0, reg=0.05, iter=4, sigma=0.05,
+              nthreads=0):
+        cdef np.ndarray[float, ndim=2, mode="c"] f = np.ascontiguousarray(F, dtype=np.float32)
+        cdef np.ndarray para, err
+        cdef ms.vt_config cf
+        cdef ms.inv_options op
+        cdef long T = f.shape[0]
+        cdef int nt = nthreads
+        cdef float *pp
+        cdef float *ep
+        cdef short r = 0
+        if f.shape[1] != self._ib.nfmt:
+            raise ValueError("F must be T x %d" % self._ib.nfmt)
+        ms.inv_options_default(&op)
+        op.k = k
+        op.smooth = smooth
+        op.reg = reg
+        op.iter = iter
+        op.sigma = sigma
+        para = np.zeros((T, ms.IV_NPAR), dtype=np.float32)
+        err = np.zeros(T, dtype=np.float32)
+        if T > 0:
+            ms.copy_vt_config(&cf)
+            pp = <float *>para.data
+            ep = <float *>err.data
+            with nogil:
+                r = ms.inv_track(&self._ib, &cf, &op, &f[0, 0], T, pp, ep, nt)
+        if r == ms.IV_EARG:
+            raise ValueError("options not valid, or the codebook was built "
+                             "with another tract (%d+%d sections, %g/%g Hz) "
+                             "or model" % (self._ib.nph, self._ib.nbu,
+                                           self._ib.smpfrq, self._ib.simfrq))
+        if r != 0:
+            raise RuntimeError(ms.inv_error(r).decode())
+        return para, err
+
 # You can override one or more defaults identified by name, e.g.
 #
 # my_uw = FrameParam('uw', lip_aperture=1.2)
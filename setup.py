@@ -9,7 +9,7 @@ ext_modules = [
   Extension(
     name="maedasyn.synth",
     sources=["maedasyn/synth.pyx"],
-    libraries = ["m"],
+    libraries = ["m", "pthread"],
     include_dirs=[numpy.get_include()],
     language="c",
   )
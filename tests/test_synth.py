@@ -0,0 +1,162 @@
+"""
+Smoke tests of the maedasyn.synth wrapper: the views of the C arrays, the
+utterance and frame renderers against each other, and Synth objects rendering
+in threads.
+
+Build the extension in place, then run from the package's root directory:
+
+  python setup.py build_ext --inplace
+  python -m unittest discover -s tests
+"""
+
+import gc
+import threading
+import unittest
+
+import numpy as np
+
+import maedasyn.synth as ms
+
+
+# A steady frame: a vowel at a constant f0, with the glottal aperture (0.2)
+# which synth_frame assumes at the start of each frame.
+def steady_frame(vowel='iy', f0=120.0):
+    f = ms.FrameParam(vowel)
+    f.f0 = f0
+    f.glottal_aperture = 0.2
+    return f
+
+
+# T frames of f, 5 ms apart, as a (T x 11) array.
+def frame_track(f, T):
+    p = np.array([f.as_ndarray() for t in range(T)], dtype=np.float32)
+    p[:, 0] = np.arange(T) * 5.0
+    return p
+
+
+# The frames of p rendered by synth_frame, after initializing on the first.
+def render_frames(p):
+    buff = np.zeros(ms.frame_length(), dtype=np.int16)
+    out = []
+    ms.synth_frame(np.ascontiguousarray(p[0]), buff, 1)
+    for row in p:
+        n = ms.synth_frame(np.ascontiguousarray(row), buff, 2)
+        out.append(buff[:n].copy())
+    return np.concatenate(out)
+
+
+# The frames of f rendered by a Synth of its own.
+def render_synth(f, T):
+    sy = ms.Synth()
+    sy.synthesize(f, 1)
+    out = []
+    for t in range(T):
+        sy.synthesize(f, 2)
+        out.append(sy.buffer.copy())
+    return np.concatenate(out)
+
+
+class ViewTest(unittest.TestCase):
+
+    def test_synth_views_keep_synth_alive(self):
+        sy = ms.Synth()
+        sy.synthesize(steady_frame(), 2)
+        views = (sy.ivt_view(), sy.evt_view(), sy.afvt_view())
+        copies = [v.copy() for v in views]
+        del sy
+        gc.collect()
+        ms.Synth().synthesize(steady_frame('uw'), 2)  # reuse freed memory
+        for v, c in zip(views, copies):
+            self.assertFalse(v.flags.writeable)
+            self.assertIsInstance(v.base, ms.Synth)
+            np.testing.assert_array_equal(v, c)
+
+    def test_module_views_follow_synth_frame(self):
+        buff = np.zeros(ms.frame_length(), dtype=np.int16)
+        p = steady_frame('iy').as_ndarray()
+        ms.synth_frame(p, buff, 1)
+        ms.synth_frame(p, buff, 2)
+        af = ms.afvt_view()
+        iy = af.copy()
+        self.assertFalse(af.flags.writeable)
+        self.assertEqual(af.shape[1], 2)
+        p = steady_frame('uw').as_ndarray()
+        ms.synth_frame(p, buff, 2)
+        self.assertFalse(np.array_equal(af, iy))  # same memory, new tract
+        np.testing.assert_array_equal(af, ms.afvt_view())
+
+    def test_frame_records(self):
+        p = frame_track(steady_frame(), 3)
+        prof, af = ms.frame_records(p, nsec=20)
+        self.assertEqual(prof.shape, (3,))
+        self.assertEqual(af.shape, (3, 20, 2))
+        self.assertTrue((prof['np'] > 0).all())
+        self.assertTrue((af[:, :, 0] > 0).all())
+
+
+class RenderTest(unittest.TestCase):
+
+    def test_utterance_against_synth_frame(self):
+        T = 40
+        p = frame_track(steady_frame(), T)
+        rate = ms.get_rates()[0]
+        n = int(p[-1, 0] / 1000 * rate)  # before the transition
+        wave = ms.synthesize_utterance(p)
+        frames = render_frames(p)
+        self.assertGreaterEqual(len(wave), n + int(0.06 * rate) - 1)
+        self.assertGreater(np.abs(wave[:n]).max(), 0)
+        np.testing.assert_array_equal(wave[:n], frames[:n])
+
+    def test_utterance_float32(self):
+        p = frame_track(steady_frame(), 20)
+        s16 = ms.synthesize_utterance(p)
+        f32 = ms.synthesize_utterance(p, dtype=np.float32)
+        self.assertEqual(f32.dtype, np.float32)
+        self.assertEqual(len(f32), len(s16))
+        np.testing.assert_allclose(f32 * 32767, s16, atol=1.5)
+
+    def test_synth_frame_params(self):
+        buff = np.zeros(ms.frame_length(), dtype=np.int16)
+        p = steady_frame().as_ndarray()
+        ms.synth_frame(p[:ms.NPAR].copy(), buff, 1)  # a frame of NPAR values
+        with self.assertRaises(ValueError):
+            ms.synth_frame(p[:ms.NPAR - 1].copy(), buff, 2)
+
+    def test_synth_against_synth_frame(self):
+        T = 20
+        f = steady_frame()
+        np.testing.assert_array_equal(render_synth(f, T),
+                                      render_frames(frame_track(f, T)))
+
+    def test_realtime_render_while_running(self):
+        rt = ms.RealtimeSynth()
+        rt.post(steady_frame())
+        rt.start(paced=False)
+        try:
+            with self.assertRaises(RuntimeError):
+                rt.render(256)
+        finally:
+            rt.stop()
+        self.assertEqual(len(rt.render(256, dtype=np.int16)), 256)
+
+    def test_synths_in_threads(self):
+        T = 400  # 2 s of sound, so that the threads overlap
+        frames = (steady_frame('iy', 110.0), steady_frame('uw', 140.0))
+        serial = [render_synth(f, T) for f in frames]
+        out = [None, None]
+
+        def run(i):
+            out[i] = render_synth(frames[i], T)
+
+        threads = [threading.Thread(target=run, args=(i,)) for i in range(2)]
+        for th in threads:
+            th.start()
+        for th in threads:
+            th.join()
+        for i in range(2):
+            np.testing.assert_array_equal(out[i], serial[i])
+        self.assertFalse(np.array_equal(serial[0], serial[1]))
+
+
+if __name__ == '__main__':
+    unittest.main()